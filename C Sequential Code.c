@@ -1,5 +1,6 @@
 %%writefile monopoly.c
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
@@ -7,6 +8,16 @@
 #include <limits.h>
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h> // AVX2 kernel of the batched environment, selected at run time
+#define ENV_BATCH_HAVE_AVX2 1
+#endif
 
 // --- Constants ---
 #define BOARD_SIZE 40
@@ -15,41 +26,193 @@
 #define MAX_NAME_LEN 64
 #define MAX_DESC_LEN 256
 #define MAX_DECK_SIZE 16
-#define Q_TABLE_INITIAL_SIZE 1024
-#define VISITED_SET_INITIAL_SIZE 256
+#define NUM_CARD_DECKS 2                 // Chance and Community Chest, see CardDeckKind
+#define DICE_OUTCOMES 36                 // Two-dice rolls, one random word each (see dice_outcome)
+#define DICE_PASSES_GO 1                 // DiceTransition.flags: the move collects the GO reward
+#define DICE_DOUBLES 2                   // DiceTransition.flags: both dice show the same face
+#define Q_MONEY_BINS 160                 // money_bin saturates into [0, Q_MONEY_BINS - 1]
+#define Q_OWNER_SLOTS (MAX_PLAYERS + 1)  // current_prop_owner in [-1, MAX_PLAYERS)
+#define Q_NUM_STATES (BOARD_SIZE * Q_MONEY_BINS * Q_OWNER_SLOTS * 2)
+#define CQ_SHARD_BITS 6                       // Concurrent Q-table: 2^6 independently locked shards
+#define CQ_NUM_SHARDS (1 << CQ_SHARD_BITS)
+#define CQ_SHARD_INITIAL_CAPACITY 64          // Open-addressed slots per shard (power of two), doubled at 70% load
 #define MAX_EPISODE_STEPS 500
+#define CHECKPOINT_MAGIC "MCQTCKP"            // 8 bytes with the terminator
+#define CHECKPOINT_VERSION 3                  // 2: QValueData carries sum_sq_returns, 3: header records the rank's slice
+#define CHECKPOINT_HEADER_BYTES 4096          // Entries start page-aligned so they can be mmap'd in place
+#define CHECKPOINT_DEFAULT_EVERY 10000        // Episodes between checkpoints unless --checkpoint-every=N
+#define BENCHMARK_SEED 20240601ull            // --benchmark workload seed unless --seed=N is given
+#define ANALYTICS_DEFAULT_WINDOW 1000         // Episodes per analytics row unless --analytics-window=N
+#define ANALYTICS_DEFAULT_FILE "monopoly_analytics_seq.csv" // --analyze-log output unless --analytics=FILE
 #define LOG_BUFFER_SIZE 1000
+#define MAX_LOG_ENTRIES 1000
+#define MAX_WORKER_THREADS 64
+#define PARALLEL_EPISODES_PER_ROUND 64 // Episodes each worker plays between Q-table merges
+#define EVAL_EPISODES_PER_ROUND 1024   // Episodes each evaluation worker plays between stopping checks
+#define EVAL_DEFAULT_CI_WIDTH 0.02     // --evaluate stops once the win-rate interval is this narrow
+#define EVAL_DEFAULT_MAX_EPISODES 1000000 // ... or after this many episodes per opponent
+#define EVAL_Z 1.959964                // Normal quantile of the 95% Wilson interval
+#define CONVERGENCE_Z 1.959964         // Normal quantile of the 95% buy-vs-pass test of q_table_convergence
+#define ENV_BATCH_LANES 16             // Games a MonopolyEnvBatch steps per call (two 8-lane AVX2 vectors)
+#define ENV_BATCH_STEP_DRAWS 8         // Random words prepared per lane and step (two Philox blocks; a step uses at most 5)
+#define PHILOX_M0 0xD2511F53u                  // Philox4x32 round multipliers
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u                  // Philox4x32 key schedule (Weyl) increments
+#define PHILOX_W1 0xBB67AE85u
+
+// Game rules shared by every engine (see the Rules Core)
+#define MAX_HOUSES 5                     // 4 houses + 1 hotel
+#define JAIL_FEE 50                      // Paid to leave jail at the turn limit
+#define PURCHASE_REWARD 100              // Reward bonus for buying a property
+#define BANKRUPTCY_PENALTY 1000          // Reward penalty of the player who goes bankrupt
 
 // --- Structures ---
 
-// Forward declaration
-struct MonopolyEnv;
-
-// Result structure for card effects
+// Card decks, also the first index of MonopolyEnv.decks
+typedef enum {
+    CARD_DECK_CHANCE = 0,
+    CARD_DECK_CHEST = 1
+} CardDeckKind;
+
+// What a card does. Cards are data: apply_card_effect interprets them for every engine.
+typedef enum {
+    CARD_OP_MONEY = 0,   // Collect amount from the bank (negative pays it)
+    CARD_OP_ADVANCE = 1, // Move forward to square target, collecting the GO reward when passing GO
+    CARD_OP_MOVE = 2,    // Move amount squares (negative moves back), collecting the GO reward on a forward wrap
+    CARD_OP_JAIL = 3     // Go directly to jail
+} CardOp;
+
+// Declarative card effect (4 bytes, so the AVX2 kernel gathers a card as one int)
 typedef struct {
-    double reward;
-    char card_specific_desc[MAX_DESC_LEN];
-} CardEffectResult;
-
-// Function pointer type for card effects
-typedef CardEffectResult (*CardEffectFunc)(struct MonopolyEnv* env, int player_index);
+    unsigned char op;     // CardOp
+    unsigned char target; // Destination square of CARD_OP_ADVANCE
+    short amount;         // Dollars for CARD_OP_MONEY, squares for CARD_OP_MOVE
+} CardEffect;
 
 // Card structure
 typedef struct {
     char name[MAX_NAME_LEN];
-    CardEffectFunc effect;
+    char desc[MAX_DESC_LEN]; // Printed card text
+    CardEffect effect;
 } Card;
 
+// What a square does when a move ends on it (properties are told apart by their price)
+typedef enum { SQUARE_PLAIN, SQUARE_TAX, SQUARE_CHANCE, SQUARE_CHEST, SQUARE_GO_TO_JAIL } SquareClass;
+
+// One precomputed roll: where outcome 6 * (die1 - 1) + (die2 - 1) takes a player standing on a square.
+// Four bytes, so the AVX2 kernel gathers an entry as one int.
+typedef struct {
+    unsigned char landing;    // Square the move ends on
+    unsigned char square;     // SquareClass of the landing square
+    unsigned char dice_total; // 2 .. 12, as logged
+    unsigned char flags;      // DICE_PASSES_GO | DICE_DOUBLES
+} DiceTransition;
+
 // Property structure
 typedef struct {
     int price;
     int rent;
     char name[MAX_NAME_LEN];
-    int owner; // Player index, -1 for unowned/bank
-    int houses;
     int house_cost; // Needed for bankruptcy selling logic
 } Property;
 
+// Flat tables of one configuration (board, decks and rules) read by the rules core, built from a
+// MonopolyEnv's properties, decks and configuration by build_board_tables
+typedef struct {
+    int num_players;
+    int go_reward;
+    int board_size;
+    int jail_position;
+    int go_to_jail_position;
+    int jail_turns;
+    int price[BOARD_SIZE];
+    int rent[BOARD_SIZE];
+    int house_cost[BOARD_SIZE];
+    int fee[BOARD_SIZE];                                   // Tax due on each square
+    unsigned char square_class[BOARD_SIZE];                // SquareClass of each square
+    int deck[BOARD_SIZE];                                  // 0 = no card, else 1 + the CardDeckKind drawn from
+    int deck_size[NUM_CARD_DECKS + 1];                     // Cards per deck (entry 0 is 1 so masked SIMD lanes index card 0)
+    CardEffect cards[NUM_CARD_DECKS + 1][MAX_DECK_SIZE];   // [deck][card], MonopolyEnv.decks shifted by one
+    DiceTransition transitions[BOARD_SIZE][DICE_OUTCOMES]; // [square][roll]
+} BoardTables;
+
+// One game's mutable state as the rules core reads and writes it. Player entries are at [player * stride]
+// and square entries at [square * stride]: stride 1 for a MonopolyEnv, ENV_BATCH_LANES for a batch lane.
+typedef struct {
+    int* positions;
+    int* money;
+    int* in_jail;
+    int* jail_counters;
+    int* owner;  // Player index, -1 for unowned/bank
+    int* houses;
+    int stride;
+} GameState;
+
+// Counter-based random stream (Philox4x32-10). The key is the run seed and the counter is
+// (episode, step, block, 0), so every draw is a pure function of where it happens in training.
+typedef struct {
+    unsigned int key[2];
+    unsigned int episode;
+    unsigned int step;
+    unsigned int block;       // Next counter block within the current step
+    unsigned int buffer[4];   // Unused words of the last generated block
+    int available;
+} PhiloxStream;
+
+// Where the rules core takes a step's random words from: a MonopolyEnv's stream, or the words a batch
+// lane prepared for the step (words[k * ENV_BATCH_LANES] is its draw k, *cursor the next one to use)
+typedef struct {
+    PhiloxStream* stream; // NULL for a batch lane
+    const unsigned int* words;
+    int* cursor;
+} StepDraws;
+
+// Event flags packed into StepRecord.events
+#define STEP_EVT_PASSED_GO      (1u << 0)
+#define STEP_EVT_BOUGHT         (1u << 1)
+#define STEP_EVT_DECLINED       (1u << 2)  // could afford an unowned property and passed
+#define STEP_EVT_CANT_AFFORD    (1u << 3)  // landed on an unowned property it could not afford
+#define STEP_EVT_PAID_RENT      (1u << 4)
+#define STEP_EVT_CHANCE         (1u << 5)  // card holds the Chance deck index
+#define STEP_EVT_CHEST          (1u << 6)  // card holds the Community Chest deck index
+#define STEP_EVT_OWN_SQUARE     (1u << 7)  // landed on an own property
+#define STEP_EVT_HOUSE          (1u << 8)  // ... and bought a house on it
+#define STEP_EVT_HOUSE_DECLINED (1u << 9)  // ... and passed on a house it could have bought
+#define STEP_EVT_TAX            (1u << 10) // paid a fee square
+#define STEP_EVT_JAIL_DOUBLES   (1u << 11) // rolled doubles to leave jail
+#define STEP_EVT_JAIL_FEE       (1u << 12) // paid the fee to leave jail (turn limit)
+#define STEP_EVT_JAIL_STAY      (1u << 13) // stayed in jail, no move this step
+#define STEP_EVT_SENT_JAIL      (1u << 14) // sent to jail by the Go To Jail square
+#define STEP_EVT_DEBT           (1u << 15) // balance was negative after the turn's actions
+#define STEP_EVT_BANKRUPT       (1u << 16) // ... and selling assets did not cover it: the game is over
+#define STEP_EVT_IN_JAIL        (1u << 17) // in jail after the step
+
+// What one turn did, as the rules core reports it (48 bytes instead of a ~900 byte LogEntry).
+// decode_step_record rebuilds the LogEntry, text included, from it and the env's board and decks.
+typedef struct {
+    unsigned int events;          // STEP_EVT_* flags
+    unsigned short step;          // Steps taken, this one included
+    short fee_paid;               // Jail fee, tax and rent paid this step
+    unsigned short house_sale;    // Money raised selling houses in a bankruptcy
+    signed char card;             // Index into the drawn deck, -1 if no card
+    signed char payee;            // Player the rent went to, -1 if none
+    unsigned char player;
+    unsigned char position_before;
+    unsigned char dice;           // Dice total of the move, 0 on a turn spent in jail
+    unsigned char landed_on;      // Square the dice took the player to
+    unsigned char position_after;
+    unsigned char jail_roll;      // Dice total of the roll made in jail, 0 if not in jail
+    unsigned char jail_turn;      // Jail turn that roll was made on
+    unsigned char action;         // 0 = Pass, 1 = Buy
+    unsigned char num_owned;      // Properties owned by the player after the step
+    unsigned char houses;         // Houses on the landed property (rent paid or own square), else 0
+    unsigned char houses_sold;    // Houses sold in a bankruptcy
+    int money_before;
+    int money_delta;              // money_after - money_before
+    int reward;
+    unsigned long long sold_squares; // Properties sold back to the bank in a bankruptcy
+} StepRecord;
+
 // Log entry structure (mimics Python dictionary)
 typedef struct {
     int step;
@@ -87,22 +250,29 @@ typedef struct MonopolyEnv {
     // Game State
     int positions[MAX_PLAYERS];
     int money[MAX_PLAYERS];
-    bool in_jail[MAX_PLAYERS];
+    int in_jail[MAX_PLAYERS];
     int jail_counters[MAX_PLAYERS];
     Property properties[MAX_PROPERTIES];
+    int owner[BOARD_SIZE]; // Player index, -1 for unowned/bank
+    int houses[BOARD_SIZE];
     int current_player;
     int steps_taken;
+    int properties_bought; // Properties bought this episode (for the training analytics)
     bool done;
 
-    // Decks
-    Card chance_deck[MAX_DECK_SIZE];
-    int chance_deck_size;
-    Card chest_deck[MAX_DECK_SIZE];
-    int chest_deck_size;
+    // Decks, indexed by CardDeckKind (see initialize_decks)
+    Card decks[NUM_CARD_DECKS][MAX_DECK_SIZE];
+    int deck_sizes[NUM_CARD_DECKS];
+
+    // Board tables for the configuration above (see build_board_tables)
+    BoardTables board;
 
     // Observation space bounds
     int obs_money_high;
 
+    // Per-environment counter-based random stream (see PhiloxStream)
+    PhiloxStream rng;
+
     // Log entry for the last step
     LogEntry last_log;
 
@@ -119,13 +289,68 @@ typedef struct {
 
 // --- Helper Functions ---
 
-// Forward declarations for card effects
-static CardEffectResult card_advance_to_go(MonopolyEnv* env, int player);
-static CardEffectResult card_go_to_jail(MonopolyEnv* env, int player);
-static CardEffectResult card_bank_dividend(MonopolyEnv* env, int player);
-static CardEffectResult card_pay_poor_tax(MonopolyEnv* env, int player);
-static CardEffectResult card_doctors_fee(MonopolyEnv* env, int player);
-static CardEffectResult card_tax_refund(MonopolyEnv* env, int player);
+// One Philox4x32-10 block: 10 rounds of the Random123 round function
+static inline void philox4x32_10(const unsigned int ctr[4], unsigned int k0, unsigned int k1, unsigned int out[4]) {
+    unsigned int c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    for (int round = 0; round < 10; ++round) {
+        unsigned long long p0 = (unsigned long long)PHILOX_M0 * c0;
+        unsigned long long p1 = (unsigned long long)PHILOX_M1 * c2;
+        c0 = (unsigned int)(p1 >> 32) ^ c1 ^ k0;
+        c2 = (unsigned int)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (unsigned int)p1;
+        c3 = (unsigned int)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+// Key a stream with the 64-bit run seed (counter starts at episode 0, step 0)
+static inline void philox_stream_init(PhiloxStream* s, unsigned long long seed) {
+    s->key[0] = (unsigned int)seed;
+    s->key[1] = (unsigned int)(seed >> 32);
+    s->episode = 0;
+    s->step = 0;
+    s->block = 0;
+    s->available = 0;
+}
+
+// Position the stream at the first draw of (episode, step)
+static inline void philox_stream_seek(PhiloxStream* s, int episode, int step) {
+    s->episode = (unsigned int)episode;
+    s->step = (unsigned int)step;
+    s->block = 0;
+    s->available = 0;
+}
+
+// Next 32-bit draw of the stream
+static inline unsigned int philox_stream_next(PhiloxStream* s) {
+    if (s->available == 0) {
+        unsigned int ctr[4] = {s->episode, s->step, s->block++, 0u};
+        philox4x32_10(ctr, s->key[0], s->key[1], s->buffer);
+        s->available = 4;
+    }
+    int i = 4 - s->available--;
+    return i == 0 ? s->buffer[0] : i == 1 ? s->buffer[1] : i == 2 ? s->buffer[2] : s->buffer[3];
+}
+
+// Uniform double in [0, 1) from one draw
+static inline double philox_stream_uniform(PhiloxStream* s) {
+    return philox_stream_next(s) * (1.0 / 4294967296.0);
+}
+
+// Next value of the environment's random stream in [0, 2^31)
+static int env_rand(MonopolyEnv* env) {
+    return (int)(philox_stream_next(&env->rng) >> 1);
+}
+
+// One of the DICE_OUTCOMES two-dice rolls from a single 32-bit draw (multiply-shift instead of two modulos)
+static inline int dice_outcome(unsigned int word) {
+    return (int)(((unsigned long long)word * DICE_OUTCOMES) >> 32);
+}
 
 // Helper to check if a position requires paying a fee
 static int get_fee_for_position(int position) {
@@ -146,66 +371,242 @@ static bool is_chest_position(int position) {
     return position == 2 || position == 17 || position == 33;
 }
 
-// Helper function to adjust money and create part of the log description
-static CardEffectResult adjust_money(MonopolyEnv* env, int player, int amount) {
-    env->money[player] += amount;
-    CardEffectResult result;
-    result.reward = (double)amount; // Reward is the direct change
-    snprintf(result.card_specific_desc, MAX_DESC_LEN, "Adjusted money by %d.", amount);
-    return result;
-}
 
-// Helper: Advance player to GO
-static CardEffectResult advance_to_go(MonopolyEnv* env, int player) {
-    CardEffectResult result = {0.0, ""};
-    bool passed_go = env->positions[player] != 0; // Collect if not already at GO
-    env->positions[player] = 0;
-    strncat(result.card_specific_desc, "Advanced to GO.", MAX_DESC_LEN - strlen(result.card_specific_desc) - 1);
+// --- Rules Core ---
+// One implementation of a turn, shared by the logged step_monopoly_env, the logging-free
+// step_monopoly_env_fast and the portable batch lane. It reads only BoardTables and a GameState, and
+// reports what it did in a StepRecord. The AVX2 batch kernel mirrors play_turn on the same tables and
+// constants and settles debts with settle_debt.
 
-    if (passed_go) {
-        env->money[player] += env->go_reward;
-        result.reward += env->go_reward;
-        char go_desc[64];
-        snprintf(go_desc, sizeof(go_desc), " Collected $%d.", env->go_reward);
-        strncat(result.card_specific_desc, go_desc, MAX_DESC_LEN - strlen(result.card_specific_desc) - 1);
-    }
-    return result;
+// Rent multiplier by house count (MAX_HOUSES = hotel)
+static const int rent_multipliers[MAX_HOUSES + 1] = {1, 5, 15, 45, 80, 125};
+
+// Rent due on a property with the given number of houses
+static inline int rent_for_houses(int base_rent, int houses) {
+    return base_rent * rent_multipliers[houses < MAX_HOUSES ? houses : MAX_HOUSES];
 }
 
-// Helper: Send player to Jail
-static CardEffectResult go_to_jail(MonopolyEnv* env, int player) {
-    CardEffectResult result = {0.0, ""}; // No immediate reward/penalty unless desired
-    env->positions[player] = env->jail_position;
-    env->in_jail[player] = true;
-    env->jail_counters[player] = 0; // Reset jail turn counter
-    snprintf(result.card_specific_desc, MAX_DESC_LEN, "Moved to Jail (Position %d).", env->jail_position);
-    return result;
+// Liquidation values: houses sell for half their cost, properties for half their price
+static inline int house_sale_value(int house_cost, int houses) {
+    return houses * (house_cost / 2);
+}
+
+static inline int property_sale_value(int price) {
+    return price / 2;
 }
 
+// Deck drawn from on a square of the given SquareClass: CARD_DECK_CHANCE, CARD_DECK_CHEST, or -1 if none
+static inline int card_deck_of(int square) {
+    return square == SQUARE_CHANCE ? CARD_DECK_CHANCE : square == SQUARE_CHEST ? CARD_DECK_CHEST : -1;
+}
 
-// --- Card Effect Implementations ---
-static CardEffectResult card_advance_to_go(MonopolyEnv* env, int player) {
-    return advance_to_go(env, player);
+// Apply a card to a player on `position`: adds its money to *cash, sets *jailed and returns the square the
+// player ends on. Selects instead of a switch, mirrored lane-wise by env_batch_step_avx2.
+// Assumes |amount| < board_size for CARD_OP_MOVE.
+static inline int apply_card_effect(CardEffect card, int position, int* cash, bool* jailed,
+                                    int board_size, int jail_position, int go_reward) {
+    int moved = position + card.amount;
+    int wrapped = moved < 0 ? moved + board_size : moved >= board_size ? moved - board_size : moved;
+    bool passes_go = (card.op == CARD_OP_ADVANCE && card.target < position) ||
+                     (card.op == CARD_OP_MOVE && moved >= board_size);
+    *cash += (card.op == CARD_OP_MONEY ? card.amount : 0) + (passes_go ? go_reward : 0);
+    *jailed = card.op == CARD_OP_JAIL;
+    return card.op == CARD_OP_ADVANCE ? card.target : card.op == CARD_OP_MOVE ? wrapped
+         : card.op == CARD_OP_JAIL ? jail_position : position;
 }
 
-static CardEffectResult card_go_to_jail(MonopolyEnv* env, int player) {
-    return go_to_jail(env, player);
+// Next random word of the step
+static inline unsigned int step_draw(StepDraws* d) {
+    return d->stream ? philox_stream_next(d->stream) : d->words[(*d->cursor)++ * ENV_BATCH_LANES];
 }
 
-static CardEffectResult card_bank_dividend(MonopolyEnv* env, int player) {
-    return adjust_money(env, player, 50);
+// Bankruptcy resolution: sell houses in board order until solvent, then houseless properties in board
+// order until solvent. Returns the money after selling (still negative if the player is bankrupt) and
+// adds the sales to *rec.
+static inline int liquidate_assets(const BoardTables* t, GameState g, int p, int money, StepRecord* rec) {
+    const int s = g.stride;
+    for (int i = 0; i < t->board_size && money < 0; ++i) {
+        int houses = g.houses[i * s];
+        if (g.owner[i * s] == p && houses > 0 && t->house_cost[i] > 0) {
+            int value = house_sale_value(t->house_cost[i], houses);
+            money += value;
+            g.houses[i * s] = 0;
+            rec->houses_sold += houses;
+            rec->house_sale += value;
+        }
+    }
+    for (int i = 0; i < t->board_size && money < 0; ++i) {
+        if (g.owner[i * s] == p && g.houses[i * s] == 0 && t->price[i] > 0) {
+            money += property_sale_value(t->price[i]);
+            g.owner[i * s] = -1;
+            rec->sold_squares |= 1ull << i;
+        }
+    }
+    return money;
 }
 
-static CardEffectResult card_pay_poor_tax(MonopolyEnv* env, int player) {
-    return adjust_money(env, player, -15);
+// A bankrupt player's properties, with their houses, go back to the bank
+static inline void forfeit_assets(const BoardTables* t, GameState g, int p) {
+    for (int i = 0; i < t->board_size; ++i) {
+        if (g.owner[i * g.stride] == p) {
+            g.owner[i * g.stride] = -1;
+            g.houses[i * g.stride] = 0;
+        }
+    }
 }
 
-static CardEffectResult card_doctors_fee(MonopolyEnv* env, int player) {
-    return adjust_money(env, player, -50);
+// Settle a negative balance: sell assets (not on a turn spent in jail, can_sell false) and, if that is not
+// enough, forfeit everything and take BANKRUPTCY_PENALTY off *reward. Returns the STEP_EVT_DEBT /
+// STEP_EVT_BANKRUPT flags that apply (0 when *money is not negative).
+static inline unsigned int settle_debt(const BoardTables* t, GameState g, int p, bool can_sell,
+                                       int* money, int* reward, StepRecord* rec) {
+    if (*money >= 0) return 0;
+    if (can_sell) *money = liquidate_assets(t, g, p, *money, rec);
+    if (*money >= 0) return STEP_EVT_DEBT;
+    *reward -= BANKRUPTCY_PENALTY;
+    forfeit_assets(t, g, p);
+    return STEP_EVT_DEBT | STEP_EVT_BANKRUPT;
 }
 
-static CardEffectResult card_tax_refund(MonopolyEnv* env, int player) {
-    return adjust_money(env, player, 20);
+// Play player p's turn with the given action (0 = Pass, 1 = Buy): jail, dice, GO, cards, the square
+// action and bankruptcy. Writes what happened to *rec (all but step and num_owned) and returns the
+// reward. Ending the game, passing the turn and counting the step are left to the engine.
+static inline int play_turn(const BoardTables* t, GameState g, int p, int action, StepDraws* draws, StepRecord* rec) {
+    const int s = g.stride, ps = p * g.stride;
+    int pos = g.positions[ps];
+    int money = g.money[ps];
+    int reward = 0, fee_paid = 0;
+    unsigned int events = 0;
+    rec->player = (unsigned char)p;
+    rec->position_before = (unsigned char)pos;
+    rec->dice = 0;
+    rec->landed_on = (unsigned char)pos;
+    rec->jail_roll = 0;
+    rec->jail_turn = 0;
+    rec->action = (unsigned char)action;
+    rec->card = -1;
+    rec->payee = -1;
+    rec->houses = 0;
+    rec->houses_sold = 0;
+    rec->house_sale = 0;
+    rec->sold_squares = 0;
+    rec->money_before = money;
+
+    // Jail: doubles or the turn limit release the player (the limit costs JAIL_FEE), otherwise the turn ends
+    bool moves = true;
+    if (g.in_jail[ps]) {
+        int count = g.jail_counters[ps] + 1;
+        const DiceTransition* roll = &t->transitions[pos][dice_outcome(step_draw(draws))];
+        rec->jail_roll = roll->dice_total;
+        rec->jail_turn = (unsigned char)count;
+        if (roll->flags & DICE_DOUBLES) {
+            events |= STEP_EVT_JAIL_DOUBLES;
+        } else if (count >= t->jail_turns) {
+            events |= STEP_EVT_JAIL_FEE;
+            money -= JAIL_FEE;
+            reward -= JAIL_FEE;
+            fee_paid += JAIL_FEE;
+        } else {
+            events |= STEP_EVT_JAIL_STAY;
+            moves = false;
+        }
+        g.in_jail[ps] = !moves;
+        g.jail_counters[ps] = moves ? 0 : count;
+    }
+
+    if (moves) {
+        // Dice, movement and GO (the table never credits a move that starts on the jail square)
+        const DiceTransition* move = &t->transitions[pos][dice_outcome(step_draw(draws))];
+        rec->dice = move->dice_total;
+        rec->landed_on = move->landing;
+        pos = move->landing;
+        if (move->flags & DICE_PASSES_GO) {
+            events |= STEP_EVT_PASSED_GO;
+            money += t->go_reward;
+            reward += t->go_reward;
+        }
+
+        // Cards
+        int deck = card_deck_of(move->square);
+        if (deck >= 0) {
+            int card = (int)(step_draw(draws) >> 1) % t->deck_size[deck + 1];
+            int cash = 0;
+            bool jailed;
+            events |= deck == CARD_DECK_CHANCE ? STEP_EVT_CHANCE : STEP_EVT_CHEST;
+            rec->card = (signed char)card;
+            pos = apply_card_effect(t->cards[deck + 1][card], pos, &cash, &jailed, t->board_size, t->jail_position, t->go_reward);
+            money += cash;
+            reward += cash;
+            if (jailed) {
+                g.in_jail[ps] = 1;
+                g.jail_counters[ps] = 0;
+            }
+        }
+
+        // Square action on the final position (a card that jails leaves the player on the jail square)
+        const int sq = pos * s;
+        if (t->square_class[pos] == SQUARE_GO_TO_JAIL) {
+            events |= STEP_EVT_SENT_JAIL;
+            pos = t->jail_position;
+            g.in_jail[ps] = 1;
+            g.jail_counters[ps] = 0;
+        } else if (t->square_class[pos] == SQUARE_TAX) {
+            events |= STEP_EVT_TAX;
+            money -= t->fee[pos];
+            reward -= t->fee[pos];
+            fee_paid += t->fee[pos];
+        } else if (t->price[pos] > 0) {
+            int owner = g.owner[sq];
+            if (owner == -1) {
+                if (money < t->price[pos]) {
+                    events |= STEP_EVT_CANT_AFFORD;
+                } else if (action == 1) {
+                    events |= STEP_EVT_BOUGHT;
+                    reward += PURCHASE_REWARD;
+                    money -= t->price[pos];
+                    g.owner[sq] = p;
+                    g.houses[sq] = 0;
+                } else {
+                    events |= STEP_EVT_DECLINED;
+                }
+            } else if (owner != p) {
+                int rent_due = rent_for_houses(t->rent[pos], g.houses[sq]);
+                int payment = money < rent_due ? money : rent_due; // Pay what you can
+                events |= STEP_EVT_PAID_RENT;
+                money -= payment;
+                reward -= payment;
+                fee_paid += payment;
+                g.money[owner * s] += payment;
+                rec->payee = (signed char)owner;
+                rec->houses = (unsigned char)g.houses[sq];
+            } else {
+                events |= STEP_EVT_OWN_SQUARE;
+                if (g.houses[sq] < MAX_HOUSES && t->house_cost[pos] > 0 && money >= t->house_cost[pos]) {
+                    if (action == 1) { // One house per landing
+                        events |= STEP_EVT_HOUSE;
+                        g.houses[sq]++;
+                        money -= t->house_cost[pos];
+                    } else {
+                        events |= STEP_EVT_HOUSE_DECLINED;
+                    }
+                }
+                rec->houses = (unsigned char)g.houses[sq];
+            }
+        }
+    }
+
+    // Bankruptcy: sell houses, then properties, until solvent (nothing is sold on a turn spent in jail); if
+    // that is not enough the player forfeits everything
+    events |= settle_debt(t, g, p, moves, &money, &reward, rec);
+
+    g.positions[ps] = pos;
+    g.money[ps] = money;
+    rec->events = events | (g.in_jail[ps] ? STEP_EVT_IN_JAIL : 0);
+    rec->position_after = (unsigned char)pos;
+    rec->money_delta = money - rec->money_before;
+    rec->fee_paid = (short)fee_paid;
+    rec->reward = reward;
+    return reward;
 }
 
 
@@ -215,39 +616,39 @@ static CardEffectResult card_tax_refund(MonopolyEnv* env, int player) {
 static void initialize_properties(Property properties[MAX_PROPERTIES]) {
     // Default all to non-properties first
     for (int i = 0; i < BOARD_SIZE; ++i) {
-        properties[i] = (Property){.price = 0, .rent = 0, .name = "", .owner = -1, .houses = 0, .house_cost = 0};
+        properties[i] = (Property){.price = 0, .rent = 0, .name = "", .house_cost = 0};
         snprintf(properties[i].name, MAX_NAME_LEN, "Square %d", i);
     }
 
     // Overwrite with actual property data
-    properties[1] = (Property){60, 2, "Mediterranean Avenue", -1, 0, 50};
-    properties[3] = (Property){60, 4, "Baltic Avenue", -1, 0, 50};
-    properties[5] = (Property){200, 25, "Reading Railroad", -1, 0, 100};
-    properties[6] = (Property){100, 6, "Oriental Avenue", -1, 0, 50};
-    properties[8] = (Property){100, 6, "Vermont Avenue", -1, 0, 50};
-    properties[9] = (Property){120, 8, "Connecticut Avenue", -1, 0, 50};
-    properties[11] = (Property){140, 10, "St. Charles Place", -1, 0, 100};
-    properties[12] = (Property){150, 10, "Electric Company", -1, 0, 75}; // Utility
-    properties[13] = (Property){140, 10, "States Avenue", -1, 0, 100};
-    properties[14] = (Property){160, 12, "Virginia Avenue", -1, 0, 100};
-    properties[15] = (Property){200, 25, "Pennsylvania Railroad", -1, 0, 100};
-    properties[16] = (Property){180, 14, "St. James Place", -1, 0, 100};
-    properties[18] = (Property){180, 14, "Tennessee Avenue", -1, 0, 100};
-    properties[19] = (Property){200, 16, "New York Avenue", -1, 0, 100};
-    properties[21] = (Property){220, 18, "Kentucky Avenue", -1, 0, 150};
-    properties[23] = (Property){220, 18, "Indiana Avenue", -1, 0, 150};
-    properties[24] = (Property){240, 20, "Illinois Avenue", -1, 0, 150};
-    properties[25] = (Property){200, 25, "B. & O. Railroad", -1, 0, 100};
-    properties[26] = (Property){260, 22, "Atlantic Avenue", -1, 0, 150};
-    properties[27] = (Property){260, 22, "Ventnor Avenue", -1, 0, 150};
-    properties[28] = (Property){150, 10, "Water Works", -1, 0, 75}; // Utility
-    properties[29] = (Property){280, 24, "Marvin Gardens", -1, 0, 150};
-    properties[31] = (Property){300, 26, "Pacific Avenue", -1, 0, 200};
-    properties[32] = (Property){300, 26, "North Carolina Avenue", -1, 0, 200};
-    properties[34] = (Property){320, 28, "Pennsylvania Avenue", -1, 0, 200};
-    properties[35] = (Property){200, 25, "Short Line Railroad", -1, 0, 100};
-    properties[37] = (Property){350, 35, "Park Place", -1, 0, 200};
-    properties[39] = (Property){400, 50, "Boardwalk", -1, 0, 200};
+    properties[1] = (Property){60, 2, "Mediterranean Avenue", 50};
+    properties[3] = (Property){60, 4, "Baltic Avenue", 50};
+    properties[5] = (Property){200, 25, "Reading Railroad", 100};
+    properties[6] = (Property){100, 6, "Oriental Avenue", 50};
+    properties[8] = (Property){100, 6, "Vermont Avenue", 50};
+    properties[9] = (Property){120, 8, "Connecticut Avenue", 50};
+    properties[11] = (Property){140, 10, "St. Charles Place", 100};
+    properties[12] = (Property){150, 10, "Electric Company", 75}; // Utility
+    properties[13] = (Property){140, 10, "States Avenue", 100};
+    properties[14] = (Property){160, 12, "Virginia Avenue", 100};
+    properties[15] = (Property){200, 25, "Pennsylvania Railroad", 100};
+    properties[16] = (Property){180, 14, "St. James Place", 100};
+    properties[18] = (Property){180, 14, "Tennessee Avenue", 100};
+    properties[19] = (Property){200, 16, "New York Avenue", 100};
+    properties[21] = (Property){220, 18, "Kentucky Avenue", 150};
+    properties[23] = (Property){220, 18, "Indiana Avenue", 150};
+    properties[24] = (Property){240, 20, "Illinois Avenue", 150};
+    properties[25] = (Property){200, 25, "B. & O. Railroad", 100};
+    properties[26] = (Property){260, 22, "Atlantic Avenue", 150};
+    properties[27] = (Property){260, 22, "Ventnor Avenue", 150};
+    properties[28] = (Property){150, 10, "Water Works", 75}; // Utility
+    properties[29] = (Property){280, 24, "Marvin Gardens", 150};
+    properties[31] = (Property){300, 26, "Pacific Avenue", 200};
+    properties[32] = (Property){300, 26, "North Carolina Avenue", 200};
+    properties[34] = (Property){320, 28, "Pennsylvania Avenue", 200};
+    properties[35] = (Property){200, 25, "Short Line Railroad", 100};
+    properties[37] = (Property){350, 35, "Park Place", 200};
+    properties[39] = (Property){400, 50, "Boardwalk", 200};
 
     // Special square names
     strncpy(properties[0].name, "GO", MAX_NAME_LEN - 1);
@@ -269,23 +670,68 @@ static void initialize_properties(Property properties[MAX_PROPERTIES]) {
     }
 }
 
+// Default decks
+static const Card default_chance_cards[] = {
+    {"Advance to Go", "Move to GO and collect $200.", {CARD_OP_ADVANCE, 0, 0}},
+    {"Go to Jail", "Go directly to Jail.", {CARD_OP_JAIL, 0, 0}},
+    {"Bank pays you dividend", "Collect $50 from the bank.", {CARD_OP_MONEY, 0, 50}},
+    {"Pay poor tax", "Pay $15 poor tax.", {CARD_OP_MONEY, 0, -15}}
+};
+
+static const Card default_chest_cards[] = {
+    {"Doctor's fee", "Pay $50 doctor's fee.", {CARD_OP_MONEY, 0, -50}},
+    {"Income tax refund", "Collect $20 income tax refund.", {CARD_OP_MONEY, 0, 20}},
+    {"Go to Jail", "Go directly to Jail.", {CARD_OP_JAIL, 0, 0}},
+    {"Advance to Go", "Move to GO and collect $200.", {CARD_OP_ADVANCE, 0, 0}}
+};
+
+// Copy env's configuration, properties and decks into its BoardTables, classify every square and
+// precompute all DICE_OUTCOMES moves from each one (called by create_monopoly_env once the decks are set)
+static void build_board_tables(MonopolyEnv* env) {
+    BoardTables* b = &env->board;
+    memset(b, 0, sizeof(*b));
+    b->num_players = env->num_players;
+    b->go_reward = env->go_reward;
+    b->board_size = env->board_size;
+    b->jail_position = env->jail_position;
+    b->go_to_jail_position = env->go_to_jail_position;
+    b->jail_turns = env->jail_turns;
+    for (int pos = 0; pos < env->board_size; ++pos) {
+        b->price[pos] = env->properties[pos].price;
+        b->rent[pos] = env->properties[pos].rent;
+        b->house_cost[pos] = env->properties[pos].house_cost;
+        b->fee[pos] = get_fee_for_position(pos);
+        b->square_class[pos] = pos == env->go_to_jail_position ? SQUARE_GO_TO_JAIL
+                             : is_chance_position(pos) ? SQUARE_CHANCE
+                             : is_chest_position(pos) ? SQUARE_CHEST
+                             : b->fee[pos] > 0 ? SQUARE_TAX : SQUARE_PLAIN;
+        b->deck[pos] = 1 + card_deck_of(b->square_class[pos]);
+    }
+    b->deck_size[0] = 1;
+    for (int d = 0; d < NUM_CARD_DECKS; ++d) {
+        b->deck_size[d + 1] = env->deck_sizes[d];
+        for (int c = 0; c < env->deck_sizes[d]; ++c) b->cards[d + 1][c] = env->decks[d][c].effect;
+    }
+    for (int pos = 0; pos < env->board_size; ++pos) {
+        for (int roll = 0; roll < DICE_OUTCOMES; ++roll) {
+            int die1 = roll / 6 + 1, die2 = roll % 6 + 1;
+            int landing = (pos + die1 + die2) % env->board_size;
+            DiceTransition* t = &b->transitions[pos][roll];
+            t->landing = (unsigned char)landing;
+            t->square = b->square_class[landing];
+            t->dice_total = (unsigned char)(die1 + die2);
+            // A move that starts on the jail square never collects
+            t->flags = (landing < pos && pos != env->jail_position ? DICE_PASSES_GO : 0) | (die1 == die2 ? DICE_DOUBLES : 0);
+        }
+    }
+}
+
 // Initialize Card Decks
 static void initialize_decks(MonopolyEnv* env) {
-    // Chance Deck
-    env->chance_deck_size = 0;
-    env->chance_deck[env->chance_deck_size++] = (Card){"Advance to Go", card_advance_to_go};
-    env->chance_deck[env->chance_deck_size++] = (Card){"Go to Jail", card_go_to_jail};
-    env->chance_deck[env->chance_deck_size++] = (Card){"Bank pays you dividend", card_bank_dividend};
-    env->chance_deck[env->chance_deck_size++] = (Card){"Pay poor tax", card_pay_poor_tax};
-    // Add more chance cards here if needed...
-
-    // Community Chest Deck
-    env->chest_deck_size = 0;
-    env->chest_deck[env->chest_deck_size++] = (Card){"Doctor's fee", card_doctors_fee};
-    env->chest_deck[env->chest_deck_size++] = (Card){"Income tax refund", card_tax_refund};
-    env->chest_deck[env->chest_deck_size++] = (Card){"Go to Jail", card_go_to_jail};
-    env->chest_deck[env->chest_deck_size++] = (Card){"Advance to Go", card_advance_to_go};
-    // Add more chest cards here if needed...
+    env->deck_sizes[CARD_DECK_CHANCE] = (int)(sizeof(default_chance_cards) / sizeof(Card));
+    memcpy(env->decks[CARD_DECK_CHANCE], default_chance_cards, sizeof(default_chance_cards));
+    env->deck_sizes[CARD_DECK_CHEST] = (int)(sizeof(default_chest_cards) / sizeof(Card));
+    memcpy(env->decks[CARD_DECK_CHEST], default_chest_cards, sizeof(default_chest_cards));
 }
 
 // Get Observation (internal helper)
@@ -301,7 +747,7 @@ static void get_observation(MonopolyEnv* env, int* obs) {
     // In Jail flags
     for (int i = 0; i < env->num_players; ++i) obs[k++] = (int)env->in_jail[i];
     // Property Owners
-    for (int i = 0; i < env->board_size; ++i) obs[k++] = env->properties[i].owner;
+    for (int i = 0; i < env->board_size; ++i) obs[k++] = env->owner[i];
     // Current Player
     obs[k++] = env->current_player;
 }
@@ -334,12 +780,19 @@ MonopolyEnv* create_monopoly_env(int num_players, int start_money, int go_reward
     env->jail_turns = 3;
     env->num_players = num_players;
     env->obs_money_high = start_money * 10; // Arbitrary high limit for observation
+    philox_stream_init(&env->rng, 0); // Fixed default seed, see seed_monopoly_env
 
     // --- Initialize State ---
     initialize_properties(env->properties);
     initialize_decks(env);
+    build_board_tables(env);
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        env->owner[i] = -1;
+        env->houses[i] = 0;
+    }
     env->current_player = 0;
     env->steps_taken = 0;
+    env->properties_bought = 0;
     env->done = false;
 
     // Reset player-specific state
@@ -362,6 +815,11 @@ MonopolyEnv* create_monopoly_env(int num_players, int start_money, int go_reward
     return env;
 }
 
+// Seed the environment's random stream (draws depend only on seed, episode and step)
+void seed_monopoly_env(MonopolyEnv* env, unsigned long long seed) {
+    philox_stream_init(&env->rng, seed);
+}
+
 // Destroy the environment and free memory
 void destroy_monopoly_env(MonopolyEnv* env) {
     if (env) {
@@ -376,8 +834,8 @@ void reset_monopoly_env(MonopolyEnv* env, int* obs) {
 
     // Reset properties
     for (int i = 0; i < env->board_size; ++i) {
-        env->properties[i].owner = -1;
-        env->properties[i].houses = 0;
+        env->owner[i] = -1;
+        env->houses[i] = 0;
         // Price, rent, name, house_cost remain as initialized
     }
 
@@ -391,6 +849,7 @@ void reset_monopoly_env(MonopolyEnv* env, int* obs) {
 
     env->current_player = 0;
     env->steps_taken = 0;
+    env->properties_bought = 0;
     env->done = false;
     memset(&env->last_log, 0, sizeof(LogEntry));
 
@@ -404,49 +863,182 @@ static void next_player(MonopolyEnv* env) {
     env->current_player = (env->current_player + 1) % env->num_players;
 }
 
-// Create Log Entry (internal helper)
-static LogEntry create_log_entry(MonopolyEnv* env, int player, int pos_before, int dice, int landed_on, int pos_after,
-                                 int money_before, int money_after, double reward, int fee_paid,
-                                 const char* log_desc, int action_taken, const char* card_drawn,
-                                 const char* card_spec_desc)
-{
-    LogEntry entry;
-    entry.step = env->steps_taken;
-    entry.player = player;
-    entry.position_before = pos_before;
-    entry.dice_roll = dice;
-    entry.landed_on_position = landed_on;
-    entry.position_after = pos_after;
-    entry.money_before = money_before;
-    entry.money_after = money_after;
-    entry.reward = reward;
-    entry.done = env->done;
-    entry.in_jail = env->in_jail[player];
-    entry.fee_paid = fee_paid;
-    entry.episode_id = 0; // Will be set by caller
-
-    // Safe string copying
-    strncpy(entry.action_desc, log_desc ? log_desc : "", sizeof(entry.action_desc) - 1);
-    entry.action_desc[sizeof(entry.action_desc) - 1] = '\0'; // Ensure null termination
-
-    entry.agent_action = action_taken;
-
-    // Count owned properties for the log
-    entry.num_owned_properties = 0;
-    for (int i = 0; i < env->board_size; ++i) {
-        if (env->properties[i].owner == player) {
-            entry.num_owned_properties++;
+// Append printf-style text to a log description
+static void append_desc(char* desc, size_t size, const char* fmt, ...) {
+    size_t len = strlen(desc);
+    if (len + 1 >= size) return;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(desc + len, size - len, fmt, args);
+    va_end(args);
+}
+
+// Describe what a card drawn on `position` did, as step_monopoly_env logs it
+static void describe_card(const MonopolyEnv* env, CardEffect card, int position, char* desc, size_t size) {
+    int gained = 0;
+    bool jailed;
+    int dest = apply_card_effect(card, position, &gained, &jailed, env->board_size, env->jail_position, env->go_reward);
+    desc[0] = '\0';
+    if (jailed) {
+        append_desc(desc, size, "Moved to Jail (Position %d).", env->jail_position);
+        return;
+    }
+    if (card.op == CARD_OP_MONEY) {
+        append_desc(desc, size, "Adjusted money by %d.", gained);
+        return;
+    }
+    if (card.op == CARD_OP_ADVANCE && dest == 0) {
+        append_desc(desc, size, "Advanced to GO.");
+    } else if (card.op == CARD_OP_ADVANCE) {
+        append_desc(desc, size, "Advanced to %s (Position %d).", env->properties[dest].name, dest);
+    } else {
+        append_desc(desc, size, "Moved %d squares to %s (Position %d).", card.amount, env->properties[dest].name, dest);
+    }
+    if (gained > 0) append_desc(desc, size, " Collected $%d.", gained);
+}
+
+// Rebuild the LogEntry of a step, text included, from its record and env's board and decks. The text is
+// the one step_monopoly_env always wrote, except that houses sold in a bankruptcy are summed up instead of
+// listed per property.
+static void decode_step_record(const StepRecord* rec, int episode_id, const MonopolyEnv* env, LogEntry* out) {
+    memset(out, 0, sizeof(LogEntry));
+    int p = rec->player;
+    int money_after = rec->money_before + rec->money_delta;
+    out->episode_id = episode_id;
+    out->step = rec->step;
+    out->player = p;
+    out->position_before = rec->position_before;
+    out->dice_roll = rec->dice;
+    out->landed_on_position = rec->landed_on;
+    out->position_after = rec->position_after;
+    out->money_before = rec->money_before;
+    out->money_after = money_after;
+    out->reward = rec->reward;
+    out->done = (rec->events & STEP_EVT_BANKRUPT) != 0;
+    out->in_jail = (rec->events & STEP_EVT_IN_JAIL) != 0;
+    out->fee_paid = rec->fee_paid;
+    out->agent_action = rec->action;
+    out->num_owned_properties = rec->num_owned;
+
+    char* desc = out->action_desc;
+    const size_t size = sizeof(out->action_desc);
+
+    // --- Jail ---
+    if (rec->events & STEP_EVT_JAIL_DOUBLES) {
+        append_desc(desc, size, "Player %d rolled doubles (%d) to get out of jail. ", p, rec->jail_roll / 2);
+    } else if (rec->events & STEP_EVT_JAIL_FEE) {
+        append_desc(desc, size, "Player %d paid $%d to get out of jail (turn limit). ", p, JAIL_FEE);
+    } else if (rec->events & STEP_EVT_JAIL_STAY) {
+        append_desc(desc, size, "Player %d failed to roll doubles in jail (Turn %d).", p, rec->jail_turn);
+        if (rec->events & STEP_EVT_BANKRUPT) append_desc(desc, size, "Player %d went bankrupt paying jail fee! ", p);
+        return;
+    }
+
+    // --- Movement and cards ---
+    if (rec->events & STEP_EVT_PASSED_GO) append_desc(desc, size, "Passed GO, collected $%d. ", env->go_reward);
+    int deck = (rec->events & STEP_EVT_CHANCE) ? CARD_DECK_CHANCE : (rec->events & STEP_EVT_CHEST) ? CARD_DECK_CHEST : -1;
+    if (deck >= 0 && rec->card >= 0 && rec->card < env->deck_sizes[deck]) {
+        const Card* card = &env->decks[deck][rec->card];
+        snprintf(out->card_drawn, sizeof(out->card_drawn), "%s", card->name);
+        append_desc(desc, size, "Landed on %s (%d), drew '%s'. ", deck == CARD_DECK_CHANCE ? "Chance" : "Community Chest",
+                    rec->landed_on, card->name);
+        describe_card(env, card->effect, rec->landed_on, out->card_specific_desc, sizeof(out->card_specific_desc));
+        append_desc(desc, size, "%s ", out->card_specific_desc);
+    }
+
+    // --- Square action (on the square the dice and card left the player on) ---
+    int pos = (rec->events & STEP_EVT_SENT_JAIL) ? env->go_to_jail_position : rec->position_after;
+    const Property* prop = &env->properties[pos];
+    int houses = rec->houses;
+    if (rec->events & STEP_EVT_SENT_JAIL) {
+        append_desc(desc, size, "Landed on Go To Jail (%d). Moved to Jail (Position %d).", pos, env->jail_position);
+    } else if (rec->events & STEP_EVT_TAX) {
+        append_desc(desc, size, "Paid fee of $%d on square %d (%s). ", env->board.fee[pos], pos, prop->name);
+    } else if (rec->events & STEP_EVT_BOUGHT) {
+        append_desc(desc, size, "Player %d chose to BUY property %d (%s) for $%d. ", p, pos, prop->name, prop->price);
+    } else if (rec->events & STEP_EVT_DECLINED) {
+        append_desc(desc, size, "Player %d chose NOT to buy property %d (%s) for $%d. ", p, pos, prop->name, prop->price);
+    } else if (rec->events & STEP_EVT_CANT_AFFORD) {
+        append_desc(desc, size, "Player %d cannot afford property %d (%s) ($%d). ", p, pos, prop->name, prop->price);
+    } else if (rec->events & STEP_EVT_PAID_RENT) {
+        int payment = rec->fee_paid - ((rec->events & STEP_EVT_JAIL_FEE) ? JAIL_FEE : 0);
+        const char* property_state = (houses == MAX_HOUSES) ? "hotel" : (houses > 0) ? "houses" : "no houses";
+        append_desc(desc, size, "Paid $%d rent to Player %d at property %d (%s) with %d %s. ",
+                    payment, rec->payee, pos, prop->name, (houses == MAX_HOUSES) ? 1 : houses, property_state);
+    } else if (rec->events & STEP_EVT_HOUSE) {
+        append_desc(desc, size, "Landed on own property %d (%s). Bought %d house(s) for $%d. Now has %d houses. ",
+                    pos, prop->name, 1, prop->house_cost, houses);
+    } else if (rec->events & STEP_EVT_HOUSE_DECLINED) {
+        append_desc(desc, size, "Landed on own property %d (%s). Chose not to buy houses (current: %d). ", pos, prop->name, houses);
+    } else if (rec->events & STEP_EVT_OWN_SQUARE) {
+        if (houses >= MAX_HOUSES) {
+            append_desc(desc, size, "Landed on own property %d (%s). Already has maximum houses/hotel (%d). ", pos, prop->name, houses);
+        } else if (prop->house_cost <= 0) {
+            append_desc(desc, size, "Landed on own property %d (%s). This property type doesn't support houses. ", pos, prop->name);
+        } else {
+            append_desc(desc, size, "Landed on own property %d (%s). Cannot afford houses (cost: $%d). ", pos, prop->name, prop->house_cost);
+        }
+    } else if (prop->price == 0 && pos != 0 && pos != env->jail_position && env->board.square_class[pos] == SQUARE_PLAIN) {
+        append_desc(desc, size, "Landed on non-action square %d (%s). ", pos, prop->name);
+    }
+
+    // --- Bankruptcy ---
+    if (rec->events & STEP_EVT_DEBT) {
+        bool bankrupt = (rec->events & STEP_EVT_BANKRUPT) != 0;
+        int property_sale = 0;
+        for (int i = 0; i < env->board_size; ++i) {
+            if ((rec->sold_squares >> i) & 1ull) property_sale += property_sale_value(env->properties[i].price);
+        }
+        append_desc(desc, size, "Player %d is bankrupt ($%d). Attempting to sell assets. ",
+                    p, money_after - rec->house_sale - property_sale);
+        if (rec->houses_sold > 0) append_desc(desc, size, "Sold %d houses/hotel for $%d. ", rec->houses_sold, rec->house_sale);
+        if (!bankrupt && rec->sold_squares == 0) {
+            append_desc(desc, size, "Player %d is now solvent ($%d) after selling houses. ", p, money_after);
+        } else {
+            append_desc(desc, size, "Still bankrupt after selling houses. Selling properties. ");
+            for (int i = 0; i < env->board_size; ++i) {
+                if ((rec->sold_squares >> i) & 1ull) {
+                    append_desc(desc, size, "Sold property %s (%d) for $%d. ", env->properties[i].name, i,
+                                property_sale_value(env->properties[i].price));
+                }
+            }
+            if (!bankrupt) append_desc(desc, size, "Player %d is now solvent ($%d) after selling properties. ", p, money_after);
+        }
+        if (bankrupt) {
+            append_desc(desc, size, "Player %d could not raise enough funds. Final balance: $%d. Game Over! ", p, money_after);
+        } else {
+            append_desc(desc, size, "Player %d survived bankruptcy. Current balance: $%d. ", p, money_after);
         }
     }
+}
 
-    // Safe string copying for card info
-    strncpy(entry.card_drawn, card_drawn ? card_drawn : "", sizeof(entry.card_drawn) - 1);
-    entry.card_drawn[sizeof(entry.card_drawn) - 1] = '\0';
+// GameState view of a MonopolyEnv
+static inline GameState env_game_state(MonopolyEnv* env) {
+    GameState g = {env->positions, env->money, env->in_jail, env->jail_counters, env->owner, env->houses, 1};
+    return g;
+}
 
-    strncpy(entry.card_specific_desc, card_spec_desc ? card_spec_desc : "", sizeof(entry.card_specific_desc) - 1);
-    entry.card_specific_desc[sizeof(entry.card_specific_desc) - 1] = '\0';
+// play_turn for the current player of a MonopolyEnv, with the draws of its stream. Ends the game on a
+// bankruptcy and counts the step; the caller takes its observation and then calls env_pass_turn.
+static int env_play_turn(MonopolyEnv* env, int action, StepRecord* rec) {
+    StepDraws draws = {&env->rng, NULL, NULL};
+    int reward = play_turn(&env->board, env_game_state(env), env->current_player, action, &draws, rec);
+    if (rec->events & STEP_EVT_BOUGHT) env->properties_bought++;
+    if (rec->events & STEP_EVT_BANKRUPT) env->done = true;
+    rec->step = (unsigned short)++env->steps_taken;
+    return reward;
+}
 
-    return entry;
+// Hand the turn on after a step; a finished game keeps its last mover, unless that turn was spent in jail
+static void env_pass_turn(MonopolyEnv* env, const StepRecord* rec) {
+    if (!env->done || (rec->events & STEP_EVT_JAIL_STAY)) next_player(env);
+}
+
+// Properties a player owns
+static int count_owned_properties(const MonopolyEnv* env, int player) {
+    int count = 0;
+    for (int i = 0; i < env->board_size; ++i) count += env->owner[i] == player;
+    return count;
 }
 
 
@@ -459,7 +1051,6 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
     if (env->done) {
         // Game already ended, return current state and 0 reward
         get_observation(env, obs);
-        strncpy(result.log.action_desc, "Game already ended.", sizeof(result.log.action_desc) - 1);
         result.log = env->last_log; // Return last log entry
         result.log.step = env->steps_taken; // Update step count if needed
         result.log.action_desc[0] = '\0'; // Clear desc
@@ -467,413 +1058,17 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
         return result;
     }
 
-    int p = env->current_player;
-    double current_step_reward = 0.0;
-    char log_buffer[MAX_DESC_LEN * 2] = ""; // Buffer for building the log description
-    int money_before_turn = env->money[p];
-    int fee_paid_this_turn = 0;
-    char card_name_drawn[MAX_NAME_LEN] = "";
-    char card_spec_desc_drawn[MAX_DESC_LEN] = "";
-    double card_reward_contribution = 0.0;
-    int dice_total = 0;
-    int prev_position = env->positions[p];
-    int landed_position_this_turn = prev_position; // Initial value
-
-    // --- Jail Logic ---
-    if (env->in_jail[p]) {
-        env->jail_counters[p]++;
-        int dice1 = (rand() % 6) + 1;
-        int dice2 = (rand() % 6) + 1;
-        bool rolled_doubles = (dice1 == dice2);
-        bool turn_limit_reached = (env->jail_counters[p] >= env->jail_turns);
-
-        if (rolled_doubles) {
-            env->in_jail[p] = false;
-            env->jail_counters[p] = 0;
-            snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                     "Player %d rolled doubles (%d) to get out of jail. ", p, dice1);
-            // Player proceeds to normal dice roll below
-        } else if (turn_limit_reached) {
-            env->in_jail[p] = false;
-            env->jail_counters[p] = 0;
-            int jail_fee = 50;
-            env->money[p] -= jail_fee;
-            fee_paid_this_turn += jail_fee;
-            card_reward_contribution -= jail_fee; // Penalty for paying
-            snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                     "Player %d paid $%d to get out of jail (turn limit). ", p, jail_fee);
-            // Player proceeds to normal dice roll below
-        } else {
-            // Failed to roll doubles, turn ends here
-            snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                     "Player %d failed to roll doubles in jail (Turn %d).", p, env->jail_counters[p]);
-
-            env->steps_taken++; // Increment step counter for the turn spent in jail
-            result.reward = card_reward_contribution; // Only reward/penalty from jail fee attempt
-            result.done = env->done; // Done status might change if fee caused bankruptcy (checked later)
-
-            // Check immediate bankruptcy from paying fee if turn limit reached
-             if (env->money[p] < 0 && !env->done) {
-                 // Attempt to resolve bankruptcy (Simplified check here, full check later)
-                  if (env->money[p] < 0) { // Still bankrupt after trying to pay
-                        env->done = true; // Game over
-                        card_reward_contribution -= 1000; // Bankruptcy penalty
-                        snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                                 "Player %d went bankrupt paying jail fee! ", p);
-                        // Forfeit properties
-                        for(int i=0; i<env->board_size; ++i) {
-                            if(env->properties[i].owner == p) {
-                                env->properties[i].owner = -1;
-                                env->properties[i].houses = 0;
-                            }
-                        }
-                 }
-                 result.done = env->done; // Update done status
-                 result.reward += card_reward_contribution; // Include bankruptcy penalty
-            }
-
-            // Log and return for the jail turn
-            env->last_log = create_log_entry(env, p, prev_position, 0, prev_position, env->positions[p],
-                                             money_before_turn, env->money[p], result.reward, fee_paid_this_turn,
-                                             log_buffer, action, "", ""); // No move/card
-            result.log = env->last_log;
-            get_observation(env, obs);
-            next_player(env); // Advance player
-            return result;
-        }
-        // If got out of jail, continue to normal turn roll
-    }
-
-    // --- Normal Turn: Dice Roll and Movement ---
-    int dice1 = (rand() % 6) + 1;
-    int dice2 = (rand() % 6) + 1;
-    dice_total = dice1 + dice2;
-
-    landed_position_this_turn = (prev_position + dice_total) % env->board_size;
-
-    // Check for passing GO
-    bool passed_go = landed_position_this_turn < prev_position && !(env->in_jail[p]); // Don't collect if just got out of jail and landed before GO
-     if (passed_go && prev_position != env->jail_position) { // Ensure not passing GO due to leaving jail on pos 10
-        env->money[p] += env->go_reward;
-        current_step_reward += env->go_reward;
-        snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                 "Passed GO, collected $%d. ", env->go_reward);
-    }
-
-    // Tentatively update position
-    env->positions[p] = landed_position_this_turn;
-    int pos = env->positions[p]; // Current position for evaluation
-
-    // --- Card Handling ---
-    CardEffectResult card_result = {0.0, ""};
-    bool card_drawn = false;
-
-    if (is_chance_position(pos)) {
-        int card_index = rand() % env->chance_deck_size;
-        Card drawn_card = env->chance_deck[card_index];
-        strncpy(card_name_drawn, drawn_card.name, MAX_NAME_LEN - 1);
-        card_name_drawn[MAX_NAME_LEN - 1] = '\0';
-        snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                 "Landed on Chance (%d), drew '%s'. ", pos, card_name_drawn);
-        card_result = drawn_card.effect(env, p); // Effect function modifies state
-        card_reward_contribution += card_result.reward;
-        strncpy(card_spec_desc_drawn, card_result.card_specific_desc, MAX_DESC_LEN - 1);
-        card_spec_desc_drawn[MAX_DESC_LEN - 1] = '\0';
-        pos = env->positions[p]; // IMPORTANT: Update pos in case card moved the player
-        card_drawn = true;
-    } else if (is_chest_position(pos)) {
-        int card_index = rand() % env->chest_deck_size;
-        Card drawn_card = env->chest_deck[card_index];
-        strncpy(card_name_drawn, drawn_card.name, MAX_NAME_LEN - 1);
-        card_name_drawn[MAX_NAME_LEN - 1] = '\0';
-        snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                 "Landed on Community Chest (%d), drew '%s'. ", pos, card_name_drawn);
-        card_result = drawn_card.effect(env, p); // Effect function modifies state
-        card_reward_contribution += card_result.reward;
-        strncpy(card_spec_desc_drawn, card_result.card_specific_desc, MAX_DESC_LEN - 1);
-        card_spec_desc_drawn[MAX_DESC_LEN - 1] = '\0';
-        pos = env->positions[p]; // IMPORTANT: Update pos in case card moved the player
-        card_drawn = true;
-    }
-
-    // Append the specific card description to the main log description
-    if (strlen(card_spec_desc_drawn) > 0) {
-        strncat(log_buffer, card_spec_desc_drawn, sizeof(log_buffer) - strlen(log_buffer) - 1);
-        strncat(log_buffer, " ", sizeof(log_buffer) - strlen(log_buffer) - 1);
-    }
-
-
-    // --- Process Square Actions (based on final position 'pos' after potential card move) ---
-    Property* current_property = &env->properties[pos];
-    int prop_price = current_property->price;
-    int prop_rent = current_property->rent;
-    int prop_owner = current_property->owner;
-    int prop_houses = current_property->houses;
-
-
-    // 1. Go To Jail Square
-    if (pos == env->go_to_jail_position) {
-        // Avoid double penalty if card already sent player here
-        if (!card_drawn || strcmp(card_name_drawn, "Go to Jail") != 0) {
-             snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                     "Landed on Go To Jail (%d). ", pos);
-             CardEffectResult jail_effect = go_to_jail(env, p); // Call effect to set state
-             card_reward_contribution += jail_effect.reward; // Add potential penalty/reward
-             strncat(log_buffer, jail_effect.card_specific_desc, sizeof(log_buffer) - strlen(log_buffer) - 1);
-             pos = env->positions[p]; // Ensure pos reflects Jail position (10)
-        }
-    }
-    // 2. Fee Squares
-    else if (get_fee_for_position(pos) > 0) {
-        int fee = get_fee_for_position(pos);
-        env->money[p] -= fee;
-        fee_paid_this_turn += fee;
-        card_reward_contribution -= fee; // Apply fee penalty via card reward accumulator
-        snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                 "Paid fee of $%d on square %d (%s). ", fee, pos, current_property->name);
-    }
-    // 3. Property Squares
-    else if (prop_price > 0) {
-        // a) Unowned
-        if (prop_owner == -1) {
-            bool can_afford = (env->money[p] >= prop_price);
-            if (can_afford) {
-                if (action == 1) { // Agent chose to buy
-                    current_step_reward += 100.0; // bonus reward for buying a property
-                    env->money[p] -= prop_price;
-                    env->properties[pos].owner = p;
-                    env->properties[pos].houses = 0; // Ensure houses reset on purchase
-                    snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                             "Player %d chose to BUY property %d (%s) for $%d. ", p, pos, current_property->name, prop_price);
-                } else { // Agent chose not to buy
-                    snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                             "Player %d chose NOT to buy property %d (%s) for $%d. ", p, pos, current_property->name, prop_price);
-                }
-            } else { // Cannot afford
-                 snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                         "Player %d cannot afford property %d (%s) ($%d). ", p, pos, current_property->name, prop_price);
-            }
-        }
-       // b) Owned by opponent
-      else if (prop_owner != p) {
-          int rent_due = prop_rent; // Base rent
-
-          // More realistic rent multipliers based on house count
-          if (prop_houses > 0) {
-              switch (prop_houses) {
-                  case 1:
-                      rent_due = prop_rent * 5;    // Typically 5x base rent
-                      break;
-                  case 2:
-                      rent_due = prop_rent * 15;   // Typically 15x base rent
-                      break;
-                  case 3:
-                      rent_due = prop_rent * 45;   // Typically 45x base rent
-                      break;
-                  case 4:
-                      rent_due = prop_rent * 80;   // Typically 80x base rent
-                      break;
-                  case 5: // Hotel
-                      rent_due = prop_rent * 125;  // Typically 125x base rent
-                      break;
-                  default:
-                      rent_due *= (prop_houses + 1); // Fallback
-              }
-          }
-
-          int payment = (env->money[p] < rent_due) ? env->money[p] : rent_due; // Pay what you can
-
-          env->money[p] -= payment;
-          if (prop_owner >= 0 && prop_owner < env->num_players) { // Ensure owner is valid
-              env->money[prop_owner] += payment;
-          }
-          fee_paid_this_turn += payment; // Rent counts as a fee paid
-          card_reward_contribution -= payment; // Negative reward for paying rent
-
-          // Update log message
-          const char* property_state = (prop_houses == 5) ? "hotel" :
-                                    (prop_houses > 0) ? "houses" : "no houses";
-
-          snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                  "Paid $%d rent to Player %d at property %d (%s) with %d %s. ",
-                  payment, prop_owner, pos, current_property->name,
-                  (prop_houses == 5) ? 1 : prop_houses, property_state);
-      }
-        // c) Owned by self
-        else {
-            // Check if player can buy houses on this property
-            bool can_buy_houses = (env->properties[pos].house_cost > 0 && env->money[p] >= env->properties[pos].house_cost);
-            int current_houses = env->properties[pos].houses;
-            int max_houses = 5; // 4 houses + 1 hotel
-
-            // Only allow buying houses if we have less than the maximum
-            if (can_buy_houses && current_houses < max_houses) {
-                // Determine how many houses the player can afford
-                int affordable_houses = env->money[p] / env->properties[pos].house_cost;
-                // Limit to how many more houses can be added
-                int max_new_houses = max_houses - current_houses;
-                int houses_can_buy = (affordable_houses < max_new_houses) ? affordable_houses : max_new_houses;
-
-                // Agent decides whether to buy houses and how many (using action)
-                // For simplicity, if action is 1 (buy), buy as many as possible up to 1
-                int houses_to_buy = 0;
-                if (action == 1 && houses_can_buy > 0) {
-                    houses_to_buy = 1; // Buy one house at a time
-
-                    // Update property and player money
-                    int house_cost = env->properties[pos].house_cost;
-                    env->properties[pos].houses += houses_to_buy;
-                    env->money[p] -= house_cost * houses_to_buy;
-
-                    // Log the purchase
-                    snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                            "Landed on own property %d (%s). Bought %d house(s) for $%d. Now has %d houses. ",
-                            pos, current_property->name, houses_to_buy, house_cost * houses_to_buy,
-                            env->properties[pos].houses);
-                } else {
-                    // Chose not to buy houses
-                    snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                            "Landed on own property %d (%s). Chose not to buy houses (current: %d). ",
-                            pos, current_property->name, current_houses);
-                }
-            } else if (current_houses >= max_houses) {
-                // Already has maximum houses
-                snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                        "Landed on own property %d (%s). Already has maximum houses/hotel (%d). ",
-                        pos, current_property->name, current_houses);
-            } else if (env->properties[pos].house_cost <= 0) {
-                // Property doesn't support houses (like railroads or utilities)
-                snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                        "Landed on own property %d (%s). This property type doesn't support houses. ",
-                        pos, current_property->name);
-            } else {
-                // Can't afford houses
-                snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                        "Landed on own property %d (%s). Cannot afford houses (cost: $%d). ",
-                        pos, current_property->name, env->properties[pos].house_cost);
-            }
-        }
-    }
-     // 4. Other non-action squares
-    else if (pos != 0 && pos != env->jail_position && !is_chance_position(pos) && !is_chest_position(pos)) {
-         snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                 "Landed on non-action square %d (%s). ", pos, current_property->name);
-    }
-
-
-     // --- Check for Bankruptcy (AFTER all turn actions and money changes) ---
-    if (env->money[p] < 0 && !env->done) {
-        snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                 "Player %d is bankrupt ($%d). Attempting to sell assets. ", p, env->money[p]);
-        bool bankruptcy_resolved = false;
-
-        // --- Phase 1: Sell Houses ---
-        int houses_sold_total_value = 0;
-        for (int i = 0; i < env->board_size; ++i) {
-            if (env->properties[i].owner == p && env->properties[i].houses > 0) {
-                int house_cost = env->properties[i].house_cost; // Get house cost
-                if (house_cost > 0) { // Can only sell houses if they have a cost basis
-                    int num_houses_to_sell = env->properties[i].houses;
-                    int sell_value_per_house = house_cost / 2; // Sell for half cost
-                    int money_from_houses = num_houses_to_sell * sell_value_per_house;
-
-                    env->money[p] += money_from_houses;
-                    env->properties[i].houses = 0; // Remove all houses/hotel
-                    houses_sold_total_value += money_from_houses;
-
-                    snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                             "Sold %d houses/hotel on %s (%d) for $%d. ",
-                             num_houses_to_sell, env->properties[i].name, i, money_from_houses);
-
-                    // Check if solvent after selling houses on this property
-                    if (env->money[p] >= 0) {
-                        bankruptcy_resolved = true;
-                        snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                                 "Player %d is now solvent ($%d) after selling houses. ", p, env->money[p]);
-                        break; // Stop selling houses
-                    }
-                }
-            }
-        }
-
-        // --- Phase 2: Sell Properties (like mortgaging, sell for half price) ---
-        if (!bankruptcy_resolved && env->money[p] < 0) {
-            snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                     "Still bankrupt after selling houses. Selling properties. ");
-
-            int properties_sold_total_value = 0;
-            // Sell in board order
-            for (int i = 0; i < env->board_size; ++i) {
-                 if (env->properties[i].owner == p) {
-                     // Can only sell if it has NO houses (should be true after Phase 1)
-                     if (env->properties[i].houses == 0 && env->properties[i].price > 0) {
-                        int sell_price = env->properties[i].price / 2; // Sell for half purchase price
-                        env->money[p] += sell_price;
-                        env->properties[i].owner = -1; // Forfeit property to bank
-                        properties_sold_total_value += sell_price;
-                        snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                                 "Sold property %s (%d) for $%d. ", env->properties[i].name, i, sell_price);
-
-                        // Check if solvent after selling this property
-                        if (env->money[p] >= 0) {
-                            bankruptcy_resolved = true;
-                             snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                                     "Player %d is now solvent ($%d) after selling properties. ", p, env->money[p]);
-                            break; // Stop selling properties
-                        }
-                    } else if (env->properties[i].houses > 0) {
-                         // Should not happen if Phase 1 worked correctly
-                         snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                                  "Skipped selling %s (%d) because it still has houses (error?). ", env->properties[i].name, i);
-                    }
-                 }
-                 // If still bankrupt after checking all properties, loop finishes
-                 if (bankruptcy_resolved) break;
-            }
-        }
-
-        // --- Final Verdict ---
-        if (!bankruptcy_resolved && env->money[p] < 0) {
-             // Still bankrupt after selling everything possible
-             env->done = true; // Set game end flag
-             card_reward_contribution -= 1000; // Apply bankruptcy penalty AFTER trying to resolve
-             snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                      "Player %d could not raise enough funds. Final balance: $%d. Game Over! ", p, env->money[p]);
-             // Ensure all properties are forfeited
-             for (int i = 0; i < env->board_size; ++i) {
-                  if (env->properties[i].owner == p) {
-                      env->properties[i].owner = -1;
-                      env->properties[i].houses = 0;
-                  }
-             }
-        } else if (bankruptcy_resolved) {
-             // Player managed to survive this time
-             snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                      "Player %d survived bankruptcy. Current balance: $%d. ", p, env->money[p]);
-        }
-    }
-
-
-    // --- Finalize Step ---
-    env->steps_taken++;
-    result.reward = current_step_reward + card_reward_contribution; // Combine base reward and card/fee effects
+    // The turn itself is the rules core's; the log entry is rebuilt from its record
+    StepRecord rec;
+    result.reward = env_play_turn(env, action, &rec);
     result.done = env->done;
-
-    // Create the log entry for this step
-    env->last_log = create_log_entry(env, p, prev_position, dice_total, landed_position_this_turn, env->positions[p],
-                                     money_before_turn, env->money[p], result.reward, fee_paid_this_turn,
-                                     log_buffer, action, card_name_drawn, card_spec_desc_drawn);
+    rec.num_owned = (unsigned char)count_owned_properties(env, rec.player);
+    decode_step_record(&rec, 0, env, &env->last_log); // Episode ID is set by the caller
     result.log = env->last_log;
 
-
-    // Get the observation for the *next* state
+    // Get the observation for the *next* state, then advance the player
     get_observation(env, obs);
-
-    // Advance player ONLY if the game is not done
-    if (!env->done) {
-        next_player(env);
-    }
-
+    env_pass_turn(env, &rec);
     return result;
 }
 
@@ -891,16 +1086,16 @@ void render_monopoly_env(MonopolyEnv* env) {
 
     printf("  Board Owners (-1 = Bank/None):\n");
     printf("  [ ");
-    for (int i = 0; i < 10; ++i) printf("%2d ", env->properties[i].owner);
+    for (int i = 0; i < 10; ++i) printf("%2d ", env->owner[i]);
     printf("]\n");
     printf("  [ ");
-    for (int i = 10; i < 20; ++i) printf("%2d ", env->properties[i].owner);
+    for (int i = 10; i < 20; ++i) printf("%2d ", env->owner[i]);
     printf("]\n");
     printf("  [ ");
-    for (int i = 20; i < 30; ++i) printf("%2d ", env->properties[i].owner);
+    for (int i = 20; i < 30; ++i) printf("%2d ", env->owner[i]);
     printf("]\n");
     printf("  [ ");
-    for (int i = 30; i < 40; ++i) printf("%2d ", env->properties[i].owner);
+    for (int i = 30; i < 40; ++i) printf("%2d ", env->owner[i]);
     printf("]\n");
     printf("----------------------------------------\n");
 
@@ -913,251 +1108,771 @@ void render_monopoly_env(MonopolyEnv* env) {
 }
 
 
-// --- Agent Data Structures ---
-
-// Represents the simplified state used as a key in the Q-table
-typedef struct {
-    int position;
-    int money_bin; // Discretized money
-    int current_prop_owner; // Owner of the property player is on (-1, 0, 1, ...)
-    int in_jail; // 0 or 1
-} StateTuple;
-
-// Data stored for each ACTION within a state entry in the Q-table
-typedef struct {
-    double sum_returns;
-    int count;
-    double q_value; // q_value = sum_returns / count
-} QValueData;
-
-// An entry in the Q-value hash table (using chaining for collisions)
-typedef struct QTableEntry {
-    StateTuple key;
-    QValueData values[2]; // Index 0 for action 0 (Pass), 1 for action 1 (Buy)
-    struct QTableEntry* next; // Pointer for chaining
-} QTableEntry;
-
-// The Q-value hash table structure
-typedef struct {
-    QTableEntry** table;
-    int size;
-    int count; // Number of entries
-} QHashTable;
+// --- Batched Environment (SIMD lockstep) ---
 
-// Represents a (StateTuple, action) pair for the visited set during update
+// ENV_BATCH_LANES games stepped together by step_monopoly_env_batch. Per-game state is laid out
+// [index][lane] so one load covers 8 lanes, and the SIMD kernel gathers from the env's BoardTables.
+// A lane follows step_monopoly_env exactly, draw for draw, but builds no log: it is the training
+// engine for episodes that are not logged.
 typedef struct {
-    StateTuple state;
-    int action;
-} VisitedKey;
-
-// An entry in the visited set hash table (using chaining)
-typedef struct VisitedSetEntry {
-    VisitedKey key;
-    struct VisitedSetEntry* next;
-} VisitedSetEntry;
+    // Configuration and board tables shared by every lane (copied from a MonopolyEnv)
+    BoardTables board;
+    int start_money;
+    int obs_money_high;
+    unsigned int key[2];                    // Philox key, i.e. the run seed
+    bool use_simd;                          // AVX2 kernel instead of the portable lane loop
+
+    // Per-lane game state
+    int positions[MAX_PLAYERS][ENV_BATCH_LANES];
+    int money[MAX_PLAYERS][ENV_BATCH_LANES];
+    int in_jail[MAX_PLAYERS][ENV_BATCH_LANES];
+    int jail_counters[MAX_PLAYERS][ENV_BATCH_LANES];
+    int owner[BOARD_SIZE][ENV_BATCH_LANES];
+    int houses[BOARD_SIZE][ENV_BATCH_LANES];
+    int current_player[ENV_BATCH_LANES];
+    int last_player[ENV_BATCH_LANES];       // Player whose move produced the lane's current observation
+    int steps_taken[ENV_BATCH_LANES];
+    int properties_bought[ENV_BATCH_LANES];
+    int episode_id[ENV_BATCH_LANES];
+    int active[ENV_BATCH_LANES];            // -1 while the lane's game runs, 0 once it ended (a SIMD mask)
+
+    // This step's random words: draws[k][lane] is draw k of the lane's (episode, step) stream
+    unsigned int draws[ENV_BATCH_STEP_DRAWS][ENV_BATCH_LANES];
+    int cursor[ENV_BATCH_LANES];            // Draws the lane has consumed this step
+} MonopolyEnvBatch;
+
+// True when this CPU can run the AVX2 kernel
+static bool env_batch_simd_available(void) {
+#ifdef ENV_BATCH_HAVE_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
 
-// The visited set hash table structure
-typedef struct {
-    VisitedSetEntry** table;
-    int size;
-    int count;
-} VisitedSet;
+// Create a batch with env's configuration, board, decks and random key (seed env first).
+// want_simd selects the AVX2 kernel when the CPU has it and both deck sizes are powers of two.
+MonopolyEnvBatch* create_monopoly_env_batch(const MonopolyEnv* env, bool want_simd) {
+    MonopolyEnvBatch* b = (MonopolyEnvBatch*)calloc(1, sizeof(MonopolyEnvBatch));
+    if (!b) {
+        perror("Failed to allocate memory for MonopolyEnvBatch");
+        return NULL;
+    }
+    b->board = env->board;
+    b->start_money = env->start_money;
+    b->obs_money_high = env->obs_money_high;
+    b->key[0] = env->rng.key[0];
+    b->key[1] = env->rng.key[1];
+    const int* deck_size = b->board.deck_size;
+    bool pow2_decks = (deck_size[1] & (deck_size[1] - 1)) == 0 && (deck_size[2] & (deck_size[2] - 1)) == 0;
+    b->use_simd = want_simd && pow2_decks && env_batch_simd_available();
+    return b;
+}
 
+// Destroy a batch
+void destroy_monopoly_env_batch(MonopolyEnvBatch* b) {
+    free(b);
+}
 
-// Structure to hold one step of an episode's history
-typedef struct {
-    StateTuple state; // The state tuple *before* taking the action
-    int action;
-    double reward;
-} EpisodeStep;
+// Start a new game on one lane; its random stream is that of episode_id
+void reset_monopoly_env_batch_lane(MonopolyEnvBatch* b, int lane, int episode_id) {
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        b->positions[i][lane] = 0;
+        b->money[i][lane] = b->start_money;
+        b->in_jail[i][lane] = 0;
+        b->jail_counters[i][lane] = 0;
+    }
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        b->owner[i][lane] = -1;
+        b->houses[i][lane] = 0;
+    }
+    b->current_player[lane] = 0;
+    b->last_player[lane] = 0;
+    b->steps_taken[lane] = 0;
+    b->properties_bought[lane] = 0;
+    b->episode_id[lane] = episode_id;
+    b->active[lane] = -1;
+    b->cursor[lane] = 0;
+}
 
-// Structure to hold the history of an entire episode
-typedef struct {
-    EpisodeStep* steps;
-    int count;
-    int capacity;
-} EpisodeHistory;
+// Start episodes first_episode .. first_episode + count - 1 on lanes 0 .. count - 1; the other lanes idle
+void reset_monopoly_env_batch(MonopolyEnvBatch* b, int first_episode, int count) {
+    for (int lane = 0; lane < ENV_BATCH_LANES; ++lane) {
+        reset_monopoly_env_batch_lane(b, lane, first_episode + lane);
+        if (lane >= count) b->active[lane] = 0;
+    }
+}
 
+// get_observation for a lane: positions, clamped money, jail flags, owners and the player who last moved
+// (the current player of a MonopolyEnv at the time its observation is taken)
+void get_observation_batch(const MonopolyEnvBatch* b, int lane, int* obs) {
+    int k = 0;
+    for (int i = 0; i < b->board.num_players; ++i) obs[k++] = b->positions[i][lane];
+    for (int i = 0; i < b->board.num_players; ++i) {
+        obs[k++] = (b->money[i][lane] > b->obs_money_high) ? b->obs_money_high : b->money[i][lane];
+    }
+    for (int i = 0; i < b->board.num_players; ++i) obs[k++] = b->in_jail[i][lane];
+    for (int i = 0; i < BOARD_SIZE; ++i) obs[k++] = b->owner[i][lane];
+    obs[k++] = b->last_player[lane];
+}
 
-// The Monte Carlo Agent structure
-typedef struct {
-    double epsilon;
-    int num_players;
-    QHashTable* q_table; // Pointer to the Q-value hash table
-} MonteCarloAgent;
+// Next value of a lane's random stream in [0, 2^31), as env_rand
+static inline int env_batch_rand(MonopolyEnvBatch* b, int lane) {
+    return (int)(b->draws[b->cursor[lane]++][lane] >> 1);
+}
 
+// Uniform double in [0, 1) from one draw, as philox_stream_uniform
+static inline double env_batch_uniform(MonopolyEnvBatch* b, int lane) {
+    return b->draws[b->cursor[lane]++][lane] * (1.0 / 4294967296.0);
+}
 
-// --- Hash Table & State Tuple Helper Functions ---
+// The rules core's view of one lane: player p is at [p * ENV_BATCH_LANES] from &positions[0][lane]
+static inline GameState env_batch_game_state(MonopolyEnvBatch* b, int lane) {
+    return (GameState){&b->positions[0][lane], &b->money[0][lane], &b->in_jail[0][lane], &b->jail_counters[0][lane],
+                       &b->owner[0][lane], &b->houses[0][lane], ENV_BATCH_LANES};
+}
 
-// Hash function for StateTuple
-static unsigned int hash_state_tuple(StateTuple s, int table_size) {
-    // Simple combination hash - adjust multipliers for better distribution if needed
-    unsigned int hash = 17;
-    hash = (hash * 31 + s.position) % table_size;
-    hash = (hash * 31 + s.money_bin) % table_size;
-    // Add 10 to owner to handle -1 gracefully in hashing (avoids negative intermediate)
-    hash = (hash * 31 + (s.current_prop_owner + 10)) % table_size;
-    hash = (hash * 31 + s.in_jail) % table_size;
-    return hash;
+// Common end of a lane's turn by player p: purchase count, game over on bankruptcy and the turn order
+static double env_batch_end_turn(MonopolyEnvBatch* b, int lane, int p, unsigned int events, int reward) {
+    if (events & STEP_EVT_BOUGHT) b->properties_bought[lane]++;
+    if (events & STEP_EVT_BANKRUPT) b->active[lane] = 0;
+    b->last_player[lane] = p;
+    b->steps_taken[lane]++;
+    if (b->active[lane]) b->current_player[lane] = (p + 1) % b->board.num_players;
+    return (double)reward;
 }
 
-// Comparison function for StateTuple
-static bool compare_state_tuples(StateTuple s1, StateTuple s2) {
-    return s1.position == s2.position &&
-           s1.money_bin == s2.money_bin &&
-           s1.current_prop_owner == s2.current_prop_owner &&
-           s1.in_jail == s2.in_jail;
+// Portable step of one lane with the rules core (the reference the SIMD kernel is checked against)
+static double env_batch_step_lane(MonopolyEnvBatch* b, int lane, int action) {
+    int p = b->current_player[lane];
+    StepDraws draws = {NULL, &b->draws[0][lane], &b->cursor[lane]};
+    StepRecord rec;
+    int reward = play_turn(&b->board, env_batch_game_state(b, lane), p, action, &draws, &rec);
+    return env_batch_end_turn(b, lane, p, rec.events, reward);
 }
 
-// Create a new Q-value hash table
-static QHashTable* create_q_hash_table(int size) {
-    QHashTable* ht = (QHashTable*)malloc(sizeof(QHashTable));
-    if (!ht) return NULL;
-    ht->size = size;
-    ht->count = 0;
-    ht->table = (QTableEntry**)calloc(size, sizeof(QTableEntry*)); // Initialize all to NULL
-    if (!ht->table) {
-        free(ht);
-        return NULL;
+// Philox blocks 0 and 1 of every active lane's (episode, step) counter
+static void env_batch_draw_lanes(MonopolyEnvBatch* b) {
+    for (int lane = 0; lane < ENV_BATCH_LANES; ++lane) {
+        if (!b->active[lane]) continue;
+        for (int block = 0; block < ENV_BATCH_STEP_DRAWS / 4; ++block) {
+            unsigned int ctr[4] = {(unsigned int)b->episode_id[lane], (unsigned int)b->steps_taken[lane], (unsigned int)block, 0u};
+            unsigned int out[4];
+            philox4x32_10(ctr, b->key[0], b->key[1], out);
+            for (int k = 0; k < 4; ++k) b->draws[block * 4 + k][lane] = out[k];
+        }
     }
-    return ht;
 }
 
-// Find or create an entry in the Q-value hash table
-static QTableEntry* find_or_create_q_entry(QHashTable* ht, StateTuple key) {
-    unsigned int index = hash_state_tuple(key, ht->size);
-    QTableEntry* entry = ht->table[index];
+// Outcome of the vector part of a step for 8 lanes, one element per lane (masks are 0 or -1)
+typedef struct {
+    int player[8];
+    int position[8];
+    int money[8];
+    int reward[8];
+    int jail_counter[8];
+    int in_jail[8];
+    int stays[8];      // Turn spent in jail (settle_debt sells nothing)
+    int buys[8];
+    int builds[8];
+    int owner[8];      // Owner of the final square
+    int payment[8];    // Rent paid to owner
+    int pays_rent[8];
+} EnvBatchStepOut;
+
+#ifdef ENV_BATCH_HAVE_AVX2
+// Unsigned 32x32 -> 64 products of 8 lanes: returns the high words, stores the low words in *lo
+__attribute__((target("avx2")))
+static inline __m256i mm256_mulhilo_epu32(__m256i a, __m256i m, __m256i* lo) {
+    __m256i even = _mm256_mul_epu32(a, m);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+    *lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
 
-    // Search existing chain
-    while (entry != NULL) {
-        if (compare_state_tuples(entry->key, key)) {
-            return entry; // Found it
+// env_batch_draw_lanes for 8 lanes per Philox evaluation
+__attribute__((target("avx2")))
+static void env_batch_draw_avx2(MonopolyEnvBatch* b) {
+    for (int l0 = 0; l0 < ENV_BATCH_LANES; l0 += 8) {
+        for (int block = 0; block < ENV_BATCH_STEP_DRAWS / 4; ++block) {
+            __m256i c0 = _mm256_loadu_si256((const __m256i*)&b->episode_id[l0]);
+            __m256i c1 = _mm256_loadu_si256((const __m256i*)&b->steps_taken[l0]);
+            __m256i c2 = _mm256_set1_epi32(block);
+            __m256i c3 = _mm256_setzero_si256();
+            unsigned int k0 = b->key[0], k1 = b->key[1];
+            for (int round = 0; round < 10; ++round) {
+                __m256i lo0, lo1;
+                __m256i hi0 = mm256_mulhilo_epu32(c0, _mm256_set1_epi32((int)PHILOX_M0), &lo0);
+                __m256i hi1 = mm256_mulhilo_epu32(c2, _mm256_set1_epi32((int)PHILOX_M1), &lo1);
+                c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32((int)k0));
+                c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32((int)k1));
+                c1 = lo1;
+                c3 = lo0;
+                k0 += PHILOX_W0;
+                k1 += PHILOX_W1;
+            }
+            _mm256_storeu_si256((__m256i*)&b->draws[block * 4 + 0][l0], c0);
+            _mm256_storeu_si256((__m256i*)&b->draws[block * 4 + 1][l0], c1);
+            _mm256_storeu_si256((__m256i*)&b->draws[block * 4 + 2][l0], c2);
+            _mm256_storeu_si256((__m256i*)&b->draws[block * 4 + 3][l0], c3);
         }
-        entry = entry->next;
     }
+}
 
-    // Not found, create a new entry
-    QTableEntry* new_entry = (QTableEntry*)malloc(sizeof(QTableEntry));
-    if (!new_entry) return NULL; // Allocation failed
+// Draw at each lane's cursor (+ offset) as env_rand would return it
+__attribute__((target("avx2")))
+static inline __m256i mm256_batch_rand(const MonopolyEnvBatch* b, __m256i draw_idx, int offset) {
+    __m256i idx = _mm256_add_epi32(draw_idx, _mm256_set1_epi32(offset * ENV_BATCH_LANES));
+    return _mm256_srli_epi32(_mm256_i32gather_epi32((const int*)&b->draws[0][0], idx, 4), 1);
+}
 
-    new_entry->key = key;
-    // Initialize Q-value data (sum=0, count=0, q=0)
-    memset(new_entry->values, 0, sizeof(new_entry->values));
-    new_entry->next = ht->table[index]; // Link into chain (at the front)
-    ht->table[index] = new_entry;
-    ht->count++;
+// DiceTransition of each lane's roll from square pos, drawn at its cursor as play_turn would
+__attribute__((target("avx2")))
+static inline __m256i mm256_batch_transition(const MonopolyEnvBatch* b, __m256i draw_idx, __m256i pos) {
+    __m256i lo;
+    __m256i roll = mm256_mulhilo_epu32(_mm256_i32gather_epi32((const int*)&b->draws[0][0], draw_idx, 4),
+                                       _mm256_set1_epi32(DICE_OUTCOMES), &lo);
+    __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(pos, _mm256_set1_epi32(DICE_OUTCOMES)), roll);
+    return _mm256_i32gather_epi32((const int*)&b->board.transitions[0][0], idx, 4);
+}
 
-    return new_entry;
+// Step lanes l0 .. l0 + 7 at once: play_turn up to the debt, computed under lane masks with gathers from
+// the BoardTables into *out. The per-lane stores (AVX2 has no scatter) and the rare debt settlement are
+// then done by env_batch_apply_lane.
+__attribute__((target("avx2")))
+static void env_batch_step_avx2(MonopolyEnvBatch* b, int l0, const int* actions, EnvBatchStepOut* out) {
+    const BoardTables* t = &b->board;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i jail_pos = _mm256_set1_epi32(t->jail_position);
+    const __m256i lanes = _mm256_add_epi32(_mm256_set1_epi32(l0), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i stride = _mm256_set1_epi32(ENV_BATCH_LANES);
+
+    __m256i active = _mm256_loadu_si256((const __m256i*)&b->active[l0]);
+    __m256i p = _mm256_loadu_si256((const __m256i*)&b->current_player[l0]);
+    __m256i p_idx = _mm256_add_epi32(_mm256_mullo_epi32(p, stride), lanes); // [p][lane]
+    __m256i pos0 = _mm256_i32gather_epi32(&b->positions[0][0], p_idx, 4);
+    __m256i money = _mm256_i32gather_epi32(&b->money[0][0], p_idx, 4);
+    __m256i count = _mm256_i32gather_epi32(&b->jail_counters[0][0], p_idx, 4);
+    __m256i jailed = _mm256_and_si256(active, _mm256_cmpeq_epi32(_mm256_i32gather_epi32(&b->in_jail[0][0], p_idx, 4), one));
+    __m256i cursor = _mm256_loadu_si256((const __m256i*)&b->cursor[l0]);
+    __m256i reward = zero;
+
+    // Jail: one roll, released on doubles or at the turn limit (which costs the fee)
+    const __m256i doubles_flag = _mm256_set1_epi32(DICE_DOUBLES << 24);
+    __m256i draw_idx = _mm256_add_epi32(_mm256_mullo_epi32(cursor, stride), lanes);
+    __m256i doubles = _mm256_cmpeq_epi32(_mm256_and_si256(mm256_batch_transition(b, draw_idx, pos0), doubles_flag), doubles_flag);
+    __m256i jail_count = _mm256_add_epi32(count, one);
+    __m256i at_limit = _mm256_cmpgt_epi32(jail_count, _mm256_set1_epi32(t->jail_turns - 1));
+    __m256i released = _mm256_and_si256(jailed, _mm256_or_si256(doubles, at_limit));
+    __m256i pays_fee = _mm256_andnot_si256(doubles, released);
+    __m256i stays = _mm256_andnot_si256(released, jailed);
+    money = _mm256_sub_epi32(money, _mm256_and_si256(pays_fee, _mm256_set1_epi32(JAIL_FEE)));
+    reward = _mm256_sub_epi32(reward, _mm256_and_si256(pays_fee, _mm256_set1_epi32(JAIL_FEE)));
+    count = _mm256_blendv_epi8(count, _mm256_and_si256(stays, jail_count), jailed);
+    cursor = _mm256_add_epi32(cursor, _mm256_and_si256(jailed, one));
+
+    // Dice, movement and GO: one transition table entry per lane
+    const __m256i go_flag = _mm256_set1_epi32(DICE_PASSES_GO << 24);
+    __m256i movers = _mm256_andnot_si256(stays, active);
+    draw_idx = _mm256_add_epi32(_mm256_mullo_epi32(cursor, stride), lanes);
+    __m256i move = mm256_batch_transition(b, draw_idx, pos0);
+    cursor = _mm256_add_epi32(cursor, _mm256_and_si256(movers, one));
+    __m256i landed = _mm256_and_si256(move, _mm256_set1_epi32(0xFF));
+    __m256i passed_go = _mm256_and_si256(movers, _mm256_cmpeq_epi32(_mm256_and_si256(move, go_flag), go_flag));
+    __m256i go_money = _mm256_and_si256(passed_go, _mm256_set1_epi32(t->go_reward));
+    money = _mm256_add_epi32(money, go_money);
+    reward = _mm256_add_epi32(reward, go_money);
+    __m256i pos = _mm256_blendv_epi8(pos0, landed, movers);
+
+    // Cards: gather the drawn CardEffect (op, target and amount packed low byte first in one int) and
+    // apply it with apply_card_effect's selects
+    const __m256i board = _mm256_set1_epi32(t->board_size);
+    __m256i deck = _mm256_and_si256(movers, _mm256_i32gather_epi32(t->deck, pos, 4));
+    __m256i has_card = _mm256_andnot_si256(_mm256_cmpeq_epi32(deck, zero), movers);
+    draw_idx = _mm256_add_epi32(_mm256_mullo_epi32(cursor, stride), lanes);
+    __m256i card_mask = _mm256_sub_epi32(_mm256_i32gather_epi32(t->deck_size, deck, 4), one);
+    __m256i card = _mm256_add_epi32(_mm256_mullo_epi32(deck, _mm256_set1_epi32(MAX_DECK_SIZE)),
+                                    _mm256_and_si256(mm256_batch_rand(b, draw_idx, 0), card_mask));
+    cursor = _mm256_add_epi32(cursor, _mm256_and_si256(has_card, one));
+    __m256i effect = _mm256_i32gather_epi32((const int*)&t->cards[0][0], card, 4);
+    __m256i card_op = _mm256_and_si256(effect, _mm256_set1_epi32(0xFF));
+    __m256i target = _mm256_and_si256(_mm256_srli_epi32(effect, 8), _mm256_set1_epi32(0xFF));
+    __m256i amount = _mm256_srai_epi32(effect, 16);
+    __m256i card_cash = _mm256_and_si256(has_card, _mm256_cmpeq_epi32(card_op, _mm256_set1_epi32(CARD_OP_MONEY)));
+    __m256i advances = _mm256_and_si256(has_card, _mm256_cmpeq_epi32(card_op, _mm256_set1_epi32(CARD_OP_ADVANCE)));
+    __m256i steps = _mm256_and_si256(has_card, _mm256_cmpeq_epi32(card_op, _mm256_set1_epi32(CARD_OP_MOVE)));
+    __m256i card_jail = _mm256_and_si256(has_card, _mm256_cmpeq_epi32(card_op, _mm256_set1_epi32(CARD_OP_JAIL)));
+    __m256i moved = _mm256_add_epi32(pos, amount);
+    __m256i wraps = _mm256_cmpgt_epi32(moved, _mm256_sub_epi32(board, one));
+    __m256i wrapped = _mm256_sub_epi32(_mm256_add_epi32(moved, _mm256_and_si256(_mm256_cmpgt_epi32(zero, moved), board)),
+                                       _mm256_and_si256(wraps, board));
+    __m256i card_go = _mm256_or_si256(_mm256_and_si256(advances, _mm256_cmpgt_epi32(pos, target)), _mm256_and_si256(steps, wraps));
+    card_cash = _mm256_add_epi32(_mm256_and_si256(card_cash, amount), _mm256_and_si256(card_go, _mm256_set1_epi32(t->go_reward)));
+    money = _mm256_add_epi32(money, card_cash);
+    reward = _mm256_add_epi32(reward, card_cash);
+    pos = _mm256_blendv_epi8(pos, target, advances);
+    pos = _mm256_blendv_epi8(pos, wrapped, steps);
+    pos = _mm256_blendv_epi8(pos, jail_pos, card_jail);
+
+    // Square action: Go To Jail, tax, then property (buy, rent or a house)
+    __m256i sent_jail = _mm256_and_si256(movers, _mm256_cmpeq_epi32(pos, _mm256_set1_epi32(t->go_to_jail_position)));
+    __m256i fee = _mm256_i32gather_epi32(t->fee, pos, 4);
+    __m256i taxed = _mm256_andnot_si256(sent_jail, _mm256_and_si256(movers, _mm256_cmpgt_epi32(fee, zero)));
+    money = _mm256_sub_epi32(money, _mm256_and_si256(taxed, fee));
+    reward = _mm256_sub_epi32(reward, _mm256_and_si256(taxed, fee));
+
+    __m256i price = _mm256_i32gather_epi32(t->price, pos, 4);
+    __m256i on_property = _mm256_andnot_si256(_mm256_or_si256(sent_jail, taxed),
+                                              _mm256_and_si256(movers, _mm256_cmpgt_epi32(price, zero)));
+    __m256i sq_idx = _mm256_add_epi32(_mm256_mullo_epi32(pos, stride), lanes); // [pos][lane]
+    __m256i owner = _mm256_i32gather_epi32(&b->owner[0][0], sq_idx, 4);
+    __m256i houses = _mm256_i32gather_epi32(&b->houses[0][0], sq_idx, 4);
+    __m256i wants_buy = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)&actions[l0]), one);
+    __m256i unowned = _mm256_and_si256(on_property, _mm256_cmpeq_epi32(owner, _mm256_set1_epi32(-1)));
+    __m256i buys = _mm256_and_si256(_mm256_and_si256(unowned, wants_buy), _mm256_cmpgt_epi32(money, _mm256_sub_epi32(price, one)));
+    reward = _mm256_add_epi32(reward, _mm256_and_si256(buys, _mm256_set1_epi32(PURCHASE_REWARD)));
+    money = _mm256_sub_epi32(money, _mm256_and_si256(buys, price));
+
+    __m256i own_square = _mm256_and_si256(on_property, _mm256_cmpeq_epi32(owner, p));
+    __m256i pays_rent = _mm256_andnot_si256(_mm256_or_si256(unowned, own_square), on_property);
+    // rent_for_houses (houses never exceeds MAX_HOUSES, so no clamp)
+    __m256i rent_due = _mm256_mullo_epi32(_mm256_i32gather_epi32(t->rent, pos, 4), _mm256_i32gather_epi32(rent_multipliers, houses, 4));
+    __m256i payment = _mm256_and_si256(pays_rent, _mm256_min_epi32(money, rent_due));
+    money = _mm256_sub_epi32(money, payment);
+    reward = _mm256_sub_epi32(reward, payment);
+
+    __m256i house_cost = _mm256_i32gather_epi32(t->house_cost, pos, 4);
+    __m256i builds = _mm256_and_si256(_mm256_and_si256(own_square, wants_buy),
+                     _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(house_cost, zero), _mm256_cmpgt_epi32(money, _mm256_sub_epi32(house_cost, one))),
+                                      _mm256_cmpgt_epi32(_mm256_set1_epi32(MAX_HOUSES), houses)));
+    money = _mm256_sub_epi32(money, _mm256_and_si256(builds, house_cost));
+
+    __m256i jailed_now = _mm256_or_si256(_mm256_or_si256(sent_jail, card_jail), stays);
+    pos = _mm256_blendv_epi8(pos, jail_pos, sent_jail);
+    count = _mm256_andnot_si256(_mm256_or_si256(sent_jail, card_jail), count);
+
+    _mm256_storeu_si256((__m256i*)out->player, p);
+    _mm256_storeu_si256((__m256i*)out->position, pos);
+    _mm256_storeu_si256((__m256i*)out->money, money);
+    _mm256_storeu_si256((__m256i*)out->reward, reward);
+    _mm256_storeu_si256((__m256i*)out->jail_counter, count);
+    _mm256_storeu_si256((__m256i*)out->in_jail, jailed_now);
+    _mm256_storeu_si256((__m256i*)out->stays, stays);
+    _mm256_storeu_si256((__m256i*)out->buys, buys);
+    _mm256_storeu_si256((__m256i*)out->builds, builds);
+    _mm256_storeu_si256((__m256i*)out->owner, owner);
+    _mm256_storeu_si256((__m256i*)out->payment, payment);
+    _mm256_storeu_si256((__m256i*)out->pays_rent, pays_rent);
+    _mm256_storeu_si256((__m256i*)&b->cursor[l0], cursor);
+}
+#endif
+
+// Apply one lane of an env_batch_step_avx2 result (kept out of the AVX2 function so the scalar
+// stores and calls do not run with dirty upper vector state)
+static double env_batch_apply_lane(MonopolyEnvBatch* b, int lane, const EnvBatchStepOut* out, int k) {
+    int p = out->player[k];
+    int pos = out->position[k];
+    if (out->buys[k]) {
+        b->owner[pos][lane] = p;
+        b->houses[pos][lane] = 0;
+        b->properties_bought[lane]++;
+    }
+    if (out->builds[k]) b->houses[pos][lane]++;
+    if (out->pays_rent[k]) b->money[out->owner[k]][lane] += out->payment[k];
+    b->in_jail[p][lane] = out->in_jail[k] ? 1 : 0;
+    b->jail_counters[p][lane] = out->jail_counter[k];
+    int money = out->money[k], reward = out->reward[k];
+    unsigned int events = out->buys[k] ? STEP_EVT_BOUGHT : 0;
+    if (money < 0) {
+        StepRecord sales = {0};
+        events |= settle_debt(&b->board, env_batch_game_state(b, lane), p, !out->stays[k], &money, &reward, &sales);
+    }
+    b->positions[p][lane] = pos;
+    b->money[p][lane] = money;
+    return env_batch_end_turn(b, lane, p, events, reward);
 }
 
+// Prepare this step's random words for every running lane (call before choosing the lanes' actions)
+void begin_step_monopoly_env_batch(MonopolyEnvBatch* b) {
+    memset(b->cursor, 0, sizeof(b->cursor));
+#ifdef ENV_BATCH_HAVE_AVX2
+    if (b->use_simd) {
+        env_batch_draw_avx2(b);
+        return;
+    }
+#endif
+    env_batch_draw_lanes(b);
+}
 
-// Destroy the Q-value hash table
-static void destroy_q_hash_table(QHashTable* ht) {
-    if (!ht) return;
-    for (int i = 0; i < ht->size; ++i) {
-        QTableEntry* entry = ht->table[i];
-        while (entry != NULL) {
-            QTableEntry* temp = entry;
-            entry = entry->next;
-            free(temp);
+// Step every running lane with its action (0 = Pass, 1 = Buy); rewards[lane] is 0 for idle lanes.
+// A lane whose game ends is marked inactive and keeps its final state.
+void step_monopoly_env_batch(MonopolyEnvBatch* b, const int* actions, double* rewards) {
+    for (int l0 = 0; l0 < ENV_BATCH_LANES; l0 += 8) {
+#ifdef ENV_BATCH_HAVE_AVX2
+        if (b->use_simd) {
+            EnvBatchStepOut out;
+            env_batch_step_avx2(b, l0, actions, &out);
+            for (int k = 0; k < 8; ++k) {
+                int lane = l0 + k;
+                rewards[lane] = b->active[lane] ? env_batch_apply_lane(b, lane, &out, k) : 0.0;
+            }
+            continue;
+        }
+#endif
+        for (int lane = l0; lane < l0 + 8; ++lane) {
+            rewards[lane] = b->active[lane] ? env_batch_step_lane(b, lane, actions[lane]) : 0.0;
         }
     }
-    free(ht->table);
-    free(ht);
 }
 
 
-// --- Visited Set Hash Table Functions ---
+// --- Vectorized Environment API ---
+// Many games behind one handle for foreign callers (the Python binding in "Python Sequential Code.py").
+// Build the engine as a shared library with
+//     gcc -O2 -shared -fPIC -DMONOPOLY_LIBRARY monopoly.c -o libmonopoly.so -lm -pthread
+// reset and step write straight into caller-owned arrays: obs is num_envs * obs_size ints in the
+// get_observation layout, rewards num_envs doubles, dones num_envs bytes. Nothing is allocated per call.
 
-// Hash function for VisitedKey
-static unsigned int hash_visited_key(VisitedKey k, int table_size) {
-     unsigned int state_hash = hash_state_tuple(k.state, table_size);
-     // Combine state hash with action
-     unsigned int hash = (state_hash * 31 + k.action) % table_size;
-     return hash;
+typedef struct {
+    int num_envs;
+    int obs_size;
+    int num_batches;           // ceil(num_envs / ENV_BATCH_LANES); env i is lane i % ENV_BATCH_LANES of batch i / ENV_BATCH_LANES
+    MonopolyEnvBatch** batches;
+    unsigned int* games;       // Games env i has started; game g of env i uses episode stream g * num_envs + i
+} MonopolyVecEnv;
+
+// Game g of env i gets its own random stream
+static int vec_env_episode_id(const MonopolyVecEnv* venv, int env_index) {
+    return (int)(venv->games[env_index] * (unsigned int)venv->num_envs + (unsigned int)env_index);
 }
 
-// Comparison function for VisitedKey
-static bool compare_visited_keys(VisitedKey k1, VisitedKey k2) {
-    return k1.action == k2.action && compare_state_tuples(k1.state, k2.state);
+// Destroy a vectorized environment
+void monopoly_vec_env_destroy(MonopolyVecEnv* venv) {
+    if (!venv) return;
+    for (int i = 0; venv->batches && i < venv->num_batches; ++i) destroy_monopoly_env_batch(venv->batches[i]);
+    free(venv->batches);
+    free(venv->games);
+    free(venv);
 }
 
-// Create a new visited set hash table
-static VisitedSet* create_visited_set(int size) {
-    VisitedSet* vs = (VisitedSet*)malloc(sizeof(VisitedSet));
-    if (!vs) return NULL;
-    vs->size = size;
-    vs->count = 0;
-    vs->table = (VisitedSetEntry**)calloc(size, sizeof(VisitedSetEntry*));
-    if (!vs->table) {
-        free(vs);
+// Create num_envs games with the C engine's rules and a seeded stream per game (NULL on invalid arguments)
+MonopolyVecEnv* monopoly_vec_env_create(int num_envs, int num_players, int start_money, int go_reward, unsigned long long seed) {
+    if (num_envs <= 0) {
+        fprintf(stderr, "Error: Invalid number of environments (%d).\n", num_envs);
         return NULL;
     }
-    return vs;
-}
-
-// Check if a key exists and add it if it doesn't (returns true if it was already present)
-static bool check_and_add_visited(VisitedSet* vs, VisitedKey key) {
-    unsigned int index = hash_visited_key(key, vs->size);
-    VisitedSetEntry* entry = vs->table[index];
+    MonopolyEnv* env = create_monopoly_env(num_players, start_money, go_reward); // Template for every batch
+    if (!env) return NULL;
+    seed_monopoly_env(env, seed);
 
-    // Search chain
-    while (entry != NULL) {
-        if (compare_visited_keys(entry->key, key)) {
-            return true; // Already visited
-        }
-        entry = entry->next;
+    MonopolyVecEnv* venv = (MonopolyVecEnv*)calloc(1, sizeof(MonopolyVecEnv));
+    if (!venv) {
+        destroy_monopoly_env(env);
+        return NULL;
     }
+    venv->num_envs = num_envs;
+    venv->obs_size = get_observation_size(num_players);
+    venv->num_batches = (num_envs + ENV_BATCH_LANES - 1) / ENV_BATCH_LANES;
+    venv->batches = (MonopolyEnvBatch**)calloc(venv->num_batches, sizeof(MonopolyEnvBatch*));
+    venv->games = (unsigned int*)calloc(num_envs, sizeof(unsigned int));
+    bool ok = venv->batches && venv->games;
+    for (int i = 0; ok && i < venv->num_batches; ++i) {
+        venv->batches[i] = create_monopoly_env_batch(env, true);
+        ok = venv->batches[i] != NULL;
+    }
+    destroy_monopoly_env(env);
+    if (!ok) {
+        fprintf(stderr, "Error: Failed to allocate %d environments.\n", num_envs);
+        monopoly_vec_env_destroy(venv);
+        return NULL;
+    }
+    return venv;
+}
 
-    // Not visited, add it
-    VisitedSetEntry* new_entry = (VisitedSetEntry*)malloc(sizeof(VisitedSetEntry));
-    if (!new_entry) return false; // Allocation error, treat as not visited
-
-    new_entry->key = key;
-    new_entry->next = vs->table[index];
-    vs->table[index] = new_entry;
-    vs->count++;
+// Ints per game in obs
+int monopoly_vec_env_obs_size(const MonopolyVecEnv* venv) {
+    return venv->obs_size;
+}
 
-    return false; // Was not previously visited
+// Start a new game in every env and write the initial observations
+void monopoly_vec_env_reset(MonopolyVecEnv* venv, int* obs) {
+    for (int i = 0; i < venv->num_envs; ++i) {
+        MonopolyEnvBatch* b = venv->batches[i / ENV_BATCH_LANES];
+        int lane = i % ENV_BATCH_LANES;
+        reset_monopoly_env_batch_lane(b, lane, vec_env_episode_id(venv, i));
+        venv->games[i]++;
+        get_observation_batch(b, lane, obs + (size_t)i * venv->obs_size);
+    }
+    // Lanes past num_envs in the last batch never play
+    for (int lane = venv->num_envs % ENV_BATCH_LANES; lane > 0 && lane < ENV_BATCH_LANES; ++lane) {
+        venv->batches[venv->num_batches - 1]->active[lane] = 0;
+    }
 }
 
-// Destroy the visited set hash table (call this after each episode update)
-static void destroy_visited_set(VisitedSet* vs) {
-     if (!vs) return;
-    for (int i = 0; i < vs->size; ++i) {
-        VisitedSetEntry* entry = vs->table[i];
-        while (entry != NULL) {
-            VisitedSetEntry* temp = entry;
-            entry = entry->next;
-            free(temp);
+// Play one turn in every env (actions: 0 = Pass, 1 = Buy). A game is done on bankruptcy or after
+// MAX_EPISODE_STEPS turns; it then restarts at once, and obs holds the new game's first observation.
+void monopoly_vec_env_step(MonopolyVecEnv* venv, const int* actions, int* obs, double* rewards, unsigned char* dones) {
+    for (int n = 0; n < venv->num_batches; ++n) {
+        MonopolyEnvBatch* b = venv->batches[n];
+        int first = n * ENV_BATCH_LANES;
+        int lanes = venv->num_envs - first < ENV_BATCH_LANES ? venv->num_envs - first : ENV_BATCH_LANES;
+        int lane_actions[ENV_BATCH_LANES] = {0};
+        double lane_rewards[ENV_BATCH_LANES];
+        memcpy(lane_actions, actions + first, lanes * sizeof(int));
+
+        begin_step_monopoly_env_batch(b);
+        step_monopoly_env_batch(b, lane_actions, lane_rewards);
+        for (int lane = 0; lane < lanes; ++lane) {
+            int i = first + lane;
+            bool done = !b->active[lane] || b->steps_taken[lane] >= MAX_EPISODE_STEPS;
+            if (done) {
+                reset_monopoly_env_batch_lane(b, lane, vec_env_episode_id(venv, i));
+                venv->games[i]++;
+            }
+            rewards[i] = lane_rewards[lane];
+            dones[i] = done ? 1 : 0;
+            get_observation_batch(b, lane, obs + (size_t)i * venv->obs_size);
         }
     }
-    free(vs->table);
-    free(vs);
 }
 
 
-// --- Episode History Functions ---
+// --- Agent Data Structures ---
 
-// Initialize episode history
-static void init_episode_history(EpisodeHistory* history, int initial_capacity) {
-    history->steps = (EpisodeStep*)malloc(initial_capacity * sizeof(EpisodeStep));
-    history->count = 0;
-    history->capacity = history->steps ? initial_capacity : 0;
-}
+// Represents the simplified state used as a key in the Q-table
+typedef struct {
+    int position;
+    int money_bin; // Discretized money
+    int current_prop_owner; // Owner of the property player is on (-1, 0, 1, ...)
+    int in_jail; // 0 or 1
+} StateTuple;
+
+// Data stored for each ACTION within a state entry in the Q-table
+typedef struct {
+    double sum_returns;
+    double sum_sq_returns; // Sum of squared returns, for q_value_std_error
+    int count;
+    double q_value; // q_value = sum_returns / count
+} QValueData;
+
+// One state of the dense Q-table; the StateTuple is implied by the entry's index
+typedef struct {
+    QValueData values[2]; // Index 0 for action 0 (Pass), 1 for action 1 (Buy)
+    bool used;            // Set once the state has been looked up through find_or_create_q_entry
+} QTableEntry;
+
+// Dense Q-table: one entry per representable StateTuple, addressed by state_tuple_index()
+typedef struct {
+    QTableEntry* entries; // Q_NUM_STATES entries, allocated once up front
+    int count; // Number of used entries
+    size_t mapped_bytes; // Non-zero when entries is a private mapping of a checkpoint
+} QTable;
+
+// One open-addressed slot of a concurrent Q-table shard
+typedef struct {
+    StateTuple key;
+    QValueData values[2]; // Only the sums and count are accumulated; q_value is derived on drain
+    bool used;
+} CQSlot;
+
+// A shard owns a disjoint part of the state space and is guarded by its own mutex
+typedef struct {
+    pthread_mutex_t lock;
+    CQSlot* slots;
+    int capacity;
+    int count;
+} CQShard;
+
+// Sharded return/count accumulator that many threads can update at once
+typedef struct {
+    CQShard shards[CQ_NUM_SHARDS];
+} ConcurrentQTable;
+
+
+// Structure to hold one step of an episode's history
+typedef struct {
+    StateTuple state; // The state tuple *before* taking the action
+    int action;
+    double reward;
+} EpisodeStep;
+
+// Structure to hold the history of an entire episode
+typedef struct {
+    EpisodeStep* steps;
+    int count;
+    int capacity;
+} EpisodeHistory;
+
+// Per-worker scratch reused by every episode: the history steps, the observation buffer and the
+// first-visit stamps of the MC update. Once created, steady-state training allocates nothing.
+typedef struct {
+    EpisodeStep* steps;           // MAX_EPISODE_STEPS entries backing the current EpisodeHistory
+    int* obs;                     // get_observation_size(num_players) ints
+    unsigned short* visit_stamps; // [Q_NUM_STATES * 2]: generation of the pass that last visited each (state, action)
+    unsigned short generation;    // Stamp of the current pass (0 is never live)
+} EpisodeArena;
+
+
+// The Monte Carlo Agent structure
+typedef struct {
+    double epsilon;
+    int num_players;
+    QTable* q_table; // Dense Q-value table
+} MonteCarloAgent;
+
+
+// --- State Tuple Helper Functions ---
+
+// Dense index of a StateTuple into [0, Q_NUM_STATES), or -1 if it falls outside the table.
+// Overflow policy: money_bin saturates into [0, Q_MONEY_BINS - 1], so balances of $16,000 and more
+// share the top bin instead of missing the table.
+static inline int state_tuple_index(StateTuple s) {
+    if (s.position < 0 || s.position >= BOARD_SIZE) return -1;
+    if (s.current_prop_owner < -1 || s.current_prop_owner >= MAX_PLAYERS) return -1;
+    if (s.in_jail < 0 || s.in_jail > 1) return -1;
+    int bin = s.money_bin < 0 ? 0 : (s.money_bin >= Q_MONEY_BINS ? Q_MONEY_BINS - 1 : s.money_bin);
+    return ((s.position * Q_MONEY_BINS + bin) * Q_OWNER_SLOTS + (s.current_prop_owner + 1)) * 2 + s.in_jail;
+}
+
+// Inverse of state_tuple_index
+static inline StateTuple state_tuple_from_index(int idx) {
+    StateTuple s;
+    s.in_jail = idx % 2;
+    idx /= 2;
+    s.current_prop_owner = idx % Q_OWNER_SLOTS - 1;
+    idx /= Q_OWNER_SLOTS;
+    s.money_bin = idx % Q_MONEY_BINS;
+    s.position = idx / Q_MONEY_BINS;
+    return s;
+}
+
+// Create an empty dense Q-table (every state present, none used yet)
+static QTable* create_q_table(void) {
+    QTable* qt = (QTable*)malloc(sizeof(QTable));
+    if (!qt) return NULL;
+    qt->count = 0;
+    qt->mapped_bytes = 0;
+    qt->entries = (QTableEntry*)calloc(Q_NUM_STATES, sizeof(QTableEntry)); // sum=0, count=0, q=0
+    if (!qt->entries) {
+        free(qt);
+        return NULL;
+    }
+    return qt;
+}
+
+// Find the entry for a state and mark it used (NULL only for a StateTuple outside the table)
+static QTableEntry* find_or_create_q_entry(QTable* qt, StateTuple key) {
+    int idx = state_tuple_index(key);
+    if (idx < 0) return NULL;
+    QTableEntry* entry = &qt->entries[idx];
+    if (!entry->used) {
+        entry->used = true;
+        qt->count++;
+    }
+    return entry;
+}
+
+// Find a used entry without marking it (safe for concurrent readers while no thread writes the table)
+static const QTableEntry* find_q_entry(const QTable* qt, StateTuple key) {
+    int idx = state_tuple_index(key);
+    if (idx < 0 || !qt->entries[idx].used) return NULL;
+    return &qt->entries[idx];
+}
+
+// Release the entries, whether allocated or mapped from a checkpoint
+static void release_q_table_entries(QTable* qt) {
+    if (qt->mapped_bytes) {
+        munmap(qt->entries, qt->mapped_bytes);
+    } else {
+        free(qt->entries);
+    }
+    qt->entries = NULL;
+    qt->mapped_bytes = 0;
+}
+
+// Destroy the dense Q-table
+static void destroy_q_table(QTable* qt) {
+    if (!qt) return;
+    release_q_table_entries(qt);
+    free(qt);
+}
+
+// Standard error of a Q-value: sample standard deviation of its returns over sqrt(count), 0 below two returns
+static double q_value_std_error(const QValueData* v) {
+    if (v->count < 2) return 0.0;
+    double mean = v->sum_returns / v->count;
+    double variance = (v->sum_sq_returns - mean * v->sum_returns) / (v->count - 1);
+    return variance > 0.0 ? sqrt(variance / v->count) : 0.0;
+}
+
+// --- Episode Arena Functions ---
+
+#ifndef MONOPOLY_LIBRARY // Arenas are allocated by the training driver only
+// Allocate a worker's episode scratch once, sized for the longest episode
+static EpisodeArena* create_episode_arena(int num_players) {
+    EpisodeArena* arena = (EpisodeArena*)malloc(sizeof(EpisodeArena));
+    if (!arena) return NULL;
+    arena->steps = (EpisodeStep*)malloc(MAX_EPISODE_STEPS * sizeof(EpisodeStep));
+    arena->obs = (int*)malloc(get_observation_size(num_players) * sizeof(int));
+    arena->visit_stamps = (unsigned short*)calloc((size_t)Q_NUM_STATES * 2, sizeof(unsigned short));
+    arena->generation = 0;
+    if (!arena->steps || !arena->obs || !arena->visit_stamps) {
+        free(arena->steps);
+        free(arena->obs);
+        free(arena->visit_stamps);
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+// Free an episode arena
+static void destroy_episode_arena(EpisodeArena* arena) {
+    if (!arena) return;
+    free(arena->steps);
+    free(arena->obs);
+    free(arena->visit_stamps);
+    free(arena);
+}
+#endif
+
+// Start a first-visit pass: bumping the generation makes every (state, action) read as unvisited.
+// The stamps are only cleared when the 16-bit generation wraps, once every 65535 passes.
+static void begin_visit_pass(EpisodeArena* arena) {
+    if (++arena->generation == 0) {
+        memset(arena->visit_stamps, 0, (size_t)Q_NUM_STATES * 2 * sizeof(unsigned short));
+        arena->generation = 1;
+    }
+}
+
+// Mark (state, action) as visited in the current pass (returns true if it already was)
+static bool check_and_add_visited(EpisodeArena* arena, StateTuple state, int action) {
+    int idx = state_tuple_index(state);
+    if (idx < 0) return false; // Outside the table, the Q-table lookup reports it
+    unsigned short* stamp = &arena->visit_stamps[idx * 2 + action];
+    if (*stamp == arena->generation) return true;
+    *stamp = arena->generation;
+    return false;
+}
+
+
+// --- Episode History Functions ---
 
-// Add a step to the history, resizing if necessary
+// Start an empty history backed by the arena's steps (valid until the arena's next episode)
+static EpisodeHistory episode_arena_history(EpisodeArena* arena) {
+    EpisodeHistory history;
+    history.steps = arena->steps;
+    history.count = 0;
+    history.capacity = MAX_EPISODE_STEPS;
+    return history;
+}
+
+// Add a step to the history (episodes never exceed MAX_EPISODE_STEPS, the arena's capacity)
 static void add_episode_step(EpisodeHistory* history, StateTuple state, int action, double reward) {
     if (history->count >= history->capacity) {
-        int new_capacity = history->capacity > 0 ? history->capacity * 2 : 10; // Double capacity
-        EpisodeStep* new_steps = (EpisodeStep*)realloc(history->steps, new_capacity * sizeof(EpisodeStep));
-        if (!new_steps) {
-            fprintf(stderr, "Error: Failed to reallocate episode history\n");
-            // Keep old data, but can't add more
-            return;
-        }
-        history->steps = new_steps;
-        history->capacity = new_capacity;
+        fprintf(stderr, "Error: Episode history is full (%d steps)\n", history->capacity);
+        return;
     }
     history->steps[history->count].state = state;
     history->steps[history->count].action = action;
@@ -1165,15 +1880,157 @@ static void add_episode_step(EpisodeHistory* history, StateTuple state, int acti
     history->count++;
 }
 
-// Free memory used by episode history
-static void free_episode_history(EpisodeHistory* history) {
-    if (history && history->steps) {
-        free(history->steps);
-        history->steps = NULL;
-        history->count = 0;
-        history->capacity = 0;
+// --- Concurrent Q-Table Functions ---
+#ifndef MONOPOLY_LIBRARY // Shared by the training workers only
+
+// Comparison function for StateTuple
+static bool compare_state_tuples(StateTuple s1, StateTuple s2) {
+    return s1.position == s2.position &&
+           s1.money_bin == s2.money_bin &&
+           s1.current_prop_owner == s2.current_prop_owner &&
+           s1.in_jail == s2.in_jail;
+}
+
+// Full 32-bit hash of a StateTuple: low CQ_SHARD_BITS select the shard, the rest the probe start
+static unsigned int mix_state_tuple(StateTuple s) {
+    unsigned int h = (unsigned int)s.position;
+    h = (h * 0x01000193u) ^ (unsigned int)s.money_bin;
+    h = (h * 0x01000193u) ^ (unsigned int)(s.current_prop_owner + 1);
+    h = (h * 0x01000193u) ^ (unsigned int)s.in_jail;
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// Create an empty concurrent Q-table
+static ConcurrentQTable* create_concurrent_q_table(void) {
+    ConcurrentQTable* cq = (ConcurrentQTable*)malloc(sizeof(ConcurrentQTable));
+    if (!cq) return NULL;
+    for (int i = 0; i < CQ_NUM_SHARDS; ++i) {
+        CQShard* shard = &cq->shards[i];
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->capacity = CQ_SHARD_INITIAL_CAPACITY;
+        shard->count = 0;
+        shard->slots = (CQSlot*)calloc(shard->capacity, sizeof(CQSlot));
+        if (!shard->slots) {
+            for (int j = 0; j <= i; ++j) {
+                free(cq->shards[j].slots);
+                pthread_mutex_destroy(&cq->shards[j].lock);
+            }
+            free(cq);
+            return NULL;
+        }
+    }
+    return cq;
+}
+
+// Destroy a concurrent Q-table
+static void destroy_concurrent_q_table(ConcurrentQTable* cq) {
+    if (!cq) return;
+    for (int i = 0; i < CQ_NUM_SHARDS; ++i) {
+        free(cq->shards[i].slots);
+        pthread_mutex_destroy(&cq->shards[i].lock);
+    }
+    free(cq);
+}
+
+// Double a shard's slot array and rehash its entries (caller holds the shard lock)
+static bool cq_shard_grow(CQShard* shard) {
+    int new_capacity = shard->capacity * 2;
+    CQSlot* new_slots = (CQSlot*)calloc(new_capacity, sizeof(CQSlot));
+    if (!new_slots) return false;
+    unsigned int mask = (unsigned int)new_capacity - 1;
+    for (int i = 0; i < shard->capacity; ++i) {
+        if (!shard->slots[i].used) continue;
+        unsigned int j = (mix_state_tuple(shard->slots[i].key) >> CQ_SHARD_BITS) & mask;
+        while (new_slots[j].used) j = (j + 1) & mask;
+        new_slots[j] = shard->slots[i];
+    }
+    free(shard->slots);
+    shard->slots = new_slots;
+    shard->capacity = new_capacity;
+    return true;
+}
+
+// Add one first-visit return G for (state, action); safe to call from any number of threads
+static bool cq_accumulate(ConcurrentQTable* cq, StateTuple key, int action, double G) {
+    unsigned int hash = mix_state_tuple(key);
+    CQShard* shard = &cq->shards[hash & (CQ_NUM_SHARDS - 1)];
+    bool ok = true;
+
+    pthread_mutex_lock(&shard->lock);
+    if ((shard->count + 1) * 10 > shard->capacity * 7 && !cq_shard_grow(shard)) {
+        ok = false;
+    } else {
+        // Linear probe: stop at the matching key or the first free slot
+        unsigned int mask = (unsigned int)shard->capacity - 1;
+        unsigned int i = (hash >> CQ_SHARD_BITS) & mask;
+        while (shard->slots[i].used && !compare_state_tuples(shard->slots[i].key, key)) {
+            i = (i + 1) & mask;
+        }
+        CQSlot* slot = &shard->slots[i];
+        if (!slot->used) {
+            slot->used = true;
+            slot->key = key;
+            memset(slot->values, 0, sizeof(slot->values));
+            shard->count++;
+        }
+        slot->values[action].sum_returns += G;
+        slot->values[action].sum_sq_returns += G * G;
+        slot->values[action].count++;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return ok;
+}
+
+// First-visit Monte Carlo pass over one episode, accumulating into the concurrent table
+static void update_mc_concurrent(ConcurrentQTable* cq, EpisodeHistory* history, EpisodeArena* arena) {
+    double G = 0.0;
+    begin_visit_pass(arena);
+
+    // Iterate backwards through the episode (same visit rule as update_mc)
+    for (int i = history->count - 1; i >= 0; --i) {
+        G += history->steps[i].reward;
+        StateTuple state_tuple = history->steps[i].state;
+        int action = history->steps[i].action;
+        if (!check_and_add_visited(arena, state_tuple, action)) {
+            if (!cq_accumulate(cq, state_tuple, action, G)) {
+                fprintf(stderr, "Warning: Failed to grow concurrent Q-table shard during update. Skipping step.\n");
+            }
+        }
+    }
+}
+
+// Fold the accumulated sums and counts into a Q-table and empty the shards (no concurrent writers allowed)
+static bool cq_drain_into(ConcurrentQTable* cq, QTable* dst) {
+    bool ok = true;
+    for (int i = 0; i < CQ_NUM_SHARDS; ++i) {
+        CQShard* shard = &cq->shards[i];
+        for (int j = 0; j < shard->capacity; ++j) {
+            CQSlot* slot = &shard->slots[j];
+            if (!slot->used) continue;
+            QTableEntry* target = find_or_create_q_entry(dst, slot->key);
+            if (!target) {
+                ok = false;
+            } else {
+                for (int action = 0; action < 2; ++action) {
+                    if (slot->values[action].count == 0) continue;
+                    target->values[action].sum_returns += slot->values[action].sum_returns;
+                    target->values[action].sum_sq_returns += slot->values[action].sum_sq_returns;
+                    target->values[action].count += slot->values[action].count;
+                    target->values[action].q_value = target->values[action].sum_returns / target->values[action].count;
+                }
+            }
+            slot->used = false;
+        }
+        shard->count = 0;
     }
+    return ok;
 }
+#endif
 
 // --- Agent Implementation ---
 
@@ -1184,7 +2041,7 @@ MonteCarloAgent* create_monte_carlo_agent(int num_players, double epsilon) {
 
     agent->epsilon = epsilon;
     agent->num_players = num_players;
-    agent->q_table = create_q_hash_table(Q_TABLE_INITIAL_SIZE);
+    agent->q_table = create_q_table();
     if (!agent->q_table) {
         free(agent);
         return NULL;
@@ -1195,7 +2052,7 @@ MonteCarloAgent* create_monte_carlo_agent(int num_players, double epsilon) {
 // Destroy the Monte Carlo agent
 void destroy_monte_carlo_agent(MonteCarloAgent* agent) {
     if (agent) {
-        destroy_q_hash_table(agent->q_table);
+        destroy_q_table(agent->q_table);
         free(agent);
     }
 }
@@ -1226,123 +2083,221 @@ static StateTuple _get_state_tuple_c(const int* obs, int num_players, int board_
 }
 
 
-// Select action using epsilon-greedy policy based on Q-values
-int select_action_mc(MonteCarloAgent* agent, StateTuple state_tuple, MonopolyEnv* env) {
-    // --- Determine if a 'Buy' decision (action 1) is even possible ---
+// Action with the higher Q-value in a state, or -1 on a tie (read-only lookup, workers share the table)
+static int greedy_q_action(const QTable* q_table, StateTuple state_tuple) {
+    const QTableEntry* entry = find_q_entry(q_table, state_tuple);
+    if (!entry) {
+        return -1; // Unseen state: both Q-values are 0, so this is a tie
+    }
+
+    double q_val_0 = entry->values[0].q_value;
+    double q_val_1 = entry->values[1].q_value;
+    if (fabs(q_val_0 - q_val_1) < 1e-9) { // Floats are equal (or both 0 initially)
+        return -1;
+    }
+    return q_val_1 > q_val_0 ? 1 : 0; // Buy has higher value, or Don't Buy has
+}
+
+// True when the mover faces a buy decision: out of jail, on an unowned property it can afford
+static bool env_can_buy(const MonopolyEnv* env) {
     int p = env->current_player;
     int pos = env->positions[p];
-    bool is_buyable = false;
 
     // Check bounds and if currently in jail (can't buy from jail)
-    if (!env->in_jail[p] && pos >= 0 && pos < env->board_size) {
-        Property* prop = &env->properties[pos];
-        is_buyable = (prop->price > 0 && prop->owner == -1 && env->money[p] >= prop->price);
-    }
+    if (env->in_jail[p] || pos < 0 || pos >= env->board_size) return false;
+    const Property* prop = &env->properties[pos];
+    return prop->price > 0 && env->owner[pos] == -1 && env->money[p] >= prop->price;
+}
 
+// Select action using epsilon-greedy policy based on Q-values
+int select_action_mc(MonteCarloAgent* agent, StateTuple state_tuple, MonopolyEnv* env) {
     // If not on a buyable square, the only logical action is 0 (Pass/Continue)
-    if (!is_buyable) {
+    if (!env_can_buy(env)) {
         return 0;
     }
 
     // --- If buyable, use Epsilon-Greedy ---
     // Explore with probability epsilon
-    if (((double)rand() / RAND_MAX) < agent->epsilon) {
+    if (philox_stream_uniform(&env->rng) < agent->epsilon) {
         // Since buy is possible, randomly choose between 0 and 1
-        return rand() % 2;
+        return env_rand(env) % 2;
     } else {
-        // Exploit: Choose action with highest Q-value
-        QTableEntry* entry = find_or_create_q_entry(agent->q_table, state_tuple);
-        if (!entry) {
-             fprintf(stderr, "Warning: Failed to find/create Q-table entry in select_action. Defaulting to random.\n");
-             return rand() % 2; // Fallback if allocation failed
-        }
+        // Exploit: Choose action with highest Q-value, break ties randomly
+        int greedy = greedy_q_action(agent->q_table, state_tuple);
+        return greedy >= 0 ? greedy : env_rand(env) % 2;
+    }
+}
 
-        double q_val_0 = entry->values[0].q_value;
-        double q_val_1 = entry->values[1].q_value;
+// StateTuple of the observation player p's move produced, as _get_state_tuple_c would read it from obs
+static StateTuple env_player_state_tuple(const MonopolyEnv* env, int p) {
+    int pos = env->positions[p];
+    int money = env->money[p] > env->obs_money_high ? env->obs_money_high : env->money[p];
+    StateTuple s = {pos, money / 100, env->owner[pos], env->in_jail[p]};
+    return s;
+}
 
-        // Choose the action with the higher Q-value, break ties randomly
-        if (fabs(q_val_0 - q_val_1) < 1e-9) { // Floats are equal (or both 0 initially)
-            return rand() % 2; // Break tie randomly
-        } else if (q_val_1 > q_val_0) {
-            return 1; // Buy has higher value
-        } else {
-            return 0; // Don't Buy has higher value
+// step_monopoly_env_fast that also hands back the turn's StepRecord (left untouched if the game is over)
+static StateTuple env_step_recorded(MonopolyEnv* env, int action, int* obs, double* reward, bool* done, StepRecord* out) {
+    int p = env->current_player;
+    *reward = 0.0;
+    *done = env->done;
+    if (env->done) return env_player_state_tuple(env, p);
+
+    StepRecord rec;
+    int step_reward = env_play_turn(env, action, &rec);
+    if (obs) {
+        const int n = env->num_players;
+        obs[p] = env->positions[p];
+        obs[n + p] = env->money[p] > env->obs_money_high ? env->obs_money_high : env->money[p];
+        obs[2 * n + p] = env->in_jail[p];
+        if (rec.events & STEP_EVT_BOUGHT) obs[3 * n + rec.position_after] = p;
+        if (rec.payee >= 0) {
+            obs[n + rec.payee] = env->money[rec.payee] > env->obs_money_high ? env->obs_money_high : env->money[rec.payee];
+        }
+        if (rec.events & STEP_EVT_DEBT) {
+            for (int i = 0; i < env->board_size; ++i) obs[3 * n + i] = env->owner[i];
         }
+        obs[3 * n + env->board_size] = p;
     }
+    StateTuple next_state = env_player_state_tuple(env, p);
+    env_pass_turn(env, &rec);
+
+    *reward = (double)step_reward;
+    *done = env->done;
+    if (out) *out = rec;
+    return next_state;
+}
+
+// Logging-free step_monopoly_env: the same rules core and random draws, but no log text or last_log copy.
+// Returns the StateTuple of the resulting observation and writes the reward and done flag.
+// obs may be NULL; otherwise it must hold the previous observation, and only the entries this step
+// changed are rewritten (the result equals what get_observation would produce).
+StateTuple step_monopoly_env_fast(MonopolyEnv* env, int action, int* obs, double* reward, bool* done) {
+    return env_step_recorded(env, action, obs, reward, done, NULL);
 }
 
 // Generate one episode using the agent's policy
-EpisodeHistory generate_episode_mc(MonteCarloAgent* agent, MonopolyEnv* env, int episode_id, LogEntry** out_logs, int* out_log_count) {
-    EpisodeHistory history;
-    init_episode_history(&history, 100); // Initial capacity 100 steps
+// Step records go to the caller-owned log_buffer (capacity log_capacity); pass NULL to skip logging.
+// Both cases step with step_monopoly_env_fast and carry the StateTuple from step to step; log text is
+// only built from the records when they are written out (see decode_step_record).
+EpisodeHistory generate_episode_mc(MonteCarloAgent* agent, MonopolyEnv* env, EpisodeArena* arena, int episode_id, StepRecord* log_buffer, int log_capacity, int* out_log_count) {
+    EpisodeHistory history = episode_arena_history(arena);
 
     // --- Manage Detailed Logs ---
-    #define MAX_LOG_ENTRIES 1000
-    static LogEntry log_buffer[MAX_LOG_ENTRIES]; // Static buffer for simplicity
     int log_count = 0;
 
-    int obs_size = get_observation_size(agent->num_players);
-    int* obs = (int*)malloc(obs_size * sizeof(int));
-    if (!obs) {
-        fprintf(stderr, "Error: Failed to allocate observation buffer in generate_episode\n");
-        history.count = -1; // Indicate error
-        return history;
-    }
-
+    int* obs = arena->obs;
     reset_monopoly_env(env, obs);
     bool done = false;
     int step_count = 0;
+    StateTuple state_tuple = _get_state_tuple_c(obs, agent->num_players, env->board_size);
 
     while (!done && step_count < MAX_EPISODE_STEPS) {
-        int current_player = env->current_player; // Who's turn is it?
-        StateTuple state_tuple = _get_state_tuple_c(obs, agent->num_players, env->board_size);
+        // Every draw of this step (action choice, dice, cards) comes from counter (episode_id, step_count)
+        philox_stream_seek(&env->rng, episode_id, step_count);
 
         // Agent selects action based on its policy
         int action = select_action_mc(agent, state_tuple, env);
 
         // Environment processes the turn
-        StepResult result = step_monopoly_env(env, action, obs);
-
-        // Store data for MC update *using the state the decision was made in*
-        add_episode_step(&history, state_tuple, action, result.reward);
-
-        // Store detailed log
-        if (log_count < MAX_LOG_ENTRIES) {
-            log_buffer[log_count] = result.log; // Copy log entry
-            log_buffer[log_count].episode_id = episode_id; // Add episode ID
-            log_count++;
+        double reward;
+        StateTuple next_state;
+        if (log_buffer && log_count < log_capacity) {
+            // Store the step's record
+            StepRecord* rec = &log_buffer[log_count++];
+            next_state = env_step_recorded(env, action, NULL, &reward, &done, rec);
+            rec->num_owned = (unsigned char)count_owned_properties(env, rec->player);
         } else {
-             fprintf(stderr, "Warning: Log buffer overflow in episode %d\n", episode_id);
+            if (log_buffer) fprintf(stderr, "Warning: Log buffer overflow in episode %d\n", episode_id);
+            next_state = step_monopoly_env_fast(env, action, NULL, &reward, &done);
         }
 
-        done = result.done;
+        // Store data for MC update *using the state the decision was made in*
+        add_episode_step(&history, state_tuple, action, reward);
+        state_tuple = next_state;
         step_count++;
     }
 
-    free(obs);
-
-    // Pass log data back (if requested)
-    if (out_logs && out_log_count) {
-        *out_logs = log_buffer; // Point to the static buffer
+    // Pass log count back (if requested)
+    if (out_log_count) {
         *out_log_count = log_count;
-    } else if (out_logs) {
-        *out_logs = NULL;
-        *out_log_count = 0;
     }
 
-    return history; // Remember to call free_episode_history on this later
+    return history; // Steps live in the arena until its next episode
+}
+
+// Observation of a batch lane as _get_state_tuple_c would extract it: the post-step state of the last mover
+static StateTuple env_batch_state_tuple(const MonopolyEnvBatch* b, int lane) {
+    int p = b->last_player[lane];
+    int pos = b->positions[p][lane];
+    int money = b->money[p][lane];
+    StateTuple state;
+    state.position = pos;
+    state.money_bin = ((money > b->obs_money_high) ? b->obs_money_high : money) / 100; // Bin money by 100
+    state.current_prop_owner = b->owner[pos][lane];
+    state.in_jail = b->in_jail[p][lane];
+    return state;
+}
+
+// Can the lane's current player buy the square it stands on (the only time select_action_mc decides)?
+static bool env_batch_can_buy(const MonopolyEnvBatch* b, int lane) {
+    int p = b->current_player[lane];
+    int pos = b->positions[p][lane];
+    return !b->in_jail[p][lane] && b->board.price[pos] > 0 && b->owner[pos][lane] == -1 && b->money[p][lane] >= b->board.price[pos];
+}
+
+// select_action_mc for a batch lane, with the same draws from the lane's stream
+static int select_action_batch(MonteCarloAgent* agent, MonopolyEnvBatch* b, int lane, StateTuple state_tuple) {
+    if (!env_batch_can_buy(b, lane)) {
+        return 0;
+    }
+    if (env_batch_uniform(b, lane) < agent->epsilon) {
+        return env_batch_rand(b, lane) % 2;
+    }
+    int greedy = greedy_q_action(agent->q_table, state_tuple);
+    return greedy >= 0 ? greedy : env_batch_rand(b, lane) % 2;
+}
+
+// Generate episodes first_episode .. first_episode + count - 1 (count <= ENV_BATCH_LANES) in lockstep.
+// Lane i records into histories[i], which must have room for MAX_EPISODE_STEPS steps. Every lane makes
+// the draws generate_episode_mc would, so the histories match the scalar path's exactly.
+void generate_episodes_batch(MonteCarloAgent* agent, MonopolyEnvBatch* b, int first_episode, int count, EpisodeHistory* histories) {
+    StateTuple states[ENV_BATCH_LANES];
+    int actions[ENV_BATCH_LANES] = {0};
+    double rewards[ENV_BATCH_LANES];
+    reset_monopoly_env_batch(b, first_episode, count);
+    for (int lane = 0; lane < count; ++lane) {
+        histories[lane].count = 0;
+        states[lane] = env_batch_state_tuple(b, lane);
+    }
+
+    int running = count;
+    while (running > 0) {
+        begin_step_monopoly_env_batch(b);
+        for (int lane = 0; lane < count; ++lane) {
+            if (b->active[lane]) actions[lane] = select_action_batch(agent, b, lane, states[lane]);
+        }
+        bool stepped[ENV_BATCH_LANES];
+        for (int lane = 0; lane < count; ++lane) stepped[lane] = b->active[lane] != 0;
+
+        step_monopoly_env_batch(b, actions, rewards);
+
+        for (int lane = 0; lane < count; ++lane) {
+            if (!stepped[lane]) continue;
+            add_episode_step(&histories[lane], states[lane], actions[lane], rewards[lane]);
+            states[lane] = env_batch_state_tuple(b, lane);
+            if (b->steps_taken[lane] >= MAX_EPISODE_STEPS) b->active[lane] = 0;
+            if (!b->active[lane]) running--;
+        }
+    }
 }
 
 
 // Update Q-values using First-Visit Monte Carlo based on an episode history
-void update_mc(MonteCarloAgent* agent, EpisodeHistory* history) {
+static void update_mc_table(QTable* q_table, EpisodeHistory* history, EpisodeArena* arena) {
     double G = 0.0; // Cumulative reward (Return)
-    // Create a temporary set to track visited (state, action) pairs for this episode *only*
-    VisitedSet* visited_state_actions = create_visited_set(VISITED_SET_INITIAL_SIZE);
-    if (!visited_state_actions) {
-         fprintf(stderr, "Error: Failed to create visited set for update. Skipping update.\n");
-         return;
-    }
+    // Track visited (state, action) pairs for this episode *only*
+    begin_visit_pass(arena);
 
     // Iterate backwards through the episode
     for (int i = history->count - 1; i >= 0; --i) {
@@ -1352,19 +2307,18 @@ void update_mc(MonteCarloAgent* agent, EpisodeHistory* history) {
 
         G += reward; // Update return G
 
-        VisitedKey current_key = {state_tuple, action};
-
         // First-visit Monte Carlo check: only update the first time this (s,a) was visited *in this backward pass*
-        if (!check_and_add_visited(visited_state_actions, current_key)) {
+        if (!check_and_add_visited(arena, state_tuple, action)) {
             // This is the first visit for this (s,a) pair in this episode traverse
-            QTableEntry* entry = find_or_create_q_entry(agent->q_table, state_tuple);
+            QTableEntry* entry = find_or_create_q_entry(q_table, state_tuple);
             if (!entry) {
-                fprintf(stderr, "Warning: Failed to find/create Q-table entry during update. Skipping step.\n");
-                continue; // Skip if allocation failed
+                fprintf(stderr, "Warning: State outside the Q-table during update. Skipping step.\n");
+                continue; // Skip an unrepresentable state
             }
 
-            // Update the sum of returns and count for the specific action
+            // Update the sums of returns and count for the specific action
             entry->values[action].sum_returns += G;
+            entry->values[action].sum_sq_returns += G * G;
             entry->values[action].count++;
 
             // Update Q-value as the average of observed returns
@@ -1373,68 +2327,50 @@ void update_mc(MonteCarloAgent* agent, EpisodeHistory* history) {
             // Policy improvement is implicit via epsilon-greedy action selection in the next episode
         }
     }
+}
 
-    // Clean up the temporary visited set for this episode
-    destroy_visited_set(visited_state_actions);
+// Update the agent's Q-values from one episode
+void update_mc(MonteCarloAgent* agent, EpisodeHistory* history, EpisodeArena* arena) {
+    update_mc_table(agent->q_table, history, arena);
 }
-void export_q_table_to_csv(QHashTable* q_table, const char* filename) {
+void export_q_table_to_csv(QTable* q_table, const char* filename) {
     FILE* fp = fopen(filename, "w");
     if (!fp) {
         fprintf(stderr, "Error: Could not open Q-table CSV file '%s' for writing.\n", filename);
         return;
     }
     // Write header
-    fprintf(fp, "position,money_bin,current_prop_owner,in_jail,action,q_value,count\n");
-    for (int i = 0; i < q_table->size; ++i) {
-        QTableEntry* entry = q_table->table[i];
-        while (entry != NULL) {
-            for (int action = 0; action < 2; ++action) {
-                if (entry->values[action].count > 0) {
-                    fprintf(fp, "%d,%d,%d,%d,%d,%.6f,%d\n",
-                        entry->key.position,
-                        entry->key.money_bin,
-                        entry->key.current_prop_owner,
-                        entry->key.in_jail,
-                        action,
-                        entry->values[action].q_value,
-                        entry->values[action].count
-                    );
-                }
+    fprintf(fp, "position,money_bin,current_prop_owner,in_jail,action,q_value,count,std_error\n");
+    for (int idx = 0; idx < Q_NUM_STATES; ++idx) {
+        const QTableEntry* entry = &q_table->entries[idx];
+        if (!entry->used) continue;
+        StateTuple key = state_tuple_from_index(idx);
+        for (int action = 0; action < 2; ++action) {
+            if (entry->values[action].count > 0) {
+                fprintf(fp, "%d,%d,%d,%d,%d,%.6f,%d,%.6f\n",
+                    key.position,
+                    key.money_bin,
+                    key.current_prop_owner,
+                    key.in_jail,
+                    action,
+                    entry->values[action].q_value,
+                    entry->values[action].count,
+                    q_value_std_error(&entry->values[action])
+                );
             }
-            entry = entry->next;
         }
     }
     fclose(fp);
 }
-static char* escape_csv_string(const char* input) {
-    if (!input) return NULL;
-
-    int quotes_to_escape = 0;
-    for (const char* p = input; *p; ++p) {
-        if (*p == '"') {
-            quotes_to_escape++;
-        }
-    }
-
-    // Allocate space: original length + quotes to escape + 2 for surrounding quotes + 1 for null terminator
-    size_t new_len = strlen(input) + quotes_to_escape + 2 + 1;
-    char* output = (char*)malloc(new_len);
-    if (!output) return NULL;
-
-    char* q = output;
-    *q++ = '"'; // Start with a quote
-
-    for (const char* p = input; *p; ++p) {
-        if (*p == '"') {
-            *q++ = '"'; // Escape internal quote by doubling it
-        }
-        *q++ = *p; // Copy original character
+#ifndef MONOPOLY_LIBRARY // The training log's CSV rows (see LogSink)
+// Write a string field as a quoted CSV value, doubling embedded quotes
+static void write_csv_quoted(FILE* fp, const char* s) {
+    putc('"', fp);
+    for (; *s; ++s) {
+        if (*s == '"') putc('"', fp); // Escape internal quote by doubling it
+        putc(*s, fp);
     }
-
-    *q++ = '"'; // End with a quote
-    *q = '\0';  // Null terminate
-
-    return output;
+    putc('"', fp);
 }
 
 
@@ -1442,17 +2378,7 @@ static char* escape_csv_string(const char* input) {
 static void write_log_to_csv(FILE* fp, const LogEntry* log) {
     if (!fp || !log) return;
 
-    // Escape potentially problematic string fields
-    char* escaped_action_desc = escape_csv_string(log->action_desc);
-    char* escaped_card_name = escape_csv_string(log->card_drawn);
-    char* escaped_card_spec_desc = escape_csv_string(log->card_specific_desc);
-
-    // Handle potential allocation failures during escaping
-    if (!escaped_action_desc) escaped_action_desc = strdup("\"\""); // Use empty quoted string if allocation fails
-    if (!escaped_card_name) escaped_card_name = strdup("\"\"");
-    if (!escaped_card_spec_desc) escaped_card_spec_desc = strdup("\"\"");
-
-    fprintf(fp, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%.4f,%d,%d,%d,%d,%d,%s,%s,%s\n",
+    fprintf(fp, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%.4f,%d,%d,%d,%d,%d,",
             log->episode_id,
             log->step,
             log->player,
@@ -1467,16 +2393,1052 @@ static void write_log_to_csv(FILE* fp, const LogEntry* log) {
             (int)log->in_jail, // bool to int
             log->fee_paid,
             log->agent_action,
-            log->num_owned_properties,
-            escaped_card_name ? escaped_card_name : "\"\"", // Use "" if escaping failed completely
-            escaped_card_spec_desc ? escaped_card_spec_desc : "\"\"",
-            escaped_action_desc ? escaped_action_desc : "\"\""
+            log->num_owned_properties
            );
 
-    // Free the allocated escaped strings
-    free(escaped_action_desc);
-    free(escaped_card_name);
-    free(escaped_card_spec_desc);
+    // Quote the free-text fields in place (no temporary escaped copies)
+    write_csv_quoted(fp, log->card_drawn);
+    putc(',', fp);
+    write_csv_quoted(fp, log->card_specific_desc);
+    putc(',', fp);
+    write_csv_quoted(fp, log->action_desc);
+    putc('\n', fp);
+}
+#endif
+
+// --- Q-Table Checkpoints ---
+
+// Episode ids a checkpointing process trains: its slice of a multi-rank run, or {1, 0, 0} for a single
+// process, whose episode count may grow on resume
+typedef struct {
+    int ranks;                    // Processes the run's episode ids are split over
+    long long base;               // First episode id of this process's slice
+    long long episodes;           // Episode ids in the slice
+} CheckpointSlice;
+
+// Fixed header at offset 0 of a checkpoint file. The dense table follows at CHECKPOINT_HEADER_BYTES as
+// Q_NUM_STATES QTableEntry records, byte for byte, so a warm start maps it instead of parsing it.
+typedef struct {
+    char magic[8];                // CHECKPOINT_MAGIC
+    int version;                  // CHECKPOINT_VERSION
+    int entry_bytes;              // sizeof(QTableEntry) of the writer
+    int num_states;               // Q_NUM_STATES of the writer
+    int num_players;
+    int used_count;               // QTable.count
+    int split_ranks;              // CheckpointSlice of the writer
+    unsigned long long seed;      // Key of every episode's Philox stream
+    long long episodes_done;      // Episodes of the slice already trained; training resumes at slice_base + this
+    long long slice_base;
+    long long slice_episodes;
+} CheckpointHeader;
+
+// Replace the table with a checkpoint's and return its seed, progress and slice (slice may be NULL). The entries
+// are mapped copy-on-write, so the load costs no parse or copy and training never writes back to the file.
+static bool load_checkpoint(const char* path, QTable* qt, int num_players, unsigned long long* seed, long long* episodes_done,
+                            CheckpointSlice* slice) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not open checkpoint '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    size_t entries_bytes = (size_t)Q_NUM_STATES * sizeof(QTableEntry);
+    struct stat st;
+    CheckpointHeader header;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != CHECKPOINT_HEADER_BYTES + entries_bytes ||
+        pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 || header.version != CHECKPOINT_VERSION ||
+        header.entry_bytes != (int)sizeof(QTableEntry) || header.num_states != Q_NUM_STATES) {
+        fprintf(stderr, "Error: '%s' is not a checkpoint of this build.\n", path);
+        close(fd);
+        return false;
+    }
+    if (header.num_players != num_players) {
+        fprintf(stderr, "Error: Checkpoint '%s' was trained with %d players, not %d.\n", path, header.num_players, num_players);
+        close(fd);
+        return false;
+    }
+
+    QTableEntry* entries = (QTableEntry*)mmap(NULL, entries_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, CHECKPOINT_HEADER_BYTES);
+    if (entries == MAP_FAILED) {
+        // Pages larger than the header: read the entries into the existing table instead
+        entries = NULL;
+        if (pread(fd, qt->entries, entries_bytes, CHECKPOINT_HEADER_BYTES) != (ssize_t)entries_bytes) {
+            fprintf(stderr, "Error: Failed to read checkpoint '%s': %s\n", path, strerror(errno));
+            close(fd);
+            return false;
+        }
+    }
+    close(fd);
+
+    if (entries) {
+        release_q_table_entries(qt);
+        qt->entries = entries;
+        qt->mapped_bytes = entries_bytes;
+    }
+    qt->count = header.used_count;
+    *seed = header.seed;
+    *episodes_done = header.episodes_done;
+    if (slice) {
+        slice->ranks = header.split_ranks;
+        slice->base = header.slice_base;
+        slice->episodes = header.slice_episodes;
+    }
+    return true;
+}
+
+#ifndef MONOPOLY_LIBRARY // Only the training driver writes checkpoints
+// Write the table and training progress to `path` via a temporary file renamed over it, so a crash
+// mid-write leaves the previous checkpoint intact
+static bool save_checkpoint(const char* path, const QTable* qt, int num_players, unsigned long long seed, long long episodes_done,
+                            CheckpointSlice slice) {
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        fprintf(stderr, "Error: Could not open checkpoint file '%s' for writing: %s\n", tmp_path, strerror(errno));
+        return false;
+    }
+
+    static char header_block[CHECKPOINT_HEADER_BYTES]; // Zero padding up to the entries
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.entry_bytes = (int)sizeof(QTableEntry);
+    header.num_states = Q_NUM_STATES;
+    header.num_players = num_players;
+    header.used_count = qt->count;
+    header.split_ranks = slice.ranks;
+    header.seed = seed;
+    header.episodes_done = episodes_done;
+    header.slice_base = slice.base;
+    header.slice_episodes = slice.episodes;
+    memcpy(header_block, &header, sizeof(header));
+
+    bool ok = fwrite(header_block, 1, sizeof(header_block), fp) == sizeof(header_block) &&
+              fwrite(qt->entries, sizeof(QTableEntry), Q_NUM_STATES, fp) == Q_NUM_STATES &&
+              fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    if (fclose(fp) != 0) ok = false;
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Error: Failed to write checkpoint '%s': %s\n", path, strerror(errno));
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+// Checkpointing settings of a training run (path NULL = no checkpoints)
+typedef struct {
+    const char* path;
+    int every;                    // Episodes between periodic checkpoints
+    unsigned long long seed;
+    CheckpointSlice slice;
+} CheckpointConfig;
+
+// Checkpoint after `done` episodes when a period boundary lies in (prev_done, done], or when forced
+static void checkpoint_progress(const CheckpointConfig* cfg, const MonteCarloAgent* agent, long long prev_done, long long done, bool force) {
+    if (!cfg->path) return;
+    if (!force && done / cfg->every == prev_done / cfg->every) return;
+    if (save_checkpoint(cfg->path, agent->q_table, agent->num_players, cfg->seed, done, cfg->slice)) {
+        printf("Checkpoint saved to '%s' after %lld episodes.\n", cfg->path, done);
+    }
+}
+#endif
+
+// --- Frozen Policy Inference ---
+
+// Read-only greedy policy for serving trained agents: the learned action of every dense state, fixed
+// when frozen. Queries only read it, so any number of threads share one policy without locks or allocation.
+typedef struct {
+    unsigned char actions[Q_NUM_STATES]; // 1 = Buy, 0 = Pass (ties and unvisited states serve Pass)
+    int num_players;
+} FrozenPolicy;
+
+// Snapshot a Q-table's greedy actions (NULL on allocation failure)
+FrozenPolicy* freeze_policy(const QTable* qt, int num_players) {
+    FrozenPolicy* policy = (FrozenPolicy*)malloc(sizeof(FrozenPolicy));
+    if (!policy) return NULL;
+    policy->num_players = num_players;
+    for (int idx = 0; idx < Q_NUM_STATES; ++idx) {
+        // Same comparison as the exploit branch of select_action_mc, minus its random tie-break
+        const QTableEntry* entry = &qt->entries[idx];
+        policy->actions[idx] = entry->used && entry->values[1].q_value - entry->values[0].q_value >= 1e-9;
+    }
+    return policy;
+}
+
+// Load a policy straight from a --checkpoint file
+FrozenPolicy* load_frozen_policy(const char* checkpoint_path, int num_players) {
+    QTable* qt = create_q_table();
+    if (!qt) return NULL;
+    unsigned long long seed;
+    long long episodes_done;
+    FrozenPolicy* policy = NULL;
+    if (load_checkpoint(checkpoint_path, qt, num_players, &seed, &episodes_done, NULL)) {
+        policy = freeze_policy(qt, num_players);
+    }
+    destroy_q_table(qt);
+    return policy;
+}
+
+void destroy_frozen_policy(FrozenPolicy* policy) {
+    free(policy);
+}
+
+// Greedy action for one state (0 = Pass, 1 = Buy); only meaningful when buying is possible
+int frozen_policy_action(const FrozenPolicy* policy, StateTuple state) {
+    int idx = state_tuple_index(state);
+    return idx < 0 ? 0 : policy->actions[idx];
+}
+
+// Batched queries: actions[i] is the greedy action for states[i]
+void frozen_policy_actions(const FrozenPolicy* policy, const StateTuple* states, int* actions, int count) {
+    for (int i = 0; i < count; ++i) {
+        actions[i] = frozen_policy_action(policy, states[i]);
+    }
+}
+
+// Batched queries from raw observations in the get_observation layout, one every obs_stride ints
+void frozen_policy_actions_from_obs(const FrozenPolicy* policy, const int* obs, int obs_stride, int board_size,
+                                    int* actions, int count) {
+    for (int i = 0; i < count; ++i) {
+        StateTuple state = _get_state_tuple_c(obs + (size_t)i * obs_stride, policy->num_players, board_size);
+        actions[i] = frozen_policy_action(policy, state);
+    }
+}
+
+#ifndef MONOPOLY_LIBRARY // -DMONOPOLY_LIBRARY builds the engine without the training driver (see monopoly_vec_env_create)
+// --- Training Log Sink ---
+
+#define LOG_CSV_HEADER "episode_id,step,player,position_before,dice_roll,landed_on_position,position_after,money_before,money_after,reward,done,in_jail,fee_paid,agent_action,num_owned_properties,card_drawn,card_specific_desc,action_desc\n"
+#define LOG_SINK_BUFFER_BYTES (8 << 20) // stdio buffer of the log file, flushed only when full or on close
+#define LOG_BIN_MAGIC "MPLOGSEQ"
+#define LOG_BIN_VERSION 2
+
+// off: no log; csv: the original row format; bin: compact binary, convert with --convert-log
+typedef enum { LOG_MODE_OFF, LOG_MODE_CSV, LOG_MODE_BIN } LogMode;
+
+// Header at the start of a binary log. It is followed by one block per episode:
+// int episode_id, int step_count, then step_count StepRecords. The records hold no text; --convert-log
+// rebuilds it with decode_step_record on an env made from the configuration stored here.
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int record_size; // sizeof(StepRecord) of the writer
+    int num_players;
+    int start_money;
+    int go_reward;
+} LogBinHeader;
+
+// Where (and whether) step logs go
+typedef struct {
+    LogMode mode;
+    int sample_every; // Keep episodes whose id is a multiple of this (1 = every episode)
+    FILE* fp;
+    char* buffer;     // setvbuf buffer owned by the sink
+} LogSink;
+
+// Does the sink record this episode?
+static bool log_sink_wants(const LogSink* sink, int episode_id) {
+    return sink->mode != LOG_MODE_OFF && episode_id % sink->sample_every == 0;
+}
+
+// Open the log file and write its header (no-op for LOG_MODE_OFF); env is the configuration a binary
+// log records (unused for CSV)
+static bool log_sink_open(LogSink* sink, const char* filename, const MonopolyEnv* env) {
+    if (sink->mode == LOG_MODE_OFF) return true;
+    sink->fp = fopen(filename, sink->mode == LOG_MODE_BIN ? "wb" : "w");
+    if (!sink->fp) return false;
+    sink->buffer = (char*)malloc(LOG_SINK_BUFFER_BYTES);
+    if (sink->buffer) setvbuf(sink->fp, sink->buffer, _IOFBF, LOG_SINK_BUFFER_BYTES);
+
+    if (sink->mode == LOG_MODE_BIN) {
+        LogBinHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, LOG_BIN_MAGIC, sizeof(header.magic));
+        header.version = LOG_BIN_VERSION;
+        header.record_size = sizeof(StepRecord);
+        header.num_players = env->num_players;
+        header.start_money = env->start_money;
+        header.go_reward = env->go_reward;
+        fwrite(&header, sizeof(header), 1, sink->fp);
+    } else {
+        fputs(LOG_CSV_HEADER, sink->fp);
+    }
+    return true;
+}
+
+// Close the log file; returns the fclose result (0 when there was nothing to close)
+static int log_sink_close(LogSink* sink) {
+    int result = 0;
+    if (sink->fp) result = fclose(sink->fp);
+    free(sink->buffer);
+    sink->fp = NULL;
+    sink->buffer = NULL;
+    return result;
+}
+
+// Format one episode's step records in the sink's format into any stream (the sink file or a worker's
+// chunk). CSV rows are decoded against env, the environment that played the episode.
+static void log_sink_format_episode(const LogSink* sink, FILE* out, const MonopolyEnv* env, int episode_id,
+                                    const StepRecord* recs, int count) {
+    if (sink->mode == LOG_MODE_CSV) {
+        for (int i = 0; i < count; ++i) {
+            LogEntry log;
+            decode_step_record(&recs[i], episode_id, env, &log);
+            write_log_to_csv(out, &log);
+        }
+    } else if (sink->mode == LOG_MODE_BIN) {
+        fwrite(&episode_id, sizeof(int), 1, out);
+        fwrite(&count, sizeof(int), 1, out);
+        fwrite(recs, sizeof(StepRecord), (size_t)count, out);
+    }
+}
+
+// Read and check a binary log's header; prints the error and returns false if it is not one
+static bool read_log_bin_header(FILE* in, const char* in_path, LogBinHeader* header) {
+    if (fread(header, sizeof(*header), 1, in) != 1 || memcmp(header->magic, LOG_BIN_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != LOG_BIN_VERSION || header->record_size != sizeof(StepRecord) ||
+        header->num_players < 1 || header->num_players > MAX_PLAYERS) {
+        fprintf(stderr, "Error: '%s' is not a sequential-engine binary log (version %d).\n", in_path, LOG_BIN_VERSION);
+        return false;
+    }
+    return true;
+}
+
+// Offline converter: binary log -> the CSV schema write_log_to_csv produces, text rebuilt from the records
+static int convert_binary_log(const char* in_path, const char* out_path) {
+    FILE* in = fopen(in_path, "rb");
+    if (!in) {
+        fprintf(stderr, "Error: Could not open binary log '%s': %s\n", in_path, strerror(errno));
+        return 1;
+    }
+    LogBinHeader header;
+    if (!read_log_bin_header(in, in_path, &header)) {
+        fclose(in);
+        return 1;
+    }
+    MonopolyEnv* env = create_monopoly_env(header.num_players, header.start_money, header.go_reward);
+    if (!env) {
+        fclose(in);
+        return 1;
+    }
+
+    LogSink out_sink = {LOG_MODE_CSV, 1, NULL, NULL};
+    if (!log_sink_open(&out_sink, out_path, env)) {
+        fprintf(stderr, "Error: Could not open CSV file '%s' for writing: %s\n", out_path, strerror(errno));
+        destroy_monopoly_env(env);
+        fclose(in);
+        return 1;
+    }
+
+    int status = 0;
+    long long rows = 0;
+    int episode_header[2];
+    static StepRecord recs[MAX_LOG_ENTRIES];
+    while (fread(episode_header, sizeof(int), 2, in) == 2) {
+        int count = episode_header[1];
+        if (count < 0 || count > MAX_LOG_ENTRIES || fread(recs, sizeof(StepRecord), (size_t)count, in) != (size_t)count) {
+            fprintf(stderr, "Error: Truncated binary log '%s' in episode %d.\n", in_path, episode_header[0]);
+            status = 1;
+            break;
+        }
+        log_sink_format_episode(&out_sink, out_sink.fp, env, episode_header[0], recs, count);
+        rows += count;
+    }
+
+    fclose(in);
+    if (log_sink_close(&out_sink) != 0) status = 1;
+    destroy_monopoly_env(env);
+    printf("Converted %lld log rows from '%s' to '%s'.\n", rows, in_path, out_path);
+    return status;
+}
+
+// --- Run Statistics ---
+
+// Monotonic wall-clock time in milliseconds (clock() would add up the CPU time of all workers)
+static double wall_clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1.0e6;
+}
+
+// Work done by a training run and where its time went (with workers, the phases add up thread time)
+typedef struct {
+    long long episodes;
+    long long steps;
+    double simulate_ms; // Playing episodes
+    double update_ms;   // First-visit MC updates and merging them into the agent
+    double log_ms;      // Formatting and writing the step log
+} RunStats;
+
+// Fold one worker's statistics into the run's
+static void add_run_stats(RunStats* total, const RunStats* part) {
+    total->episodes += part->episodes;
+    total->steps += part->steps;
+    total->simulate_ms += part->simulate_ms;
+    total->update_ms += part->update_ms;
+    total->log_ms += part->log_ms;
+}
+
+// Peak resident set size of the process in kilobytes (Linux reports ru_maxrss in KB)
+static long peak_host_memory_kb(void) {
+    struct rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+}
+
+// Print measured throughput and the phase breakdown; --benchmark adds one key=value line for tracking runs
+static void print_run_stats(const char* engine, int num_threads, unsigned long long seed, const RunStats* stats,
+                            double elapsed_ms, bool benchmark) {
+    double seconds = elapsed_ms / 1000.0;
+    long peak_kb = peak_host_memory_kb();
+    printf("CPU Training Time: %.2f milliseconds (%d thread%s)\n", elapsed_ms, num_threads, num_threads == 1 ? "" : "s");
+    printf("Training throughput: %.2f episodes/second, %.0f steps/second\n", stats->episodes / seconds, stats->steps / seconds);
+    printf("Mean episode length: %.1f steps\n", stats->episodes > 0 ? (double)stats->steps / stats->episodes : 0.0);
+    printf("Time in simulate / update / logging: %.2f / %.2f / %.2f ms%s\n", stats->simulate_ms, stats->update_ms, stats->log_ms,
+           num_threads > 1 ? " (summed over threads)" : "");
+    printf("Peak host memory: %.1f MB\n", peak_kb / 1024.0);
+    if (benchmark) {
+        printf("BENCHMARK engine=%s threads=%d seed=%llu episodes=%lld steps=%lld wall_ms=%.2f episodes_per_s=%.2f "
+               "steps_per_s=%.0f simulate_ms=%.2f copy_ms=0.00 update_ms=%.2f log_ms=%.2f peak_host_kb=%ld peak_device_kb=0\n",
+               engine, num_threads, seed, stats->episodes, stats->steps, elapsed_ms, stats->episodes / seconds,
+               stats->steps / seconds, stats->simulate_ms, stats->update_ms, stats->log_ms, peak_kb);
+    }
+}
+
+// Buy/pass comparisons the table has settled: visited states where both actions have two or more returns,
+// and of those the ones whose Q-values differ by more than CONVERGENCE_Z combined standard errors
+static void q_table_convergence(const QTable* qt, int* compared, int* separated) {
+    *compared = 0;
+    *separated = 0;
+    for (int idx = 0; idx < Q_NUM_STATES; ++idx) {
+        const QTableEntry* entry = &qt->entries[idx];
+        if (!entry->used || entry->values[0].count < 2 || entry->values[1].count < 2) continue;
+        double se0 = q_value_std_error(&entry->values[0]), se1 = q_value_std_error(&entry->values[1]);
+        (*compared)++;
+        if (fabs(entry->values[1].q_value - entry->values[0].q_value) > CONVERGENCE_Z * sqrt(se0 * se0 + se1 * se1)) (*separated)++;
+    }
+}
+
+// --- Training Analytics ---
+
+// What the analytics keep of one finished episode
+typedef struct {
+    int steps;
+    int properties_bought; // Properties bought during the episode
+    int properties_owned;  // Owned squares when the episode ended
+    int winner;            // Richest player at the end (a bankrupt player's money is negative)
+    bool bankrupt;         // Ended by a bankruptcy rather than the step limit
+    double total_return;   // Undiscounted sum of the episode's rewards (G of its first step)
+} EpisodeSummary;
+
+// Streaming per-window aggregates written as one CSV row per window of episode ids. Memory does not
+// depend on the run length: a window's sums plus, for Q drift, one snapshot of the dense Q-table.
+typedef struct {
+    FILE* fp;
+    int window;             // Episodes per row
+    int num_players;
+    long long window_index; // Window of the episodes being accumulated, -1 before the first one
+    long long episodes;
+    long long wins[MAX_PLAYERS];
+    long long bankruptcies;
+    long long steps;
+    long long properties_bought;
+    long long properties_owned;
+    double total_return;
+    double* q_snapshot;     // [Q_NUM_STATES * 2] Q-values at the previous row, NULL when drift is not tracked
+    int* count_snapshot;    // [Q_NUM_STATES * 2] visit counts at the previous row
+} TrainingAnalytics;
+
+// Winner and end condition from the players' final money
+static void finish_episode_summary(EpisodeSummary* s, const int* money, int num_players) {
+    s->winner = 0;
+    s->bankrupt = false;
+    for (int p = 0; p < num_players; ++p) {
+        if (money[p] > money[s->winner]) s->winner = p;
+        if (money[p] < 0) s->bankrupt = true;
+    }
+}
+
+// Step count and return of an episode history
+static void summarize_history(EpisodeSummary* s, const EpisodeHistory* history) {
+    s->steps = history->count;
+    s->total_return = 0.0;
+    for (int i = 0; i < history->count; ++i) s->total_return += history->steps[i].reward;
+}
+
+// Summary of the episode env just finished
+static void env_episode_summary(const MonopolyEnv* env, const EpisodeHistory* history, EpisodeSummary* s) {
+    summarize_history(s, history);
+    s->properties_bought = env->properties_bought;
+    s->properties_owned = 0;
+    for (int i = 0; i < env->board_size; ++i) s->properties_owned += env->owner[i] >= 0;
+    finish_episode_summary(s, env->money, env->num_players);
+}
+
+// Summary of the episode a batch lane just finished
+static void env_batch_episode_summary(const MonopolyEnvBatch* b, int lane, const EpisodeHistory* history, EpisodeSummary* s) {
+    int money[MAX_PLAYERS];
+    summarize_history(s, history);
+    s->properties_bought = b->properties_bought[lane];
+    s->properties_owned = 0;
+    for (int i = 0; i < BOARD_SIZE; ++i) s->properties_owned += b->owner[i][lane] >= 0;
+    for (int p = 0; p < b->board.num_players; ++p) money[p] = b->money[p][lane];
+    finish_episode_summary(s, money, b->board.num_players);
+}
+
+// Open the analytics CSV; track_q enables the Q drift columns (they stay empty otherwise)
+static TrainingAnalytics* create_training_analytics(const char* path, int window, int num_players, bool track_q) {
+    TrainingAnalytics* a = (TrainingAnalytics*)calloc(1, sizeof(TrainingAnalytics));
+    if (!a) return NULL;
+    a->window = window;
+    a->num_players = num_players;
+    a->window_index = -1;
+    if (track_q) {
+        a->q_snapshot = (double*)calloc((size_t)Q_NUM_STATES * 2, sizeof(double));
+        a->count_snapshot = (int*)calloc((size_t)Q_NUM_STATES * 2, sizeof(int));
+    }
+    a->fp = fopen(path, "w");
+    if (!a->fp || (track_q && (!a->q_snapshot || !a->count_snapshot))) {
+        fprintf(stderr, "Error: Could not open analytics file '%s' for writing: %s\n", path, strerror(errno));
+        if (a->fp) fclose(a->fp);
+        free(a->q_snapshot);
+        free(a->count_snapshot);
+        free(a);
+        return NULL;
+    }
+    fputs("window_start,episodes", a->fp);
+    for (int p = 0; p < num_players; ++p) fprintf(a->fp, ",win_rate_p%d", p);
+    fputs(",bankruptcy_rate,mean_return,mean_length,mean_properties_bought,mean_properties_owned,q_pairs,q_new_pairs,q_mean_abs_drift,q_max_abs_drift\n", a->fp);
+    return a;
+}
+
+// Compare the Q-table with the snapshot over the (state, action) pairs visited at both times, then take a
+// new snapshot. Writes the Q columns of a row when fp is given; new_pairs were first visited since the snapshot.
+static void analytics_q_drift(TrainingAnalytics* a, const QTable* q_table, FILE* fp) {
+    long long pairs = 0, new_pairs = 0, compared = 0;
+    double drift_sum = 0.0, drift_max = 0.0;
+    for (int idx = 0; idx < Q_NUM_STATES; ++idx) {
+        for (int action = 0; action < 2; ++action) {
+            const QValueData* v = &q_table->entries[idx].values[action];
+            int k = idx * 2 + action;
+            if (v->count > 0) {
+                pairs++;
+                if (a->count_snapshot[k] == 0) {
+                    new_pairs++;
+                } else {
+                    double drift = fabs(v->q_value - a->q_snapshot[k]);
+                    drift_sum += drift;
+                    if (drift > drift_max) drift_max = drift;
+                    compared++;
+                }
+            }
+            a->q_snapshot[k] = v->q_value;
+            a->count_snapshot[k] = v->count;
+        }
+    }
+    if (fp) fprintf(fp, ",%lld,%lld,%.6f,%.6f", pairs, new_pairs, compared > 0 ? drift_sum / compared : 0.0, drift_max);
+}
+
+// Write the open window's row (if it has episodes) and clear its sums
+static void analytics_flush_window(TrainingAnalytics* a, const QTable* q_table) {
+    if (a->episodes == 0) return;
+    double n = (double)a->episodes;
+    fprintf(a->fp, "%lld,%lld", a->window_index * a->window, a->episodes);
+    for (int p = 0; p < a->num_players; ++p) fprintf(a->fp, ",%.6f", a->wins[p] / n);
+    fprintf(a->fp, ",%.6f,%.6f,%.3f,%.6f,%.6f", a->bankruptcies / n, a->total_return / n, a->steps / n, a->properties_bought / n,
+            a->properties_owned / n);
+    if (a->q_snapshot && q_table) {
+        analytics_q_drift(a, q_table, a->fp);
+    } else {
+        fputs(",,,,", a->fp);
+    }
+    fputc('\n', a->fp);
+
+    memset(a->wins, 0, sizeof(a->wins));
+    a->episodes = a->bankruptcies = a->steps = a->properties_bought = a->properties_owned = 0;
+    a->total_return = 0.0;
+}
+
+// Fold one episode in; episodes must arrive in id order. A row is written when its window's last
+// episode arrives (or, with gaps such as a sampled log, when the first episode of a later window does).
+static void analytics_add_episode(TrainingAnalytics* a, int episode_id, const EpisodeSummary* s, const QTable* q_table) {
+    long long window_index = episode_id / a->window;
+    if (window_index != a->window_index) {
+        analytics_flush_window(a, q_table);
+        a->window_index = window_index;
+    }
+    a->episodes++;
+    if (s->winner >= 0 && s->winner < a->num_players) a->wins[s->winner]++;
+    a->bankruptcies += s->bankrupt;
+    a->steps += s->steps;
+    a->properties_bought += s->properties_bought;
+    a->properties_owned += s->properties_owned;
+    a->total_return += s->total_return;
+    if ((episode_id + 1) % a->window == 0) analytics_flush_window(a, q_table);
+}
+
+// Write the partial last window and close the file; returns 0 on success
+static int destroy_training_analytics(TrainingAnalytics* a, const QTable* q_table) {
+    if (!a) return 0;
+    analytics_flush_window(a, q_table);
+    int result = fclose(a->fp);
+    free(a->q_snapshot);
+    free(a->count_snapshot);
+    free(a);
+    return result;
+}
+
+// Offline analytics over a binary log in one streaming pass (only the logged episodes, no Q drift).
+// A log records each mover's money, not what it received from others, so the winner is the richest
+// player by last logged money and the properties are the last logged num_owned per player.
+// Only the fixed StepRecords are read; no text is decoded.
+static int analyze_binary_log(const char* in_path, const char* out_path, int window, int num_players) {
+    FILE* in = fopen(in_path, "rb");
+    if (!in) {
+        fprintf(stderr, "Error: Could not open binary log '%s': %s\n", in_path, strerror(errno));
+        return 1;
+    }
+    LogBinHeader header;
+    if (!read_log_bin_header(in, in_path, &header)) {
+        fclose(in);
+        return 1;
+    }
+    TrainingAnalytics* analytics = create_training_analytics(out_path, window, num_players, false);
+    if (!analytics) {
+        fclose(in);
+        return 1;
+    }
+
+    int status = 0;
+    long long episodes = 0;
+    int episode_header[2];
+    while (status == 0 && fread(episode_header, sizeof(int), 2, in) == 2) {
+        int money[MAX_PLAYERS], owned[MAX_PLAYERS] = {0};
+        bool seen[MAX_PLAYERS] = {false};
+        EpisodeSummary s;
+        memset(&s, 0, sizeof(s));
+        for (int i = 0; i < episode_header[1]; ++i) {
+            StepRecord rec;
+            if (fread(&rec, sizeof(rec), 1, in) != 1 || rec.player >= num_players) {
+                fprintf(stderr, "Error: Truncated binary log '%s' in episode %d.\n", in_path, episode_header[0]);
+                status = 1;
+                break;
+            }
+            if (!seen[rec.player]) money[rec.player] = rec.money_before;
+            seen[rec.player] = true;
+            money[rec.player] = rec.money_before + rec.money_delta;
+            s.properties_bought += (rec.events & STEP_EVT_BOUGHT) != 0;
+            owned[rec.player] = rec.num_owned;
+            s.total_return += rec.reward;
+        }
+        if (status != 0) break;
+        s.steps = episode_header[1];
+        for (int p = 0; p < num_players; ++p) {
+            if (!seen[p]) money[p] = owned[p] = 0;
+            s.properties_owned += owned[p];
+        }
+        finish_episode_summary(&s, money, num_players);
+        analytics_add_episode(analytics, episode_header[0], &s, NULL);
+        episodes++;
+    }
+
+    fclose(in);
+    if (destroy_training_analytics(analytics, NULL) != 0) status = 1;
+    printf("Analyzed %lld logged episodes from '%s' into '%s'.\n", episodes, in_path, out_path);
+    return status;
+}
+
+// --- Worker Pool Training ---
+
+// Environment engine of the worker pool (--env=scalar|batch|simd)
+typedef enum { ENV_ENGINE_SCALAR, ENV_ENGINE_BATCH, ENV_ENGINE_SIMD } EnvEngine;
+
+// Per-thread training state; agent, returns and sink are shared, the rest is private to the worker
+typedef struct {
+    MonteCarloAgent* agent;   // Shared policy, only read while a round is running
+    MonopolyEnv* env;         // Worker-private environment (its random stream is positioned per episode and step)
+    EpisodeArena* arena;      // Worker-private episode scratch
+    MonopolyEnvBatch* batch;  // Worker-private lockstep engine for unlogged episodes, NULL with --env=scalar
+    EpisodeStep* batch_steps; // ENV_BATCH_LANES * MAX_EPISODE_STEPS history steps, MAX_EPISODE_STEPS per lane
+    ConcurrentQTable* returns; // Shared first-visit return accumulator for the current round
+    StepRecord* log_buffer;   // Worker-private step records of one episode
+    FILE* log_chunk;          // Worker-private memory stream the episode's log is formatted into
+    char* chunk_data;         // Backing buffer of log_chunk (owned by open_memstream)
+    size_t chunk_size;
+    LogSink* sink;            // Shared log sink, its file receives one fwrite per logged episode
+    EpisodeSummary* summaries; // PARALLEL_EPISODES_PER_ROUND summaries of this round's episodes, NULL without analytics
+    int first_episode;        // Global id of the first episode of this round
+    int num_episodes;         // Episodes to play this round
+    RunStats stats;           // This round's work and phase times, collected after the join
+    bool failed;
+} TrainingWorker;
+
+// Thread entry: play this round's episodes and accumulate their returns into the shared table.
+// Runs of unlogged episodes go through the batch engine ENV_BATCH_LANES at a time; their histories are
+// the scalar path's and are accumulated in episode order, so the engine does not change the result.
+static void* training_worker_run(void* arg) {
+    TrainingWorker* w = (TrainingWorker*)arg;
+    for (int i = 0; i < w->num_episodes;) {
+        int episode_id = w->first_episode + i;
+        int lanes = 0;
+        while (w->batch && lanes < ENV_BATCH_LANES && i + lanes < w->num_episodes && !log_sink_wants(w->sink, episode_id + lanes)) {
+            lanes++;
+        }
+        if (lanes > 0) {
+            EpisodeHistory histories[ENV_BATCH_LANES];
+            for (int l = 0; l < lanes; ++l) {
+                histories[l].steps = w->batch_steps + (size_t)l * MAX_EPISODE_STEPS;
+                histories[l].count = 0;
+                histories[l].capacity = MAX_EPISODE_STEPS;
+            }
+            double t0 = wall_clock_ms();
+            generate_episodes_batch(w->agent, w->batch, episode_id, lanes, histories);
+            double t1 = wall_clock_ms();
+            for (int l = 0; l < lanes; ++l) {
+                update_mc_concurrent(w->returns, &histories[l], w->arena);
+                w->stats.steps += histories[l].count;
+                if (w->summaries) env_batch_episode_summary(w->batch, l, &histories[l], &w->summaries[i + l]);
+            }
+            w->stats.episodes += lanes;
+            w->stats.simulate_ms += t1 - t0;
+            w->stats.update_ms += wall_clock_ms() - t1;
+            i += lanes;
+            continue;
+        }
+
+        int log_count = 0;
+        bool logged = log_sink_wants(w->sink, episode_id);
+        double t0 = wall_clock_ms();
+        EpisodeHistory history = generate_episode_mc(w->agent, w->env, w->arena, episode_id, logged ? w->log_buffer : NULL, MAX_LOG_ENTRIES, &log_count);
+        if (history.count < 0) {
+            fprintf(stderr, "Error during episode generation %d. Stopping worker.\n", episode_id);
+            w->failed = true;
+            return NULL;
+        }
+        double t1 = wall_clock_ms();
+
+        // Format outside the shared stream; a single fwrite keeps the episode's rows together
+        if (logged) {
+            rewind(w->log_chunk);
+            log_sink_format_episode(w->sink, w->log_chunk, w->env, episode_id, w->log_buffer, log_count);
+            fflush(w->log_chunk);
+            fwrite(w->chunk_data, 1, w->chunk_size, w->sink->fp);
+        }
+        double t2 = wall_clock_ms();
+
+        update_mc_concurrent(w->returns, &history, w->arena);
+        if (w->summaries) env_episode_summary(w->env, &history, &w->summaries[i]);
+        double t3 = wall_clock_ms();
+
+        w->stats.episodes++;
+        w->stats.steps += history.count;
+        w->stats.simulate_ms += t1 - t0;
+        w->stats.log_ms += t2 - t1;
+        w->stats.update_ms += t3 - t2;
+        i++;
+    }
+    return NULL;
+}
+
+// Free every worker's private state
+static void destroy_training_workers(TrainingWorker* workers, int num_workers) {
+    for (int t = 0; t < num_workers; ++t) {
+        destroy_monopoly_env(workers[t].env);
+        destroy_episode_arena(workers[t].arena);
+        destroy_monopoly_env_batch(workers[t].batch);
+        free(workers[t].batch_steps);
+        free(workers[t].log_buffer);
+        free(workers[t].summaries);
+        if (workers[t].log_chunk) fclose(workers[t].log_chunk);
+        free(workers[t].chunk_data);
+    }
+}
+
+// Train with num_threads workers. Episodes are played in rounds: during a round every worker reads the
+// agent's Q-table as a frozen policy and adds its returns to a shared sharded table, which is drained
+// into the agent after all threads joined. Analytics (may be NULL) receive each round's episodes in id order
+// after the merge, so their rows do not depend on the thread count.
+static int train_parallel(MonteCarloAgent* agent, int num_threads, int first_episode, int num_episodes, int start_money, int go_reward,
+                          unsigned long long seed, EnvEngine engine, LogSink* sink, const CheckpointConfig* checkpoint,
+                          TrainingAnalytics* analytics, RunStats* stats) {
+    TrainingWorker workers[MAX_WORKER_THREADS];
+    pthread_t threads[MAX_WORKER_THREADS];
+    bool launched[MAX_WORKER_THREADS];
+    memset(workers, 0, sizeof(workers));
+
+    ConcurrentQTable* returns = create_concurrent_q_table();
+    if (!returns) {
+        fprintf(stderr, "Error: Failed to allocate concurrent Q-table\n");
+        return 1;
+    }
+
+    for (int t = 0; t < num_threads; ++t) {
+        workers[t].agent = agent;
+        workers[t].returns = returns;
+        workers[t].sink = sink;
+        workers[t].env = create_monopoly_env(agent->num_players, start_money, go_reward);
+        workers[t].arena = create_episode_arena(agent->num_players);
+        workers[t].log_buffer = (StepRecord*)malloc(MAX_LOG_ENTRIES * sizeof(StepRecord));
+        workers[t].log_chunk = open_memstream(&workers[t].chunk_data, &workers[t].chunk_size);
+        if (analytics) workers[t].summaries = (EpisodeSummary*)malloc(PARALLEL_EPISODES_PER_ROUND * sizeof(EpisodeSummary));
+        if (!workers[t].env || !workers[t].arena || !workers[t].log_buffer || !workers[t].log_chunk || (analytics && !workers[t].summaries)) {
+            fprintf(stderr, "Error: Failed to allocate state for worker %d\n", t);
+            destroy_training_workers(workers, t + 1);
+            destroy_concurrent_q_table(returns);
+            return 1;
+        }
+        seed_monopoly_env(workers[t].env, seed); // Streams are keyed by episode id, so workers never overlap
+        if (engine != ENV_ENGINE_SCALAR) {
+            workers[t].batch = create_monopoly_env_batch(workers[t].env, engine == ENV_ENGINE_SIMD); // Takes the seeded key
+            workers[t].batch_steps = (EpisodeStep*)malloc((size_t)ENV_BATCH_LANES * MAX_EPISODE_STEPS * sizeof(EpisodeStep));
+            if (!workers[t].batch || !workers[t].batch_steps) {
+                fprintf(stderr, "Error: Failed to allocate the batched environment for worker %d\n", t);
+                destroy_training_workers(workers, t + 1);
+                destroy_concurrent_q_table(returns);
+                return 1;
+            }
+        }
+    }
+
+    int status = 0;
+    int completed = first_episode;
+    int next_report = (first_episode / 5000 + 1) * 5000;
+    while (completed < num_episodes && status == 0) {
+        int round_total = num_episodes - completed;
+        if (round_total > num_threads * PARALLEL_EPISODES_PER_ROUND) {
+            round_total = num_threads * PARALLEL_EPISODES_PER_ROUND;
+        }
+
+        // Split the round into contiguous episode id ranges, one per worker
+        int first = completed;
+        for (int t = 0; t < num_threads; ++t) {
+            launched[t] = false;
+            memset(&workers[t].stats, 0, sizeof(workers[t].stats));
+            workers[t].first_episode = first;
+            workers[t].num_episodes = round_total / num_threads + (t < round_total % num_threads ? 1 : 0);
+            first += workers[t].num_episodes;
+            if (workers[t].num_episodes == 0 || status != 0) continue;
+
+            if (pthread_create(&threads[t], NULL, training_worker_run, &workers[t]) != 0) {
+                fprintf(stderr, "Error: Failed to start worker thread %d\n", t);
+                status = 1;
+                continue;
+            }
+            launched[t] = true;
+        }
+
+        for (int t = 0; t < num_threads; ++t) {
+            if (!launched[t]) continue;
+            pthread_join(threads[t], NULL);
+            if (workers[t].failed) status = 1;
+            add_run_stats(stats, &workers[t].stats);
+        }
+
+        // Fold this round's statistics into the agent
+        double merge_start = wall_clock_ms();
+        if (!cq_drain_into(returns, agent->q_table)) {
+            fprintf(stderr, "Error: Failed to merge concurrent Q-table into the agent\n");
+            status = 1;
+        }
+        stats->update_ms += wall_clock_ms() - merge_start;
+        if (status != 0) break;
+        for (int t = 0; analytics && t < num_threads; ++t) {
+            for (int i = 0; i < workers[t].num_episodes; ++i) {
+                analytics_add_episode(analytics, workers[t].first_episode + i, &workers[t].summaries[i], agent->q_table);
+            }
+        }
+        completed += round_total;
+        checkpoint_progress(checkpoint, agent, completed - round_total, completed, completed == num_episodes);
+
+        // Print progress (less frequently)
+        if (completed >= next_report || completed == num_episodes) {
+            printf("Episode %d/%d completed. Q-Table size: %d\n", completed, num_episodes, agent->q_table->count);
+            while (next_report <= completed) next_report += 5000;
+        }
+    }
+
+    destroy_training_workers(workers, num_threads);
+    destroy_concurrent_q_table(returns);
+    return status;
+}
+
+// --- Policy Evaluation ---
+// --evaluate=CHECKPOINT plays the checkpoint's frozen greedy policy (epsilon = 0) against a baseline
+// opponent in every other seat until the 95% Wilson interval of its win rate is at most --eval-ci wide.
+// Games run ENV_BATCH_LANES at a time on the batch engine; the agent's seat rotates with the episode id
+// so the first-move advantage cancels out. The interval is checked once per round of
+// num_threads * EVAL_EPISODES_PER_ROUND episodes, so the result does not depend on thread timing.
+
+// Baseline opponents
+typedef enum { EVAL_OPPONENT_ALWAYS_BUY, EVAL_OPPONENT_NEVER_BUY, EVAL_OPPONENT_RANDOM, EVAL_NUM_OPPONENTS } EvalOpponent;
+
+static const char* const eval_opponent_names[EVAL_NUM_OPPONENTS] = {"always-buy", "never-buy", "random"};
+
+// Per-thread evaluation state; policy is shared and read-only
+typedef struct {
+    const FrozenPolicy* policy;
+    EvalOpponent opponent;
+    MonopolyEnvBatch* batch;  // Worker-private lockstep engine
+    int first_episode;        // Global id of the first episode of this round
+    int num_episodes;
+    long long wins;           // Games this round in which the agent's seat ended richest
+} EvalWorker;
+
+// Action of the lane's current player: the frozen policy in the agent's seat, the baseline elsewhere.
+// Like select_action_mc, nobody decides (or draws) unless the square can be bought.
+static int eval_action_batch(const EvalWorker* w, MonopolyEnvBatch* b, int lane, StateTuple state, int agent_seat) {
+    if (!env_batch_can_buy(b, lane)) return 0;
+    if (b->current_player[lane] == agent_seat) return frozen_policy_action(w->policy, state);
+    switch (w->opponent) {
+        case EVAL_OPPONENT_ALWAYS_BUY: return 1;
+        case EVAL_OPPONENT_NEVER_BUY: return 0;
+        default: return env_batch_rand(b, lane) % 2;
+    }
+}
+
+// Play episodes first_episode .. first_episode + count - 1 (count <= ENV_BATCH_LANES) in lockstep and
+// return how many the agent won
+static int play_eval_episodes_batch(const EvalWorker* w, MonopolyEnvBatch* b, int first_episode, int count) {
+    StateTuple states[ENV_BATCH_LANES];
+    int actions[ENV_BATCH_LANES] = {0};
+    double rewards[ENV_BATCH_LANES];
+    reset_monopoly_env_batch(b, first_episode, count);
+    for (int lane = 0; lane < count; ++lane) states[lane] = env_batch_state_tuple(b, lane);
+
+    int running = count;
+    while (running > 0) {
+        begin_step_monopoly_env_batch(b);
+        for (int lane = 0; lane < count; ++lane) {
+            if (b->active[lane]) actions[lane] = eval_action_batch(w, b, lane, states[lane], (first_episode + lane) % b->board.num_players);
+        }
+        bool stepped[ENV_BATCH_LANES];
+        for (int lane = 0; lane < count; ++lane) stepped[lane] = b->active[lane] != 0;
+
+        step_monopoly_env_batch(b, actions, rewards);
+
+        for (int lane = 0; lane < count; ++lane) {
+            if (!stepped[lane]) continue;
+            states[lane] = env_batch_state_tuple(b, lane);
+            if (b->steps_taken[lane] >= MAX_EPISODE_STEPS) b->active[lane] = 0;
+            if (!b->active[lane]) running--;
+        }
+    }
+
+    int wins = 0;
+    for (int lane = 0; lane < count; ++lane) {
+        int money[MAX_PLAYERS];
+        EpisodeSummary summary;
+        for (int p = 0; p < b->board.num_players; ++p) money[p] = b->money[p][lane];
+        finish_episode_summary(&summary, money, b->board.num_players);
+        wins += summary.winner == (first_episode + lane) % b->board.num_players;
+    }
+    return wins;
+}
+
+// Thread entry: play this round's episodes
+static void* eval_worker_run(void* arg) {
+    EvalWorker* w = (EvalWorker*)arg;
+    w->wins = 0;
+    for (int i = 0; i < w->num_episodes; i += ENV_BATCH_LANES) {
+        int lanes = w->num_episodes - i < ENV_BATCH_LANES ? w->num_episodes - i : ENV_BATCH_LANES;
+        w->wins += play_eval_episodes_batch(w, w->batch, w->first_episode + i, lanes);
+    }
+    return NULL;
+}
+
+// 95% Wilson score interval of wins / n
+static void wilson_interval(long long wins, long long n, double* low, double* high) {
+    double p = (double)wins / n, z2 = EVAL_Z * EVAL_Z;
+    double center = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+    double half = EVAL_Z * sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * (double)n)) / (1.0 + z2 / n);
+    *low = center - half;
+    *high = center + half;
+}
+
+// Evaluate one opponent until the interval is narrow enough or max_episodes are played; 0 on success
+static int evaluate_against(EvalWorker* workers, int num_threads, EvalOpponent opponent, double ci_width, long long max_episodes) {
+    pthread_t threads[MAX_WORKER_THREADS];
+    long long episodes = 0, wins = 0;
+    double low = 0.0, high = 1.0;
+    double start = wall_clock_ms();
+    while (episodes < max_episodes && high - low > ci_width) {
+        long long round_total = max_episodes - episodes;
+        if (round_total > (long long)num_threads * EVAL_EPISODES_PER_ROUND) round_total = (long long)num_threads * EVAL_EPISODES_PER_ROUND;
+        if (episodes + round_total > INT_MAX) {
+            fprintf(stderr, "Error: Evaluation ran out of episode ids.\n");
+            return 1;
+        }
+        int first = (int)episodes;
+        int launched = 0;
+        for (int t = 0; t < num_threads; ++t) {
+            workers[t].opponent = opponent;
+            workers[t].first_episode = first;
+            workers[t].num_episodes = (int)(round_total / num_threads + (t < round_total % num_threads ? 1 : 0));
+            workers[t].wins = 0;
+            first += workers[t].num_episodes;
+            if (workers[t].num_episodes == 0) continue;
+            if (pthread_create(&threads[t], NULL, eval_worker_run, &workers[t]) != 0) {
+                fprintf(stderr, "Error: Failed to start evaluation thread %d\n", t);
+                for (int j = 0; j < t; ++j) {
+                    if (workers[j].num_episodes > 0) pthread_join(threads[j], NULL);
+                }
+                return 1;
+            }
+            launched = t + 1;
+        }
+        for (int t = 0; t < launched; ++t) {
+            if (workers[t].num_episodes > 0) pthread_join(threads[t], NULL);
+            wins += workers[t].wins;
+        }
+        episodes += round_total;
+        wilson_interval(wins, episodes, &low, &high);
+    }
+
+    double elapsed_ms = wall_clock_ms() - start;
+    printf("vs %-10s win rate %.4f (95%% CI %.4f - %.4f) over %lld episodes in %.0f ms%s\n",
+           eval_opponent_names[opponent], (double)wins / episodes, low, high, episodes, elapsed_ms,
+           high - low > ci_width ? " (episode limit reached before the CI width)" : "");
+    printf("EVAL opponent=%s episodes=%lld wins=%lld win_rate=%.6f ci_low=%.6f ci_high=%.6f wall_ms=%.2f\n",
+           eval_opponent_names[opponent], episodes, wins, (double)wins / episodes, low, high, elapsed_ms);
+    return 0;
+}
+
+// --evaluate: load the checkpoint's greedy policy and evaluate it against one opponent, or all (opponent < 0)
+static int evaluate_checkpoint(const char* path, int num_players, int start_money, int go_reward, unsigned long long seed,
+                               int num_threads, int opponent, double ci_width, long long max_episodes) {
+    FrozenPolicy* policy = load_frozen_policy(path, num_players);
+    if (!policy) {
+        fprintf(stderr, "Error: Could not load a policy from checkpoint '%s'.\n", path);
+        return 1;
+    }
+    MonopolyEnv* env = create_monopoly_env(num_players, start_money, go_reward);
+    EvalWorker workers[MAX_WORKER_THREADS];
+    memset(workers, 0, sizeof(workers));
+    int status = env ? 0 : 1;
+    if (env) seed_monopoly_env(env, seed);
+    for (int t = 0; t < num_threads && status == 0; ++t) {
+        workers[t].policy = policy;
+        workers[t].batch = create_monopoly_env_batch(env, true);
+        if (!workers[t].batch) {
+            fprintf(stderr, "Error: Failed to allocate the batched environment for evaluation worker %d\n", t);
+            status = 1;
+        }
+    }
+
+    if (status == 0) {
+        printf("Evaluating greedy policy '%s' (seed %llu, %d thread%s, %s environment, CI width %.4f)...\n", path, seed,
+               num_threads, num_threads == 1 ? "" : "s", workers[0].batch->use_simd ? "batched AVX2" : "batched portable", ci_width);
+    }
+    for (int o = 0; o < EVAL_NUM_OPPONENTS && status == 0; ++o) {
+        if (opponent >= 0 && o != opponent) continue;
+        status = evaluate_against(workers, num_threads, (EvalOpponent)o, ci_width, max_episodes);
+    }
+
+    for (int t = 0; t < num_threads; ++t) destroy_monopoly_env_batch(workers[t].batch);
+    destroy_monopoly_env(env);
+    destroy_frozen_policy(policy);
+    return status;
 }
 
 // --- Main Function ---
@@ -1488,115 +3450,304 @@ int main(int argc, char *argv[]) {
     int num_episodes = 500; // Default number of episodes - MATCH CUDA VERSION
     double epsilon = 0.1;
     const char* csv_filename = "monopoly_training_log_seq.csv"; // Different filename
+    int num_threads = 1; // 1 = original single-threaded loop, 0 = one worker per online core
+    LogSink log_sink = {LOG_MODE_CSV, 1, NULL, NULL};
+    const char* convert_from = NULL; // --convert-log=FILE: convert a binary log to CSV and exit
+    unsigned long long seed = (unsigned long long)time(NULL); // --seed=N makes a run reproducible
+    CheckpointConfig checkpoint = {NULL, CHECKPOINT_DEFAULT_EVERY, 0, {1, 0, 0}}; // --checkpoint=FILE saves progress periodically
+    const char* resume_path = NULL; // --resume=FILE continues a checkpointed run up to num_episodes
+    bool benchmark = false; // --benchmark: fixed-seed, unlogged workload with a machine-readable summary
+    bool seed_given = false, log_mode_given = false;
+    EnvEngine engine = ENV_ENGINE_SIMD; // --env: how the worker pool (--threads > 1) plays unlogged episodes
+    const char* analytics_path = NULL; // --analytics=FILE: per-window win rates, returns and Q drift while training
+    int analytics_window = ANALYTICS_DEFAULT_WINDOW;
+    const char* analyze_from = NULL; // --analyze-log=FILE: the same rows from a binary log, then exit
+    const char* evaluate_from = NULL; // --evaluate=CHECKPOINT: greedy policy vs baseline opponents, then exit
+    int eval_opponent = -1; // --eval-opponent: one EvalOpponent, or -1 for all of them
+    double eval_ci_width = EVAL_DEFAULT_CI_WIDTH;
+    long long eval_max_episodes = EVAL_DEFAULT_MAX_EPISODES;
 
     // --- Command Line Arguments (Optional) ---
-    if (argc > 1) {
-        num_episodes = atoi(argv[1]);
-        if (num_episodes <= 0) {
-            fprintf(stderr, "Warning: Invalid number of episodes specified. Using default %d.\n", 10000);
-            num_episodes = 500;
+    // Usage: monopoly [num_episodes] [log_filename] [--threads=N] [--seed=N] [--log=off|csv|bin] [--log-every=N]
+    //                [--checkpoint=FILE] [--checkpoint-every=N] [--resume=FILE] [--benchmark] [--env=scalar|batch|simd]
+    //                [--analytics=FILE] [--analytics-window=N]
+    //        monopoly --convert-log=train.bin [csv_filename]
+    //        monopoly --analyze-log=train.bin [--analytics=FILE] [--analytics-window=N]
+    //        monopoly --evaluate=CHECKPOINT [--eval-opponent=always-buy|never-buy|random|all] [--eval-ci=W]
+    //                [--eval-max-episodes=N] [--threads=N] [--seed=N]
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--", 2) == 0) {
+            if (strncmp(argv[i], "--threads=", 10) == 0) {
+                num_threads = atoi(argv[i] + 10);
+                if (num_threads < 0 || num_threads > MAX_WORKER_THREADS) {
+                    fprintf(stderr, "Warning: Invalid thread count '%s'. Using 1.\n", argv[i] + 10);
+                    num_threads = 1;
+                }
+            } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+                seed = strtoull(argv[i] + 7, NULL, 10);
+                seed_given = true;
+            } else if (strcmp(argv[i], "--log=off") == 0) {
+                log_sink.mode = LOG_MODE_OFF;
+                log_mode_given = true;
+            } else if (strcmp(argv[i], "--log=csv") == 0) {
+                log_sink.mode = LOG_MODE_CSV;
+                log_mode_given = true;
+            } else if (strcmp(argv[i], "--log=bin") == 0) {
+                log_sink.mode = LOG_MODE_BIN;
+                log_mode_given = true;
+            } else if (strncmp(argv[i], "--log-every=", 12) == 0) {
+                log_sink.sample_every = atoi(argv[i] + 12);
+                if (log_sink.sample_every <= 0) {
+                    fprintf(stderr, "Warning: Invalid log sampling interval '%s'. Logging every episode.\n", argv[i] + 12);
+                    log_sink.sample_every = 1;
+                }
+            } else if (strncmp(argv[i], "--convert-log=", 14) == 0) {
+                convert_from = argv[i] + 14;
+            } else if (strncmp(argv[i], "--checkpoint=", 13) == 0) {
+                checkpoint.path = argv[i] + 13;
+            } else if (strncmp(argv[i], "--checkpoint-every=", 19) == 0) {
+                checkpoint.every = atoi(argv[i] + 19);
+                if (checkpoint.every <= 0) {
+                    fprintf(stderr, "Warning: Invalid checkpoint interval '%s'. Using %d.\n", argv[i] + 19, CHECKPOINT_DEFAULT_EVERY);
+                    checkpoint.every = CHECKPOINT_DEFAULT_EVERY;
+                }
+            } else if (strncmp(argv[i], "--resume=", 9) == 0) {
+                resume_path = argv[i] + 9;
+            } else if (strcmp(argv[i], "--benchmark") == 0) {
+                benchmark = true;
+            } else if (strcmp(argv[i], "--env=scalar") == 0) {
+                engine = ENV_ENGINE_SCALAR;
+            } else if (strcmp(argv[i], "--env=batch") == 0) {
+                engine = ENV_ENGINE_BATCH;
+            } else if (strcmp(argv[i], "--env=simd") == 0) {
+                engine = ENV_ENGINE_SIMD;
+            } else if (strncmp(argv[i], "--analytics=", 12) == 0) {
+                analytics_path = argv[i] + 12;
+            } else if (strncmp(argv[i], "--analytics-window=", 19) == 0) {
+                analytics_window = atoi(argv[i] + 19);
+                if (analytics_window <= 0) {
+                    fprintf(stderr, "Warning: Invalid analytics window '%s'. Using %d.\n", argv[i] + 19, ANALYTICS_DEFAULT_WINDOW);
+                    analytics_window = ANALYTICS_DEFAULT_WINDOW;
+                }
+            } else if (strncmp(argv[i], "--analyze-log=", 14) == 0) {
+                analyze_from = argv[i] + 14;
+            } else if (strncmp(argv[i], "--evaluate=", 11) == 0) {
+                evaluate_from = argv[i] + 11;
+            } else if (strncmp(argv[i], "--eval-opponent=", 16) == 0) {
+                eval_opponent = -1;
+                for (int o = 0; o < EVAL_NUM_OPPONENTS; ++o) {
+                    if (strcmp(argv[i] + 16, eval_opponent_names[o]) == 0) eval_opponent = o;
+                }
+                if (eval_opponent < 0 && strcmp(argv[i] + 16, "all") != 0) {
+                    fprintf(stderr, "Warning: Unknown opponent '%s'. Using all.\n", argv[i] + 16);
+                }
+            } else if (strncmp(argv[i], "--eval-ci=", 10) == 0) {
+                eval_ci_width = atof(argv[i] + 10);
+                if (eval_ci_width <= 0.0 || eval_ci_width >= 1.0) {
+                    fprintf(stderr, "Warning: Invalid CI width '%s'. Using %.2f.\n", argv[i] + 10, EVAL_DEFAULT_CI_WIDTH);
+                    eval_ci_width = EVAL_DEFAULT_CI_WIDTH;
+                }
+            } else if (strncmp(argv[i], "--eval-max-episodes=", 20) == 0) {
+                eval_max_episodes = atoll(argv[i] + 20);
+                if (eval_max_episodes <= 0 || eval_max_episodes > INT_MAX) {
+                    fprintf(stderr, "Warning: Invalid episode limit '%s'. Using %d.\n", argv[i] + 20, EVAL_DEFAULT_MAX_EPISODES);
+                    eval_max_episodes = EVAL_DEFAULT_MAX_EPISODES;
+                }
+            } else {
+                fprintf(stderr, "Warning: Unknown option '%s' ignored.\n", argv[i]);
+            }
+        } else if (positional == 0 && convert_from) {
+            csv_filename = argv[i]; // Converter output
+            positional = 2;
+        } else if (positional == 0) {
+            num_episodes = atoi(argv[i]);
+            if (num_episodes <= 0) {
+                fprintf(stderr, "Warning: Invalid number of episodes specified. Using default %d.\n", 500);
+                num_episodes = 500;
+            }
+            positional++;
+        } else if (positional == 1) {
+            csv_filename = argv[i];
+            positional++;
         }
     }
-    if (argc > 2) {
-        csv_filename = argv[2];
+    if (num_threads == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cores < 1 ? 1 : (cores > MAX_WORKER_THREADS ? MAX_WORKER_THREADS : (int)cores);
+    }
+    if (benchmark) {
+        if (!seed_given) seed = BENCHMARK_SEED;
+        if (!log_mode_given) log_sink.mode = LOG_MODE_OFF;
     }
 
-    // --- Initialization ---
-    srand(time(NULL)); // Seed random number generator
+    if (convert_from) {
+        return convert_binary_log(convert_from, csv_filename);
+    }
+    if (analyze_from) {
+        return analyze_binary_log(analyze_from, analytics_path ? analytics_path : ANALYTICS_DEFAULT_FILE, analytics_window, num_players);
+    }
+    if (evaluate_from) {
+        return evaluate_checkpoint(evaluate_from, num_players, start_money, go_reward, seed, num_threads, eval_opponent,
+                                   eval_ci_width, eval_max_episodes);
+    }
 
-    printf("Initializing Host Environment...\n");
+    // --- Initialization ---
+    printf("Initializing Host Environment (seed %llu)...\n", seed);
     MonopolyEnv* env = create_monopoly_env(num_players, start_money, go_reward);
     MonteCarloAgent* agent = create_monte_carlo_agent(num_players, epsilon);
+    EpisodeArena* arena = create_episode_arena(num_players); // Scratch of the single-threaded loop
 
-    if (!env || !agent) {
+    if (!env || !agent || !arena) {
         fprintf(stderr, "Error: Failed to initialize environment or agent.\n");
+        destroy_episode_arena(arena);
         destroy_monopoly_env(env);
         destroy_monte_carlo_agent(agent);
         return 1;
     }
 
-    // --- Open CSV File ---
-    printf("Opening CSV file '%s'...\n", csv_filename);
-    FILE* csv_file = fopen(csv_filename, "w");
-    if (!csv_file) {
-        fprintf(stderr, "Error: Could not open CSV file '%s' for writing: %s\n", csv_filename, strerror(errno));
+    // --- Resume ---
+    // The checkpoint supplies the Q-table, the seed and the next episode id, so the run continues its streams
+    int first_episode = 0;
+    if (resume_path) {
+        long long episodes_done = 0;
+        CheckpointSlice slice;
+        bool loaded = load_checkpoint(resume_path, agent->q_table, num_players, &seed, &episodes_done, &slice);
+        if (loaded && slice.ranks != 1) {
+            // Its progress counts episodes of one rank's slice, not of the episode ids from 0
+            fprintf(stderr, "Error: Checkpoint '%s' holds one rank's slice of a %d-rank CUDA run.\n", resume_path, slice.ranks);
+            loaded = false;
+        }
+        if (!loaded) {
+            destroy_episode_arena(arena);
+            destroy_monopoly_env(env);
+            destroy_monte_carlo_agent(agent);
+            return 1;
+        }
+        first_episode = episodes_done < num_episodes ? (int)episodes_done : num_episodes;
+        printf("Resumed from '%s' after %lld episodes (seed %llu, Q-Table size %d).\n",
+               resume_path, episodes_done, seed, agent->q_table->count);
+    }
+    checkpoint.seed = seed;
+    seed_monopoly_env(env, seed);
+
+    // --- Open Log File ---
+    if (log_sink.mode != LOG_MODE_OFF) {
+        printf("Opening %s log file '%s'...\n", log_sink.mode == LOG_MODE_BIN ? "binary" : "CSV", csv_filename);
+    }
+    if (!log_sink_open(&log_sink, csv_filename, env)) {
+        fprintf(stderr, "Error: Could not open log file '%s' for writing: %s\n", csv_filename, strerror(errno));
+        destroy_episode_arena(arena);
         destroy_monopoly_env(env);
         destroy_monte_carlo_agent(agent);
         return 1;
     }
-
-    // --- Write CSV Header ---
-    fprintf(csv_file, "episode_id,step,player,position_before,dice_roll,landed_on_position,position_after,money_before,money_after,reward,done,in_jail,fee_paid,agent_action,num_owned_properties,card_drawn,card_specific_desc,action_desc\n");
-    fflush(csv_file); // Ensure header is written
-
-    printf("Starting Sequential Monte Carlo Training for %d episodes...\n", num_episodes);
+    TrainingAnalytics* analytics = NULL;
+    if (analytics_path) {
+        analytics = create_training_analytics(analytics_path, analytics_window, num_players, true);
+        if (!analytics) {
+            log_sink_close(&log_sink);
+            destroy_episode_arena(arena);
+            destroy_monopoly_env(env);
+            destroy_monte_carlo_agent(agent);
+            return 1;
+        }
+        analytics_q_drift(analytics, agent->q_table, NULL); // The first row's drift is from the starting (or resumed) table
+    }
 
     // --- Training Loop with Timing ---
-    clock_t start_time = clock();
-
-    for (int ep = 0; ep < num_episodes; ++ep) {
-        LogEntry* episode_logs = NULL;
+    RunStats stats;
+    memset(&stats, 0, sizeof(stats));
+    double start_time = wall_clock_ms();
+
+    if (num_threads > 1) {
+        const char* engine_name = engine == ENV_ENGINE_SCALAR ? "scalar"
+                                : (engine == ENV_ENGINE_SIMD && env_batch_simd_available()) ? "batched AVX2" : "batched portable";
+        printf("Starting Parallel Monte Carlo Training for %d episodes on %d threads (%s environment)...\n",
+               num_episodes - first_episode, num_threads, engine_name);
+        if (train_parallel(agent, num_threads, first_episode, num_episodes, start_money, go_reward, seed, engine, &log_sink,
+                           &checkpoint, analytics, &stats) != 0) {
+            fprintf(stderr, "Error: Parallel training stopped early.\n");
+        }
+    } else {
+        printf("Starting Sequential Monte Carlo Training for %d episodes...\n", num_episodes - first_episode);
+    }
+    static StepRecord episode_logs[MAX_LOG_ENTRIES];
+    for (int ep = first_episode; num_threads <= 1 && ep < num_episodes; ++ep) {
         int log_count = 0;
+        bool logged = log_sink_wants(&log_sink, ep);
 
-        // Generate an episode using the current policy and capture logs
-        EpisodeHistory history = generate_episode_mc(agent, env, ep, &episode_logs, &log_count);
+        // Generate an episode using the current policy and capture logs (only if this episode is logged)
+        double t0 = wall_clock_ms();
+        EpisodeHistory history = generate_episode_mc(agent, env, arena, ep, logged ? episode_logs : NULL, MAX_LOG_ENTRIES, &log_count);
 
         if (history.count < 0) {
             fprintf(stderr, "Error during episode generation %d. Stopping.\n", ep);
             break;
         }
+        double t1 = wall_clock_ms();
 
-        // Write the logs for this episode to the CSV file
-        if (episode_logs != NULL) {
-            for (int i = 0; i < log_count; ++i) {
-                write_log_to_csv(csv_file, &episode_logs[i]);
-            }
+        // Write the logs for this episode
+        if (logged) {
+            log_sink_format_episode(&log_sink, log_sink.fp, env, ep, episode_logs, log_count);
         }
+        double t2 = wall_clock_ms();
 
         // Update the agent's Q-values based on the episode history
-        update_mc(agent, &history);
-
-        // Free the memory used by the episode history struct itself
-        free_episode_history(&history);
+        update_mc(agent, &history, arena);
+        if (analytics) {
+            EpisodeSummary summary;
+            env_episode_summary(env, &history, &summary);
+            analytics_add_episode(analytics, ep, &summary, agent->q_table);
+        }
+        double t3 = wall_clock_ms();
+        stats.episodes++;
+        stats.steps += history.count;
+        stats.simulate_ms += t1 - t0;
+        stats.log_ms += t2 - t1;
+        stats.update_ms += t3 - t2;
+        checkpoint_progress(&checkpoint, agent, ep, ep + 1, ep + 1 == num_episodes);
 
         // Print progress (less frequently)
         if ((ep + 1) % 5000 == 0 || ep == num_episodes - 1) {
             printf("Episode %d/%d completed. Q-Table size: %d\n", ep + 1, num_episodes, agent->q_table ? agent->q_table->count : 0);
-            fflush(csv_file);
         }
     }
 
-    clock_t end_time = clock();
-    double cpu_time_used = ((double) (end_time - start_time)) / CLOCKS_PER_SEC;
+    double elapsed_ms = wall_clock_ms() - start_time;
 
     printf("\n--- Performance Metrics ---\n");
-    printf("CPU Training Time: %.2f milliseconds\n", cpu_time_used * 1000.0);
-    printf("Training throughput: %.2f episodes/second\n", num_episodes / cpu_time_used);
+    print_run_stats(num_threads > 1 ? "cpu-parallel" : "seq", num_threads, seed, &stats, elapsed_ms, benchmark);
     printf("------------------------\n");
 
-    // --- Close CSV File ---
-    if (fclose(csv_file) != 0) {
-        fprintf(stderr, "Warning: Error closing CSV file '%s': %s\n", csv_filename, strerror(errno));
-    } else {
+    // --- Close Log File ---
+    bool had_log = log_sink.fp != NULL;
+    if (log_sink_close(&log_sink) != 0) {
+        fprintf(stderr, "Warning: Error closing log file '%s': %s\n", csv_filename, strerror(errno));
+    } else if (had_log) {
         printf("Log saved to '%s'.\n", csv_filename);
     }
+    if (analytics) {
+        if (destroy_training_analytics(analytics, agent->q_table) != 0) {
+            fprintf(stderr, "Warning: Error closing analytics file '%s': %s\n", analytics_path, strerror(errno));
+        } else {
+            printf("Analytics saved to '%s' (%d episodes per row).\n", analytics_path, analytics_window);
+        }
+    }
 
     // --- Optional: Print some learned Q-values ---
     printf("\nExample Q-values (State: Pos, MoneyBin, PropOwner, InJail):\n");
     int print_count = 0;
-    if (agent && agent->q_table && agent->q_table->table) {
-        for (int i = 0; i < agent->q_table->size && print_count < 20; ++i) {
-            QTableEntry* entry = agent->q_table->table[i];
-            while (entry != NULL && print_count < 20) {
-                StateTuple s = entry->key;
-                if (entry->values[0].count > 0 || entry->values[1].count > 0) {
-                    printf(" State (%2d, %3d, %2d, %d): Q(Pass)=%8.2f (%5d visits), Q(Buy)=%8.2f (%5d visits)\n",
-                           s.position, s.money_bin, s.current_prop_owner, s.in_jail,
-                           entry->values[0].q_value, entry->values[0].count,
-                           entry->values[1].q_value, entry->values[1].count);
-                    print_count++;
-                }
-                entry = entry->next;
+    if (agent && agent->q_table && agent->q_table->entries) {
+        for (int idx = 0; idx < Q_NUM_STATES && print_count < 20; ++idx) {
+            const QTableEntry* entry = &agent->q_table->entries[idx];
+            if (entry->values[0].count > 0 || entry->values[1].count > 0) {
+                StateTuple s = state_tuple_from_index(idx);
+                printf(" State (%2d, %3d, %2d, %d): Q(Pass)=%8.2f +/- %6.2f (%5d visits), Q(Buy)=%8.2f +/- %6.2f (%5d visits)\n",
+                       s.position, s.money_bin, s.current_prop_owner, s.in_jail,
+                       entry->values[0].q_value, q_value_std_error(&entry->values[0]), entry->values[0].count,
+                       entry->values[1].q_value, q_value_std_error(&entry->values[1]), entry->values[1].count);
+                print_count++;
             }
         }
         if (print_count == 0) {
@@ -1604,15 +3755,21 @@ int main(int argc, char *argv[]) {
         } else {
             printf(" Printed top %d Q-value entries found.\n", print_count);
         }
+        int compared = 0, separated = 0;
+        q_table_convergence(agent->q_table, &compared, &separated);
+        printf("Q-value convergence: buy and pass differ at 95%% confidence in %d of %d states with both actions tried\n",
+               separated, compared);
     } else {
         printf(" Q-Table not available for printing.\n");
     }
 
     // --- Clean up ---
     printf("\nCleaning up...\n");
+    destroy_episode_arena(arena);
     destroy_monte_carlo_agent(agent);
     destroy_monopoly_env(env);
     printf("Done.\n");
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -7,8 +7,16 @@
 #include <limits.h>
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 #include <cuda_runtime.h>
-#include <curand_kernel.h>
+#ifdef MONOPOLY_USE_MPI
+#include <mpi.h>
+#endif
 
 // --- Constants ---
 #define BOARD_SIZE 40
@@ -17,38 +25,119 @@
 #define MAX_NAME_LEN 64
 #define MAX_DESC_LEN 256
 #define MAX_DECK_SIZE 16
-#define Q_TABLE_INITIAL_SIZE 1024
-#define VISITED_SET_INITIAL_SIZE 256
+#define DICE_OUTCOMES 36                 // Two-dice rolls, one random word each (see dice_outcome)
+#define DICE_PASSES_GO 1                 // DiceTransition.flags: the move collects the GO reward
+#define DICE_DOUBLES 2                   // DiceTransition.flags: both dice show the same face
+#define CQ_SHARD_BITS 6                       // Concurrent Q-table: 2^6 independently locked shards
+#define CQ_NUM_SHARDS (1 << CQ_SHARD_BITS)
+#define CQ_SHARD_INITIAL_CAPACITY 64          // Open-addressed slots per shard (power of two), doubled at 70% load
 #define MAX_EPISODE_STEPS 500
+#define CHECKPOINT_MAGIC "MCQTCKP"            // 8 bytes with the terminator
+#define CHECKPOINT_VERSION 3                  // 2: QValueData carries sum_sq_returns, 3: header records the rank's slice
+#define CHECKPOINT_HEADER_BYTES 4096          // Entries start page-aligned so they can be mmap'd in place
+#define CHECKPOINT_DEFAULT_EVERY 10000        // Episodes between checkpoints unless --checkpoint-every=N
+#define BENCHMARK_SEED 20240601ull            // --benchmark workload seed unless --seed=N is given
+#define CONVERGENCE_Z 1.959964                // Normal quantile of the 95% buy-vs-pass test of q_table_convergence
+#define PHILOX_M0 0xD2511F53u                  // Philox4x32 round multipliers
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u                  // Philox4x32 key schedule (Weyl) increments
+#define PHILOX_W1 0xBB67AE85u
 #define LOG_BUFFER_SIZE 1000
 
-#define NUM_CHANCE_CARDS 4
-#define NUM_CHEST_CARDS 4
+#define NUM_CARD_DECKS 2                    // Chance and Community Chest, see CardDeckKind
+#define DECK_LINE_MAX 512                   // Longest line of a --deck file
+
+// Game rules shared by the host step and the kernel
+#define MAX_HOUSES 5                              // 4 houses + 1 hotel
+#define JAIL_FEE 50
+#define BANKRUPTCY_PENALTY 1000.0
+#define RENT_MULTIPLIERS 0x7D502D0F0501ull        // Rent multiplier per house count, one byte each: 1, 5, 15, 45, 80, 125
+#define CHANCE_SQUARES ((1ull << 7) | (1ull << 22) | (1ull << 36))
+#define CHEST_SQUARES ((1ull << 2) | (1ull << 17) | (1ull << 33))
+#define STANDARD_GO_REWARD 200                    // Standard rules, compiled into the specialized kernels
+#define STANDARD_JAIL_POSITION 10
+#define STANDARD_GO_TO_JAIL_POSITION 30
+#define STANDARD_JAIL_TURNS 3
 
 // CUDA-specific constants
-#define THREADS_PER_BLOCK 512
-#define MAX_BLOCKS 128
+#define THREADS_PER_BLOCK 512           // Fallback when the occupancy calculator gives no block size
+#define EPISODES_PER_LANE 4             // Default batch: episodes per launched lane (the policy refreshes per batch)
+#define DEVICE_MEMORY_BUDGET_PERCENT 80 // Share of free device memory the in-flight batches may use
+#define HOST_MEMORY_BUDGET_PERCENT 25   // Share of physical host memory for pinned episode copies
+#define MAX_PIPELINE_SLOTS 4       // Batches that can be in flight at once per GPU in the training loop
+#define MAX_GPUS 16
+#define DEFAULT_PIPELINE_SLOTS 2   // A batch's policy then lags by up to DEFAULT_PIPELINE_SLOTS * GPUs - 1 batches
+#define MAX_HOST_UPDATE_THREADS 64
+#define MAX_SWEEP_CONFIGS 32       // --sweep: hyperparameter configurations trained side by side in one run
+#define MC_UPDATE_THREADS 512      // mc_update_kernel: one block per episode, one thread per step
+#define MC_UPDATE_HASH_SLOTS 1024  // Shared-memory first-visit table per block (power of two, > MAX_EPISODE_STEPS)
+
+// Dense state indexing for the device-side policy table
+#define Q_MONEY_BINS 160                 // money_bin is clamped into [0, Q_MONEY_BINS - 1]
+#define Q_OWNER_SLOTS (MAX_PLAYERS + 1)  // current_prop_owner in [-1, MAX_PLAYERS)
+#define Q_NUM_STATES (BOARD_SIZE * Q_MONEY_BINS * Q_OWNER_SLOTS * 2)
+#define Q_DELTA_SLOTS (Q_NUM_STATES * 2 + 1) // Per config: (state, action) sums/counts, then the episode totals
+
+// Greedy action codes stored per state in the device policy table
+#define GREEDY_PASS 0
+#define GREEDY_BUY 1
+#define GREEDY_TIE 2 // Q-values equal (or unvisited), break the tie randomly
+
+#if MAX_EPISODE_STEPS > MC_UPDATE_THREADS
+#error "mc_update_kernel needs one thread per episode step"
+#endif
 
 // --- Structures ---
 
 // Forward declaration
 struct MonopolyEnv;
 
-// Result structure for card effects
+// Result structure for card and square effects
 typedef struct {
     double reward;
     char card_specific_desc[MAX_DESC_LEN];
 } CardEffectResult;
 
-// Function pointer type for card effects
-typedef CardEffectResult (*CardEffectFunc)(struct MonopolyEnv* env, int player_index);
+// Card decks, also the first index of MonopolyEnv.decks and c_card_effects
+typedef enum {
+    CARD_DECK_CHANCE = 0,
+    CARD_DECK_CHEST = 1
+} CardDeckKind;
+
+// What a card does. Cards are data: apply_card_effect interprets them on the host and in the kernel.
+typedef enum {
+    CARD_OP_MONEY = 0,   // Collect amount from the bank (negative pays it)
+    CARD_OP_ADVANCE = 1, // Move forward to square target, collecting the GO reward when passing GO
+    CARD_OP_MOVE = 2,    // Move amount squares (negative moves back), collecting the GO reward on a forward wrap
+    CARD_OP_JAIL = 3     // Go directly to jail
+} CardOp;
+
+// Declarative card effect (4 bytes, so both full decks are 128 bytes of constant memory)
+typedef struct {
+    unsigned char op;     // CardOp
+    unsigned char target; // Destination square of CARD_OP_ADVANCE
+    short amount;         // Dollars for CARD_OP_MONEY, squares for CARD_OP_MOVE
+} CardEffect;
 
 // Card structure
 typedef struct {
     char name[MAX_NAME_LEN];
-    CardEffectFunc effect;
+    char desc[MAX_DESC_LEN]; // Printed card text, used when decoding GPU step records
+    CardEffect effect;
 } Card;
 
+// What a square does when a move ends on it (properties are told apart by their price)
+typedef enum { SQUARE_PLAIN, SQUARE_TAX, SQUARE_CHANCE, SQUARE_CHEST, SQUARE_GO_TO_JAIL } SquareClass;
+
+// One precomputed roll: where outcome 6 * (die1 - 1) + (die2 - 1) takes a player standing on a square.
+// Four bytes, so the whole [square][roll] table is 5.6 KB of constant (and per-block shared) memory.
+typedef struct {
+    unsigned char landing;    // Square the move ends on
+    unsigned char square;     // SquareClass of the landing square
+    unsigned char dice_total; // 2 .. 12, as logged
+    unsigned char flags;      // DICE_PASSES_GO | DICE_DOUBLES
+} DiceTransition;
+
 // Property structure
 typedef struct {
     int price;
@@ -59,6 +148,17 @@ typedef struct {
     int house_cost; // Needed for bankruptcy selling logic
 } Property;
 
+// Counter-based random stream (Philox4x32-10). The key is the run seed and the counter is
+// (episode, step, block, 0), so every draw is a pure function of where it happens in training.
+typedef struct {
+    unsigned int key[2];
+    unsigned int episode;
+    unsigned int step;
+    unsigned int block;       // Next counter block within the current step
+    unsigned int buffer[4];   // Unused words of the last generated block
+    int available;
+} PhiloxStream;
+
 // Log entry structure (mimics Python dictionary)
 typedef struct {
     int step;
@@ -103,15 +203,19 @@ typedef struct MonopolyEnv {
     int steps_taken;
     bool done;
 
-    // Decks
-    Card chance_deck[MAX_DECK_SIZE];
-    int chance_deck_size;
-    Card chest_deck[MAX_DECK_SIZE];
-    int chest_deck_size;
+    // Decks, indexed by CardDeckKind (defaults from initialize_decks, replaced by load_card_decks)
+    Card decks[NUM_CARD_DECKS][MAX_DECK_SIZE];
+    int deck_sizes[NUM_CARD_DECKS];
+
+    // Every roll from every square under the configuration above (see build_dice_transitions)
+    DiceTransition transitions[BOARD_SIZE][DICE_OUTCOMES];
 
     // Observation space bounds
     int obs_money_high;
 
+    // Per-environment counter-based random stream (see PhiloxStream)
+    PhiloxStream rng;
+
     // Log entry for the last step
     LogEntry last_log;
 
@@ -136,42 +240,43 @@ typedef struct {
 // Data stored for each ACTION within a state entry in the Q-table
 typedef struct {
     double sum_returns;
+    double sum_sq_returns; // Sum of squared returns, for q_value_std_error
     int count;
     double q_value; // q_value = sum_returns / count
 } QValueData;
 
-// An entry in the Q-value hash table (using chaining for collisions)
-typedef struct QTableEntry {
-    StateTuple key;
+// One state of the dense Q-table; the StateTuple is implied by the entry's index
+typedef struct {
     QValueData values[2]; // Index 0 for action 0 (Pass), 1 for action 1 (Buy)
-    struct QTableEntry* next; // Pointer for chaining
+    bool used;            // Set once the state has been looked up through find_or_create_q_entry
 } QTableEntry;
 
-// The Q-value hash table structure
+// Dense Q-table: one entry per representable StateTuple, addressed by state_tuple_index()
 typedef struct {
-    QTableEntry** table;
-    int size;
-    int count; // Number of entries
-} QHashTable;
+    QTableEntry* entries; // Q_NUM_STATES entries, allocated once up front
+    int count; // Number of used entries
+    size_t mapped_bytes; // Non-zero when entries is a private mapping of a checkpoint
+} QTable;
 
-// Represents a (StateTuple, action) pair for the visited set during update
+// One open-addressed slot of a concurrent Q-table shard
 typedef struct {
-    StateTuple state;
-    int action;
-} VisitedKey;
-
-// An entry in the visited set hash table (using chaining)
-typedef struct VisitedSetEntry {
-    VisitedKey key;
-    struct VisitedSetEntry* next;
-} VisitedSetEntry;
+    StateTuple key;
+    QValueData values[2]; // Only the sums and count are accumulated; q_value is derived on drain
+    bool used;
+} CQSlot;
 
-// The visited set hash table structure
+// A shard owns a disjoint part of the state space and is guarded by its own mutex
 typedef struct {
-    VisitedSetEntry** table;
-    int size;
+    pthread_mutex_t lock;
+    CQSlot* slots;
+    int capacity;
     int count;
-} VisitedSet;
+} CQShard;
+
+// Sharded return/count accumulator that many threads can update at once
+typedef struct {
+    CQShard shards[CQ_NUM_SHARDS];
+} ConcurrentQTable;
 
 // Structure to hold one step of an episode's history
 typedef struct {
@@ -187,123 +292,328 @@ typedef struct {
     int capacity;
 } EpisodeHistory;
 
+// Per-worker scratch reused by every episode: the history steps, the observation buffer and the
+// first-visit stamps of the MC update. Once created, steady-state training allocates nothing.
+typedef struct {
+    EpisodeStep* steps;           // MAX_EPISODE_STEPS entries backing the current EpisodeHistory
+    int* obs;                     // get_observation_size(num_players) ints
+    unsigned short* visit_stamps; // [Q_NUM_STATES * 2]: generation of the pass that last visited each (state, action)
+    unsigned short generation;    // Stamp of the current pass (0 is never live)
+} EpisodeArena;
+
 // The Monte Carlo Agent structure
 typedef struct {
     double epsilon;
     int num_players;
-    QHashTable* q_table; // Pointer to the Q-value hash table
+    QTable* q_table; // Dense Q-value table
 } MonteCarloAgent;
 
 // CUDA-specific structures for parallel episode generation
+
+// Batched struct-of-arrays environment state in global memory. Element [slot][lane] lives at
+// slot * stride + lane, so the lanes of a warp touch consecutive words. Ownership is bit-packed:
+// bit i of owned_masks[p][lane] is set when player p owns square i (BOARD_SIZE <= 64).
+// houses[i][lane] is only meaningful while square i is owned; buying a square resets it.
 typedef struct {
-    int positions[MAX_PLAYERS];
-    int money[MAX_PLAYERS];
-    int in_jail[MAX_PLAYERS];
-    int jail_counters[MAX_PLAYERS];
-    int property_owners[MAX_PROPERTIES];
-    int property_houses[MAX_PROPERTIES];
-    int current_player;
-    int steps_taken;
-    bool done;
-    curandState rand_state;
-} CUDAEnvState;
+    int stride;                      // Number of lanes (threads) the arrays are sized for
+    int* positions;                  // [MAX_PLAYERS][stride]
+    int* money;                      // [MAX_PLAYERS][stride]
+    unsigned char* in_jail;          // [MAX_PLAYERS][stride]
+    unsigned char* jail_counters;    // [MAX_PLAYERS][stride]
+    unsigned long long* owned_masks; // [MAX_PLAYERS][stride]
+    unsigned char* houses;           // [BOARD_SIZE][stride]
+} CUDABatchState;
+
+// Bytes of CUDABatchState per lane
+#define CUDA_BATCH_STATE_BYTES_PER_LANE \
+    (MAX_PLAYERS * (2 * sizeof(int) + 2 * sizeof(unsigned char) + sizeof(unsigned long long)) + BOARD_SIZE)
+
+// Event flags packed into StepRecord.events
+#define STEP_EVT_PASSED_GO  (1u << 0)
+#define STEP_EVT_BOUGHT     (1u << 1)
+#define STEP_EVT_DECLINED   (1u << 2)
+#define STEP_EVT_PAID_RENT  (1u << 3)
+#define STEP_EVT_CHANCE     (1u << 4)  // card holds the Chance deck index
+#define STEP_EVT_CHEST      (1u << 5)  // card holds the Community Chest deck index
+#define STEP_EVT_BANKRUPT   (1u << 6)
+#define STEP_EVT_IN_JAIL    (1u << 7)  // player was in jail when the step started
+#define STEP_EVT_DONE       (1u << 8)
+#define STEP_EVT_HOUSE      (1u << 9)  // bought a house on an own property
+#define STEP_EVT_TAX        (1u << 10) // paid a fee square
+#define STEP_EVT_JAIL_FEE   (1u << 11) // paid the fee to leave jail (turn limit)
+#define STEP_EVT_JAIL_STAY  (1u << 12) // stayed in jail, no move this step
+#define STEP_EVT_SENT_JAIL  (1u << 13) // sent to jail by the Go To Jail square
+#define STEP_EVT_SOLD       (1u << 14) // sold houses/properties to cover a negative balance
+
+// Compact per-step record written by the kernel (32 bytes instead of a ~900 byte LogEntry).
+// Also carries everything the MC update needs: state, action and reward.
+typedef struct {
+    unsigned short events;        // STEP_EVT_* flags
+    unsigned short fee_paid;      // Rent/fees paid this step (saturated)
+    signed char card;             // Index into the drawn deck, -1 if no card
+    unsigned char dice;           // Dice total
+    unsigned char player;
+    unsigned char position_before;
+    unsigned char landed_on;
+    unsigned char position_after;
+    unsigned char action;         // 0 = Pass, 1 = Buy
+    unsigned char num_owned;      // Properties owned by the player after the step
+    signed char payee;            // Player the rent went to, -1 if none
+    unsigned char houses;         // Houses on the landed square (rent paid or house bought), else 0
+    int money_before;
+    int money_delta;              // money_after - money_before
+    float reward;
+    int state;                    // state_tuple_index() of the observation the action was chosen on
+} StepRecord;
 
 typedef struct {
-    EpisodeStep steps[MAX_EPISODE_STEPS];
+    StepRecord records[MAX_EPISODE_STEPS];
     int count;
-    LogEntry logs[MAX_EPISODE_STEPS];
-    int log_count;
     int episode_id;
 } CUDAEpisodeData;
 
+// Hot-path counters one simulate_episodes_kernel block reports for --metrics (summed over its lanes).
+// divergent_branches counts warp-level splits at the jail test and at the square action, once per split.
+typedef struct {
+    unsigned long long steps;
+    unsigned int card_draws;
+    unsigned int jail_turns;    // Steps that started in jail
+    unsigned int bankruptcies;
+    unsigned int divergent_branches;
+} KernelCounters;
+
+// Hyperparameters that may differ between the episodes of one launch. A plain run is a sweep of one
+// config; with --sweep, episode id e plays under config e % num_configs (see c_sweep_configs).
+typedef struct {
+    double epsilon;
+    int start_money;
+    int go_reward;
+} SweepConfig;
+
+// What a config's episodes added up to, from the tail entry of its Q_DELTA_SLOTS slice
+typedef struct {
+    double return_sum;    // Undiscounted episode returns (all movers' rewards)
+    double return_sum_sq; // Their squares, for the standard error of the mean return
+    long long episodes;
+} SweepResult;
+
 // --- Helper Functions ---
 
-// Forward declarations for card effects
-static CardEffectResult card_advance_to_go(MonopolyEnv* env, int player);
-static CardEffectResult card_go_to_jail(MonopolyEnv* env, int player);
-static CardEffectResult card_bank_dividend(MonopolyEnv* env, int player);
-static CardEffectResult card_pay_poor_tax(MonopolyEnv* env, int player);
-static CardEffectResult card_doctors_fee(MonopolyEnv* env, int player);
-static CardEffectResult card_tax_refund(MonopolyEnv* env, int player);
+// One Philox4x32-10 block: 10 rounds of the Random123 round function
+__host__ __device__ static inline void philox4x32_10(const unsigned int ctr[4], unsigned int k0, unsigned int k1, unsigned int out[4]) {
+    unsigned int c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    for (int round = 0; round < 10; ++round) {
+        unsigned long long p0 = (unsigned long long)PHILOX_M0 * c0;
+        unsigned long long p1 = (unsigned long long)PHILOX_M1 * c2;
+        c0 = (unsigned int)(p1 >> 32) ^ c1 ^ k0;
+        c2 = (unsigned int)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (unsigned int)p1;
+        c3 = (unsigned int)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+// Key a stream with the 64-bit run seed (counter starts at episode 0, step 0)
+__host__ __device__ static inline void philox_stream_init(PhiloxStream* s, unsigned long long seed) {
+    s->key[0] = (unsigned int)seed;
+    s->key[1] = (unsigned int)(seed >> 32);
+    s->episode = 0;
+    s->step = 0;
+    s->block = 0;
+    s->available = 0;
+}
 
-// Helper to check if a position requires paying a fee
-static int get_fee_for_position(int position) {
-    switch (position) {
-        case 4: return 200; // Income tax
-        case 38: return 100; // Luxury tax
-        default: return 0;
+// Position the stream at the first draw of (episode, step)
+__host__ __device__ static inline void philox_stream_seek(PhiloxStream* s, int episode, int step) {
+    s->episode = (unsigned int)episode;
+    s->step = (unsigned int)step;
+    s->block = 0;
+    s->available = 0;
+}
+
+// Next 32-bit draw of the stream
+__host__ __device__ static inline unsigned int philox_stream_next(PhiloxStream* s) {
+    if (s->available == 0) {
+        unsigned int ctr[4] = {s->episode, s->step, s->block++, 0u};
+        philox4x32_10(ctr, s->key[0], s->key[1], s->buffer);
+        s->available = 4;
     }
+    int i = 4 - s->available--;
+    return i == 0 ? s->buffer[0] : i == 1 ? s->buffer[1] : i == 2 ? s->buffer[2] : s->buffer[3];
+}
+
+// Uniform double in [0, 1) from one draw
+__host__ __device__ static inline double philox_stream_uniform(PhiloxStream* s) {
+    return philox_stream_next(s) * (1.0 / 4294967296.0);
+}
+
+// Next value of the environment's random stream in [0, 2^31)
+static int env_rand(MonopolyEnv* env) {
+    return (int)(philox_stream_next(&env->rng) >> 1);
+}
+
+
+// --- Rules Core ---
+// Compiled for both the host and the device so step_monopoly_env and simulate_episodes_kernel play
+// the same game. Lookups are bit/byte tables rather than switches to keep the kernel's step loop flat.
+
+// Helper to check if a position requires paying a fee
+__host__ __device__ static inline int get_fee_for_position(int position) {
+    return (position == 4) * 200 + (position == 38) * 100; // Income tax, luxury tax
 }
 
 // Helper to check if a position is Chance
-static bool is_chance_position(int position) {
-    return position == 7 || position == 22 || position == 36;
+__host__ __device__ static inline bool is_chance_position(int position) {
+    return (CHANCE_SQUARES >> position) & 1ull;
 }
 
 // Helper to check if a position is Community Chest
-static bool is_chest_position(int position) {
-    return position == 2 || position == 17 || position == 33;
+__host__ __device__ static inline bool is_chest_position(int position) {
+    return (CHEST_SQUARES >> position) & 1ull;
 }
 
-// Helper function to adjust money and create part of the log description
-static CardEffectResult adjust_money(MonopolyEnv* env, int player, int amount) {
-    env->money[player] += amount;
-    CardEffectResult result;
-    result.reward = (double)amount; // Reward is the direct change
-    snprintf(result.card_specific_desc, MAX_DESC_LEN, "Adjusted money by %d.", amount);
-    return result;
+// SquareClass of a square (Go To Jail first, as the square actions test it first)
+__host__ __device__ static inline int square_class_at(int position, int go_to_jail_position) {
+    return position == go_to_jail_position ? SQUARE_GO_TO_JAIL
+         : is_chance_position(position) ? SQUARE_CHANCE
+         : is_chest_position(position) ? SQUARE_CHEST
+         : get_fee_for_position(position) > 0 ? SQUARE_TAX : SQUARE_PLAIN;
 }
 
-// Helper: Advance player to GO
-static CardEffectResult advance_to_go(MonopolyEnv* env, int player) {
-    CardEffectResult result = {0.0, ""};
-    bool passed_go = env->positions[player] != 0; // Collect if not already at GO
-    env->positions[player] = 0;
-    strncat(result.card_specific_desc, "Advanced to GO.", MAX_DESC_LEN - strlen(result.card_specific_desc) - 1);
+// Deck drawn from on a square of the given SquareClass: CARD_DECK_CHANCE, CARD_DECK_CHEST, or -1 if none
+__host__ __device__ static inline int card_deck_of(int square) {
+    return square == SQUARE_CHANCE ? CARD_DECK_CHANCE : square == SQUARE_CHEST ? CARD_DECK_CHEST : -1;
+}
 
-    if (passed_go) {
-        env->money[player] += env->go_reward;
-        result.reward += env->go_reward;
-        char go_desc[64];
-        snprintf(go_desc, sizeof(go_desc), " Collected $%d.", env->go_reward);
-        strncat(result.card_specific_desc, go_desc, MAX_DESC_LEN - strlen(result.card_specific_desc) - 1);
-    }
-    return result;
+// One of the DICE_OUTCOMES two-dice rolls from a single 32-bit draw (multiply-shift instead of two modulos)
+__host__ __device__ static inline int dice_outcome(unsigned int word) {
+    return (int)(((unsigned long long)word * DICE_OUTCOMES) >> 32);
 }
 
-// Helper: Send player to Jail
-static CardEffectResult go_to_jail(MonopolyEnv* env, int player) {
-    CardEffectResult result = {0.0, ""}; // No immediate reward/penalty unless desired
-    env->positions[player] = env->jail_position;
-    env->in_jail[player] = true;
-    env->jail_counters[player] = 0; // Reset jail turn counter
-    snprintf(result.card_specific_desc, MAX_DESC_LEN, "Moved to Jail (Position %d).", env->jail_position);
-    return result;
+// Where a roll takes a player standing on `position`; a move that starts on the jail square never collects GO
+__host__ __device__ static inline DiceTransition dice_transition(int position, int roll, int board_size,
+                                                                 int jail_position, int go_to_jail_position) {
+    int die1 = roll / 6 + 1, die2 = roll % 6 + 1;
+    int landing = (position + die1 + die2) % board_size;
+    DiceTransition t;
+    t.landing = (unsigned char)landing;
+    t.square = (unsigned char)square_class_at(landing, go_to_jail_position);
+    t.dice_total = (unsigned char)(die1 + die2);
+    t.flags = (unsigned char)((landing < position && position != jail_position ? DICE_PASSES_GO : 0) |
+                              (die1 == die2 ? DICE_DOUBLES : 0));
+    return t;
+}
+
+// Apply a card to a player on `position`: adds its money to *cash, sets *jailed and returns the square the
+// player ends on. Selects instead of a switch, so lanes drawing different cards do not split.
+// Assumes |amount| < board_size for CARD_OP_MOVE (load_card_decks checks it).
+__host__ __device__ static inline int apply_card_effect(CardEffect card, int position, int* cash, bool* jailed,
+                                                        int board_size, int jail_position, int go_reward) {
+    int moved = position + card.amount;
+    int wrapped = moved < 0 ? moved + board_size : moved >= board_size ? moved - board_size : moved;
+    bool passes_go = (card.op == CARD_OP_ADVANCE && card.target < position) ||
+                     (card.op == CARD_OP_MOVE && moved >= board_size);
+    *cash += (card.op == CARD_OP_MONEY ? card.amount : 0) + (passes_go ? go_reward : 0);
+    *jailed = card.op == CARD_OP_JAIL;
+    return card.op == CARD_OP_ADVANCE ? card.target : card.op == CARD_OP_MOVE ? wrapped
+         : card.op == CARD_OP_JAIL ? jail_position : position;
 }
 
-// --- Card Effect Implementations ---
-static CardEffectResult card_advance_to_go(MonopolyEnv* env, int player) {
-    return advance_to_go(env, player);
+// Rent due on a property with the given number of houses (5 = hotel)
+__host__ __device__ static inline int rent_for_houses(int base_rent, int houses) {
+    int h = houses < MAX_HOUSES ? houses : MAX_HOUSES;
+    return base_rent * (int)((RENT_MULTIPLIERS >> (8 * h)) & 0xFFull);
 }
 
-static CardEffectResult card_go_to_jail(MonopolyEnv* env, int player) {
-    return go_to_jail(env, player);
+// Liquidation values: houses sell for half their cost, properties for half their price
+__host__ __device__ static inline int house_sale_value(int house_cost, int houses) {
+    return houses * (house_cost / 2);
 }
 
-static CardEffectResult card_bank_dividend(MonopolyEnv* env, int player) {
-    return adjust_money(env, player, 50);
+__host__ __device__ static inline int property_sale_value(int price) {
+    return price / 2;
 }
 
-static CardEffectResult card_pay_poor_tax(MonopolyEnv* env, int player) {
-    return adjust_money(env, player, -15);
+// Index of the lowest set bit of a non-zero square mask
+__host__ __device__ static inline int lowest_square(unsigned long long mask) {
+#ifdef __CUDA_ARCH__
+    return __ffsll((long long)mask) - 1;
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+// Bankruptcy resolution over a bit-packed ownership mask, in step_monopoly_env's order: sell houses in
+// board order until solvent, then houseless properties in board order until solvent.
+// houses[square * houses_stride] is the house count of a square. Returns the money after selling;
+// if it is still negative the player is bankrupt and the caller forfeits what is left.
+__host__ __device__ static inline int liquidate_assets(int money, unsigned long long* owned_mask,
+                                                       unsigned char* houses, int houses_stride,
+                                                       const int* prices, const int* house_costs) {
+    for (unsigned long long m = *owned_mask; m != 0ull && money < 0; m &= m - 1) {
+        int square = lowest_square(m);
+        int h = houses[square * houses_stride];
+        if (h > 0 && house_costs[square] > 0) {
+            money += house_sale_value(house_costs[square], h);
+            houses[square * houses_stride] = 0;
+        }
+    }
+    for (unsigned long long m = *owned_mask; m != 0ull && money < 0; m &= m - 1) {
+        int square = lowest_square(m);
+        if (houses[square * houses_stride] == 0 && prices[square] > 0) {
+            money += property_sale_value(prices[square]);
+            *owned_mask &= ~(1ull << square);
+        }
+    }
+    return money;
 }
 
-static CardEffectResult card_doctors_fee(MonopolyEnv* env, int player) {
-    return adjust_money(env, player, -50);
+// Helper: Send player to Jail
+static CardEffectResult go_to_jail(MonopolyEnv* env, int player) {
+    CardEffectResult result = {0.0, ""}; // No immediate reward/penalty unless desired
+    env->positions[player] = env->jail_position;
+    env->in_jail[player] = true;
+    env->jail_counters[player] = 0; // Reset jail turn counter
+    snprintf(result.card_specific_desc, MAX_DESC_LEN, "Moved to Jail (Position %d).", env->jail_position);
+    return result;
 }
 
-static CardEffectResult card_tax_refund(MonopolyEnv* env, int player) {
-    return adjust_money(env, player, 20);
+// Helper: Apply a drawn card through apply_card_effect and describe what it did
+static CardEffectResult apply_card(MonopolyEnv* env, int player, CardEffect card) {
+    CardEffectResult result = {0.0, ""};
+    int cash = env->money[player];
+    bool jailed = false;
+    int dest = apply_card_effect(card, env->positions[player], &cash, &jailed,
+                                 env->board_size, env->jail_position, env->go_reward);
+    if (jailed) return go_to_jail(env, player);
+
+    int gained = cash - env->money[player];
+    result.reward = (double)gained; // Reward is the direct change
+    env->money[player] = cash;
+    env->positions[player] = dest;
+    if (card.op == CARD_OP_MONEY) {
+        snprintf(result.card_specific_desc, MAX_DESC_LEN, "Adjusted money by %d.", gained);
+        return result;
+    }
+    if (card.op == CARD_OP_ADVANCE && dest == 0) {
+        snprintf(result.card_specific_desc, MAX_DESC_LEN, "Advanced to GO.");
+    } else if (card.op == CARD_OP_ADVANCE) {
+        snprintf(result.card_specific_desc, MAX_DESC_LEN, "Advanced to %s (Position %d).", env->properties[dest].name, dest);
+    } else {
+        snprintf(result.card_specific_desc, MAX_DESC_LEN, "Moved %d squares to %s (Position %d).",
+                 card.amount, env->properties[dest].name, dest);
+    }
+    if (gained > 0) {
+        char go_desc[64];
+        snprintf(go_desc, sizeof(go_desc), " Collected $%d.", gained);
+        strncat(result.card_specific_desc, go_desc, MAX_DESC_LEN - strlen(result.card_specific_desc) - 1);
+    }
+    return result;
 }
 
 // --- Core Environment Functions ---
@@ -366,23 +676,115 @@ static void initialize_properties(Property properties[MAX_PROPERTIES]) {
     }
 }
 
+// Default decks (--deck=FILE replaces them)
+static const Card default_chance_cards[] = {
+    {"Advance to Go", "Move to GO and collect $200.", {CARD_OP_ADVANCE, 0, 0}},
+    {"Go to Jail", "Go directly to Jail.", {CARD_OP_JAIL, 0, 0}},
+    {"Bank pays you dividend", "Collect $50 from the bank.", {CARD_OP_MONEY, 0, 50}},
+    {"Pay poor tax", "Pay $15 poor tax.", {CARD_OP_MONEY, 0, -15}}
+};
+
+static const Card default_chest_cards[] = {
+    {"Doctor's fee", "Pay $50 doctor's fee.", {CARD_OP_MONEY, 0, -50}},
+    {"Income tax refund", "Collect $20 income tax refund.", {CARD_OP_MONEY, 0, 20}},
+    {"Go to Jail", "Go directly to Jail.", {CARD_OP_JAIL, 0, 0}},
+    {"Advance to Go", "Move to GO and collect $200.", {CARD_OP_ADVANCE, 0, 0}}
+};
+
+// Precompute every roll from every square under env's rules (called by create_monopoly_env)
+static void build_dice_transitions(MonopolyEnv* env) {
+    for (int pos = 0; pos < env->board_size; ++pos) {
+        for (int roll = 0; roll < DICE_OUTCOMES; ++roll) {
+            env->transitions[pos][roll] = dice_transition(pos, roll, env->board_size, env->jail_position, env->go_to_jail_position);
+        }
+    }
+}
+
+// Roll both dice with one draw of the environment's stream
+static int env_roll_dice(MonopolyEnv* env) {
+    return dice_outcome(philox_stream_next(&env->rng));
+}
+
 // Initialize Card Decks
 static void initialize_decks(MonopolyEnv* env) {
-    // Chance Deck
-    env->chance_deck_size = 0;
-    env->chance_deck[env->chance_deck_size++] = (Card){"Advance to Go", card_advance_to_go};
-    env->chance_deck[env->chance_deck_size++] = (Card){"Go to Jail", card_go_to_jail};
-    env->chance_deck[env->chance_deck_size++] = (Card){"Bank pays you dividend", card_bank_dividend};
-    env->chance_deck[env->chance_deck_size++] = (Card){"Pay poor tax", card_pay_poor_tax};
-    // Add more chance cards here if needed...
-
-    // Community Chest Deck
-    env->chest_deck_size = 0;
-    env->chest_deck[env->chest_deck_size++] = (Card){"Doctor's fee", card_doctors_fee};
-    env->chest_deck[env->chest_deck_size++] = (Card){"Income tax refund", card_tax_refund};
-    env->chest_deck[env->chest_deck_size++] = (Card){"Go to Jail", card_go_to_jail};
-    env->chest_deck[env->chest_deck_size++] = (Card){"Advance to Go", card_advance_to_go};
-    // Add more chest cards here if needed...
+    env->deck_sizes[CARD_DECK_CHANCE] = (int)(sizeof(default_chance_cards) / sizeof(Card));
+    memcpy(env->decks[CARD_DECK_CHANCE], default_chance_cards, sizeof(default_chance_cards));
+    env->deck_sizes[CARD_DECK_CHEST] = (int)(sizeof(default_chest_cards) / sizeof(Card));
+    memcpy(env->decks[CARD_DECK_CHEST], default_chest_cards, sizeof(default_chest_cards));
+}
+
+// Replace the decks with a deck file (--deck=FILE). One card per line:
+//     <chance|chest> money <dollars> <name> | <card text>
+//     <chance|chest> advance <square> <name> | <card text>
+//     <chance|chest> move <squares> <name> | <card text>
+//     <chance|chest> jail <name> | <card text>
+// Blank lines and lines starting with '#' are skipped. A deck that appears in the file replaces the
+// default one, a deck that does not keeps its defaults. Returns false (decks unchanged) on any error.
+bool load_card_decks(MonopolyEnv* env, const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Error: Could not open deck file '%s'.\n", path);
+        return false;
+    }
+    Card decks[NUM_CARD_DECKS][MAX_DECK_SIZE];
+    int sizes[NUM_CARD_DECKS] = {0, 0};
+    char line[DECK_LINE_MAX];
+    int line_no = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp)) {
+        line_no++;
+        line[strcspn(line, "\r\n")] = '\0';
+        char deck_word[16] = "", op_word[16] = "";
+        int consumed = 0;
+        if (line[strspn(line, " \t")] == '\0' || line[strspn(line, " \t")] == '#') continue;
+        if (sscanf(line, "%15s %15s %n", deck_word, op_word, &consumed) != 2) consumed = 0;
+
+        int deck = strcmp(deck_word, "chance") == 0 ? CARD_DECK_CHANCE : strcmp(deck_word, "chest") == 0 ? CARD_DECK_CHEST : -1;
+        CardEffect effect = {CARD_OP_JAIL, 0, 0};
+        int arg = 0, arg_len = 0;
+        if (consumed > 0 && strcmp(op_word, "jail") != 0) {
+            effect.op = strcmp(op_word, "money") == 0 ? CARD_OP_MONEY : strcmp(op_word, "advance") == 0 ? CARD_OP_ADVANCE
+                      : strcmp(op_word, "move") == 0 ? CARD_OP_MOVE : 0xFF;
+            if (sscanf(line + consumed, "%d %n", &arg, &arg_len) != 1) effect.op = 0xFF;
+            consumed += arg_len;
+        }
+        char* text = line + consumed;
+        char* bar = strchr(text, '|');
+        bool arg_ok = effect.op == CARD_OP_MONEY ? (arg >= -32768 && arg <= 32767)
+                    : effect.op == CARD_OP_ADVANCE ? (arg >= 0 && arg < BOARD_SIZE)
+                    : effect.op == CARD_OP_MOVE ? (arg > -BOARD_SIZE && arg < BOARD_SIZE) : effect.op == CARD_OP_JAIL;
+        if (consumed == 0 || deck < 0 || !arg_ok || !bar || bar == text) {
+            fprintf(stderr, "Error: Invalid card on line %d of deck file '%s'.\n", line_no, path);
+            ok = false;
+        } else if (sizes[deck] == MAX_DECK_SIZE) {
+            fprintf(stderr, "Error: Deck file '%s' has more than %d %s cards.\n", path, MAX_DECK_SIZE, deck_word);
+            ok = false;
+        } else {
+            if (effect.op == CARD_OP_ADVANCE) effect.target = (unsigned char)arg;
+            else if (effect.op != CARD_OP_JAIL) effect.amount = (short)arg;
+            // Name and text are trimmed of the spaces around the '|'
+            char* name_end = bar;
+            while (name_end > text && (name_end[-1] == ' ' || name_end[-1] == '\t')) name_end--;
+            char* desc = bar + 1 + strspn(bar + 1, " \t");
+            Card* card = &decks[deck][sizes[deck]++];
+            memset(card, 0, sizeof(*card));
+            snprintf(card->name, sizeof(card->name), "%.*s", (int)(name_end - text), text);
+            snprintf(card->desc, sizeof(card->desc), "%s", desc);
+            card->effect = effect;
+        }
+    }
+    fclose(fp);
+    if (!ok) return false;
+    if (sizes[CARD_DECK_CHANCE] + sizes[CARD_DECK_CHEST] == 0) {
+        fprintf(stderr, "Error: Deck file '%s' has no cards.\n", path);
+        return false;
+    }
+    for (int d = 0; d < NUM_CARD_DECKS; d++) {
+        if (sizes[d] == 0) continue;
+        memcpy(env->decks[d], decks[d], sizes[d] * sizeof(Card));
+        env->deck_sizes[d] = sizes[d];
+    }
+    return true;
 }
 
 // Get Observation (internal helper)
@@ -425,15 +827,17 @@ MonopolyEnv* create_monopoly_env(int num_players, int start_money, int go_reward
     env->go_reward = go_reward;
     env->start_money = start_money;
     env->board_size = BOARD_SIZE; // Fixed size
-    env->jail_position = 10;
-    env->go_to_jail_position = 30;
-    env->jail_turns = 3;
+    env->jail_position = STANDARD_JAIL_POSITION;
+    env->go_to_jail_position = STANDARD_GO_TO_JAIL_POSITION;
+    env->jail_turns = STANDARD_JAIL_TURNS;
     env->num_players = num_players;
     env->obs_money_high = start_money * 10; // Arbitrary high limit for observation
+    philox_stream_init(&env->rng, 0); // Fixed default seed, see seed_monopoly_env
 
     // --- Initialize State ---
     initialize_properties(env->properties);
     initialize_decks(env);
+    build_dice_transitions(env);
     env->current_player = 0;
     env->steps_taken = 0;
     env->done = false;
@@ -458,6 +862,11 @@ MonopolyEnv* create_monopoly_env(int num_players, int start_money, int go_reward
     return env;
 }
 
+// Seed the environment's random stream (draws depend only on seed, episode and step)
+void seed_monopoly_env(MonopolyEnv* env, unsigned long long seed) {
+    philox_stream_init(&env->rng, seed);
+}
+
 // Destroy the environment and free memory
 void destroy_monopoly_env(MonopolyEnv* env) {
     if (env) {
@@ -576,21 +985,20 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
     // --- Jail Logic ---
     if (env->in_jail[p]) {
         env->jail_counters[p]++;
-        int dice1 = (rand() % 6) + 1;
-        int dice2 = (rand() % 6) + 1;
-        bool rolled_doubles = (dice1 == dice2);
+        DiceTransition jail_roll = env->transitions[prev_position][env_roll_dice(env)];
+        bool rolled_doubles = (jail_roll.flags & DICE_DOUBLES) != 0;
         bool turn_limit_reached = (env->jail_counters[p] >= env->jail_turns);
 
         if (rolled_doubles) {
             env->in_jail[p] = false;
             env->jail_counters[p] = 0;
             snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                     "Player %d rolled doubles (%d) to get out of jail. ", p, dice1);
+                     "Player %d rolled doubles (%d) to get out of jail. ", p, jail_roll.dice_total / 2);
             // Player proceeds to normal dice roll below
         } else if (turn_limit_reached) {
             env->in_jail[p] = false;
             env->jail_counters[p] = 0;
-            int jail_fee = 50;
+            int jail_fee = JAIL_FEE;
             env->money[p] -= jail_fee;
             fee_paid_this_turn += jail_fee;
             card_reward_contribution -= jail_fee; // Penalty for paying
@@ -611,7 +1019,7 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
                  // Attempt to resolve bankruptcy (Simplified check here, full check later)
                   if (env->money[p] < 0) { // Still bankrupt after trying to pay
                         env->done = true; // Game over
-                        card_reward_contribution -= 1000; // Bankruptcy penalty
+                        card_reward_contribution -= BANKRUPTCY_PENALTY;
                         snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
                                  "Player %d went bankrupt paying jail fee! ", p);
                         // Forfeit properties
@@ -641,15 +1049,13 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
     }
 
     // --- Normal Turn: Dice Roll and Movement ---
-    int dice1 = (rand() % 6) + 1;
-    int dice2 = (rand() % 6) + 1;
-    dice_total = dice1 + dice2;
+    // One draw selects the roll; the table gives the landing square, its class and whether GO is passed
+    DiceTransition move = env->transitions[prev_position][env_roll_dice(env)];
+    dice_total = move.dice_total;
+    landed_position_this_turn = move.landing;
 
-    landed_position_this_turn = (prev_position + dice_total) % env->board_size;
-
-    // Check for passing GO
-    bool passed_go = landed_position_this_turn < prev_position && !(env->in_jail[p]); // Don't collect if just got out of jail and landed before GO
-     if (passed_go && prev_position != env->jail_position) { // Ensure not passing GO due to leaving jail on pos 10
+    // Check for passing GO (the table never credits a move that starts on the jail square)
+    if (move.flags & DICE_PASSES_GO) {
         env->money[p] += env->go_reward;
         current_step_reward += env->go_reward;
         snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
@@ -663,31 +1069,23 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
     // --- Card Handling ---
     CardEffectResult card_result = {0.0, ""};
     bool card_drawn = false;
+    int card_op = -1;
+    int deck = card_deck_of(move.square);
 
-    if (is_chance_position(pos)) {
-        int card_index = rand() % env->chance_deck_size;
-        Card drawn_card = env->chance_deck[card_index];
-        strncpy(card_name_drawn, drawn_card.name, MAX_NAME_LEN - 1);
-        card_name_drawn[MAX_NAME_LEN - 1] = '\0';
-        snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                 "Landed on Chance (%d), drew '%s'. ", pos, card_name_drawn);
-        card_result = drawn_card.effect(env, p); // Effect function modifies state
-        strncpy(card_spec_desc_drawn, card_result.card_specific_desc, MAX_DESC_LEN - 1);
-        card_spec_desc_drawn[MAX_DESC_LEN - 1] = '\0';
-        pos = env->positions[p]; // IMPORTANT: Update pos in case card moved the player
-        card_drawn = true;
-    } else if (is_chest_position(pos)) {
-        int card_index = rand() % env->chest_deck_size;
-        Card drawn_card = env->chest_deck[card_index];
-        strncpy(card_name_drawn, drawn_card.name, MAX_NAME_LEN - 1);
+    if (deck >= 0) {
+        int card_index = env_rand(env) % env->deck_sizes[deck];
+        const Card* drawn_card = &env->decks[deck][card_index];
+        strncpy(card_name_drawn, drawn_card->name, MAX_NAME_LEN - 1);
         card_name_drawn[MAX_NAME_LEN - 1] = '\0';
         snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
-                 "Landed on Community Chest (%d), drew '%s'. ", pos, card_name_drawn);
-        card_result = drawn_card.effect(env, p); // Effect function modifies state
+                 "Landed on %s (%d), drew '%s'. ", deck == CARD_DECK_CHANCE ? "Chance" : "Community Chest",
+                 pos, card_name_drawn);
+        card_result = apply_card(env, p, drawn_card->effect); // Modifies state
         strncpy(card_spec_desc_drawn, card_result.card_specific_desc, MAX_DESC_LEN - 1);
         card_spec_desc_drawn[MAX_DESC_LEN - 1] = '\0';
         pos = env->positions[p]; // IMPORTANT: Update pos in case card moved the player
         card_drawn = true;
+        card_op = drawn_card->effect.op;
     }
 
     // Append the specific card description to the main log description
@@ -708,7 +1106,7 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
     // 1. Go To Jail Square
     if (pos == env->go_to_jail_position) {
         // Avoid double penalty if card already sent player here
-        if (!card_drawn || strcmp(card_name_drawn, "Go to Jail") != 0) {
+        if (!card_drawn || card_op != CARD_OP_JAIL) {
              snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
                      "Landed on Go To Jail (%d). ", pos);
              CardEffectResult jail_effect = go_to_jail(env, p); // Call effect to set state
@@ -749,30 +1147,8 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
         }
        // b) Owned by opponent
       else if (prop_owner != p) {
-          int rent_due = prop_rent; // Base rent
-
-          // More realistic rent multipliers based on house count
-          if (prop_houses > 0) {
-              switch (prop_houses) {
-                  case 1:
-                      rent_due = prop_rent * 5;    // Typically 5x base rent
-                      break;
-                  case 2:
-                      rent_due = prop_rent * 15;   // Typically 15x base rent
-                      break;
-                  case 3:
-                      rent_due = prop_rent * 45;   // Typically 45x base rent
-                      break;
-                  case 4:
-                      rent_due = prop_rent * 80;   // Typically 80x base rent
-                      break;
-                  case 5: // Hotel
-                      rent_due = prop_rent * 125;  // Typically 125x base rent
-                      break;
-                  default:
-                      rent_due *= (prop_houses + 1); // Fallback
-              }
-          }
+          // Base rent times the house-count multiplier (5x, 15x, 45x, 80x, 125x for a hotel)
+          int rent_due = rent_for_houses(prop_rent, prop_houses);
 
           int payment = (env->money[p] < rent_due) ? env->money[p] : rent_due; // Pay what you can
 
@@ -797,7 +1173,7 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
             // Check if player can buy houses on this property
             bool can_buy_houses = (env->properties[pos].house_cost > 0 && env->money[p] >= env->properties[pos].house_cost);
             int current_houses = env->properties[pos].houses;
-            int max_houses = 5; // 4 houses + 1 hotel
+            int max_houses = MAX_HOUSES;
 
             // Only allow buying houses if we have less than the maximum
             if (can_buy_houses && current_houses < max_houses) {
@@ -867,8 +1243,7 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
                 int house_cost = env->properties[i].house_cost; // Get house cost
                 if (house_cost > 0) { // Can only sell houses if they have a cost basis
                     int num_houses_to_sell = env->properties[i].houses;
-                    int sell_value_per_house = house_cost / 2; // Sell for half cost
-                    int money_from_houses = num_houses_to_sell * sell_value_per_house;
+                    int money_from_houses = house_sale_value(house_cost, num_houses_to_sell); // Half cost
 
                     env->money[p] += money_from_houses;
                     env->properties[i].houses = 0; // Remove all houses/hotel
@@ -900,7 +1275,7 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
                  if (env->properties[i].owner == p) {
                      // Can only sell if it has NO houses (should be true after Phase 1)
                      if (env->properties[i].houses == 0 && env->properties[i].price > 0) {
-                        int sell_price = env->properties[i].price / 2; // Sell for half purchase price
+                        int sell_price = property_sale_value(env->properties[i].price); // Half purchase price
                         env->money[p] += sell_price;
                         env->properties[i].owner = -1; // Forfeit property to bank
                         properties_sold_total_value += sell_price;
@@ -929,7 +1304,7 @@ StepResult step_monopoly_env(MonopolyEnv* env, int action, int* obs) {
         if (!bankruptcy_resolved && env->money[p] < 0) {
              // Still bankrupt after selling everything possible
              env->done = true; // Set game end flag
-             card_reward_contribution -= 1000; // Apply bankruptcy penalty AFTER trying to resolve
+             card_reward_contribution -= BANKRUPTCY_PENALTY; // Apply bankruptcy penalty AFTER trying to resolve
              snprintf(log_buffer + strlen(log_buffer), sizeof(log_buffer) - strlen(log_buffer),
                       "Player %d could not raise enough funds. Final balance: $%d. Game Over! ", p, env->money[p]);
              // Ensure all properties are forfeited
@@ -1006,18 +1381,42 @@ void render_monopoly_env(MonopolyEnv* env) {
     }
 }
 
-// --- Hash Table & State Tuple Helper Functions ---
+// --- State Tuple Helper Functions ---
 
-// Hash function for StateTuple
-static unsigned int hash_state_tuple(StateTuple s, int table_size) {
-    // Simple combination hash - adjust multipliers for better distribution if needed
-    unsigned int hash = 17;
-    hash = (hash * 31 + s.position) % table_size;
-    hash = (hash * 31 + s.money_bin) % table_size;
-    // Add 10 to owner to handle -1 gracefully in hashing (avoids negative intermediate)
-    hash = (hash * 31 + (s.current_prop_owner + 10)) % table_size;
-    hash = (hash * 31 + s.in_jail) % table_size;
-    return hash;
+// Discretize money into a Q-table bin (100 per bin, clamped to the dense table range)
+__host__ __device__ static inline int money_to_bin(int money) {
+    int bin = money / 100;
+    if (bin < 0) bin = 0;
+    if (bin >= Q_MONEY_BINS) bin = Q_MONEY_BINS - 1;
+    return bin;
+}
+
+// Dense index of a StateTuple into [0, Q_NUM_STATES), or -1 if it falls outside the table.
+// Overflow policy: money_bin saturates into [0, Q_MONEY_BINS - 1], so balances of $16,000 and more
+// share the top bin (as they do through money_to_bin on the device) instead of missing the table.
+__host__ __device__ static inline int state_tuple_index(StateTuple s) {
+    if (s.position < 0 || s.position >= BOARD_SIZE) return -1;
+    if (s.current_prop_owner < -1 || s.current_prop_owner >= MAX_PLAYERS) return -1;
+    if (s.in_jail < 0 || s.in_jail > 1) return -1;
+    int bin = s.money_bin < 0 ? 0 : (s.money_bin >= Q_MONEY_BINS ? Q_MONEY_BINS - 1 : s.money_bin);
+    return ((s.position * Q_MONEY_BINS + bin) * Q_OWNER_SLOTS + (s.current_prop_owner + 1)) * 2 + s.in_jail;
+}
+
+// Inverse of state_tuple_index
+__host__ __device__ static inline StateTuple state_tuple_from_index(int idx) {
+    StateTuple s;
+    s.in_jail = idx % 2;
+    idx /= 2;
+    s.current_prop_owner = idx % Q_OWNER_SLOTS - 1;
+    idx /= Q_OWNER_SLOTS;
+    s.money_bin = idx % Q_MONEY_BINS;
+    s.position = idx / Q_MONEY_BINS;
+    return s;
+}
+
+// Recover the decision-time StateTuple stored in a packed step record
+__host__ __device__ static inline StateTuple step_record_state(const StepRecord* rec) {
+    return state_tuple_from_index(rec->state);
 }
 
 // Comparison function for StateTuple
@@ -1028,152 +1427,144 @@ static bool compare_state_tuples(StateTuple s1, StateTuple s2) {
            s1.in_jail == s2.in_jail;
 }
 
-// Create a new Q-value hash table
-static QHashTable* create_q_hash_table(int size) {
-    QHashTable* ht = (QHashTable*)malloc(sizeof(QHashTable));
-    if (!ht) return NULL;
-    ht->size = size;
-    ht->count = 0;
-    ht->table = (QTableEntry**)calloc(size, sizeof(QTableEntry*)); // Initialize all to NULL
-    if (!ht->table) {
-        free(ht);
+// Create an empty dense Q-table (every state present, none used yet)
+static QTable* create_q_table(void) {
+    QTable* qt = (QTable*)malloc(sizeof(QTable));
+    if (!qt) return NULL;
+    qt->count = 0;
+    qt->mapped_bytes = 0;
+    qt->entries = (QTableEntry*)calloc(Q_NUM_STATES, sizeof(QTableEntry)); // sum=0, count=0, q=0
+    if (!qt->entries) {
+        free(qt);
         return NULL;
     }
-    return ht;
+    return qt;
 }
 
-// Find or create an entry in the Q-value hash table
-static QTableEntry* find_or_create_q_entry(QHashTable* ht, StateTuple key) {
-    unsigned int index = hash_state_tuple(key, ht->size);
-    QTableEntry* entry = ht->table[index];
-
-    // Search existing chain
-    while (entry != NULL) {
-        if (compare_state_tuples(entry->key, key)) {
-            return entry; // Found it
-        }
-        entry = entry->next;
+// Find the entry for a state and mark it used (NULL only for a StateTuple outside the table)
+static QTableEntry* find_or_create_q_entry(QTable* qt, StateTuple key) {
+    int idx = state_tuple_index(key);
+    if (idx < 0) return NULL;
+    QTableEntry* entry = &qt->entries[idx];
+    if (!entry->used) {
+        entry->used = true;
+        qt->count++;
     }
+    return entry;
+}
 
-    // Not found, create a new entry
-    QTableEntry* new_entry = (QTableEntry*)malloc(sizeof(QTableEntry));
-    if (!new_entry) return NULL; // Allocation failed
-
-    new_entry->key = key;
-    // Initialize Q-value data (sum=0, count=0, q=0)
-    memset(new_entry->values, 0, sizeof(new_entry->values));
-    new_entry->next = ht->table[index]; // Link into chain (at the front)
-    ht->table[index] = new_entry;
-    ht->count++;
-
-    return new_entry;
+// Find a used entry without marking it (safe for concurrent readers while no thread writes the table)
+static const QTableEntry* find_q_entry(const QTable* qt, StateTuple key) {
+    int idx = state_tuple_index(key);
+    if (idx < 0 || !qt->entries[idx].used) return NULL;
+    return &qt->entries[idx];
 }
 
-// Destroy the Q-value hash table
-static void destroy_q_hash_table(QHashTable* ht) {
-    if (!ht) return;
-    for (int i = 0; i < ht->size; ++i) {
-        QTableEntry* entry = ht->table[i];
-        while (entry != NULL) {
-            QTableEntry* temp = entry;
-            entry = entry->next;
-            free(temp);
-        }
+// Release the entries, whether allocated or mapped from a checkpoint
+static void release_q_table_entries(QTable* qt) {
+    if (qt->mapped_bytes) {
+        munmap(qt->entries, qt->mapped_bytes);
+    } else {
+        free(qt->entries);
     }
-    free(ht->table);
-    free(ht);
+    qt->entries = NULL;
+    qt->mapped_bytes = 0;
 }
 
-// --- Visited Set Hash Table Functions ---
+// Destroy the dense Q-table
+static void destroy_q_table(QTable* qt) {
+    if (!qt) return;
+    release_q_table_entries(qt);
+    free(qt);
+}
 
-// Hash function for VisitedKey
-static unsigned int hash_visited_key(VisitedKey k, int table_size) {
-     unsigned int state_hash = hash_state_tuple(k.state, table_size);
-     // Combine state hash with action
-     unsigned int hash = (state_hash * 31 + k.action) % table_size;
-     return hash;
+// Standard error of a Q-value: sample standard deviation of its returns over sqrt(count), 0 below two returns
+static double q_value_std_error(const QValueData* v) {
+    if (v->count < 2) return 0.0;
+    double mean = v->sum_returns / v->count;
+    double variance = (v->sum_sq_returns - mean * v->sum_returns) / (v->count - 1);
+    return variance > 0.0 ? sqrt(variance / v->count) : 0.0;
 }
 
-// Comparison function for VisitedKey
-static bool compare_visited_keys(VisitedKey k1, VisitedKey k2) {
-    return k1.action == k2.action && compare_state_tuples(k1.state, k2.state);
+// Buy/pass comparisons the table has settled: visited states where both actions have two or more returns,
+// and of those the ones whose Q-values differ by more than CONVERGENCE_Z combined standard errors
+static void q_table_convergence(const QTable* qt, int* compared, int* separated) {
+    *compared = 0;
+    *separated = 0;
+    for (int idx = 0; idx < Q_NUM_STATES; ++idx) {
+        const QTableEntry* entry = &qt->entries[idx];
+        if (!entry->used || entry->values[0].count < 2 || entry->values[1].count < 2) continue;
+        double se0 = q_value_std_error(&entry->values[0]), se1 = q_value_std_error(&entry->values[1]);
+        (*compared)++;
+        if (fabs(entry->values[1].q_value - entry->values[0].q_value) > CONVERGENCE_Z * sqrt(se0 * se0 + se1 * se1)) (*separated)++;
+    }
 }
 
-// Create a new visited set hash table
-static VisitedSet* create_visited_set(int size) {
-    VisitedSet* vs = (VisitedSet*)malloc(sizeof(VisitedSet));
-    if (!vs) return NULL;
-    vs->size = size;
-    vs->count = 0;
-    vs->table = (VisitedSetEntry**)calloc(size, sizeof(VisitedSetEntry*));
-    if (!vs->table) {
-        free(vs);
+// --- Episode Arena Functions ---
+
+// Allocate a worker's episode scratch once, sized for the longest episode
+static EpisodeArena* create_episode_arena(int num_players) {
+    EpisodeArena* arena = (EpisodeArena*)malloc(sizeof(EpisodeArena));
+    if (!arena) return NULL;
+    arena->steps = (EpisodeStep*)malloc(MAX_EPISODE_STEPS * sizeof(EpisodeStep));
+    arena->obs = (int*)malloc(get_observation_size(num_players) * sizeof(int));
+    arena->visit_stamps = (unsigned short*)calloc((size_t)Q_NUM_STATES * 2, sizeof(unsigned short));
+    arena->generation = 0;
+    if (!arena->steps || !arena->obs || !arena->visit_stamps) {
+        free(arena->steps);
+        free(arena->obs);
+        free(arena->visit_stamps);
+        free(arena);
         return NULL;
     }
-    return vs;
+    return arena;
 }
 
-// Check if a key exists and add it if it doesn't (returns true if it was already present)
-static bool check_and_add_visited(VisitedSet* vs, VisitedKey key) {
-    unsigned int index = hash_visited_key(key, vs->size);
-    VisitedSetEntry* entry = vs->table[index];
+// Free an episode arena
+static void destroy_episode_arena(EpisodeArena* arena) {
+    if (!arena) return;
+    free(arena->steps);
+    free(arena->obs);
+    free(arena->visit_stamps);
+    free(arena);
+}
 
-    // Search chain
-    while (entry != NULL) {
-        if (compare_visited_keys(entry->key, key)) {
-            return true; // Already visited
-        }
-        entry = entry->next;
+// Start a first-visit pass: bumping the generation makes every (state, action) read as unvisited.
+// The stamps are only cleared when the 16-bit generation wraps, once every 65535 passes.
+static void begin_visit_pass(EpisodeArena* arena) {
+    if (++arena->generation == 0) {
+        memset(arena->visit_stamps, 0, (size_t)Q_NUM_STATES * 2 * sizeof(unsigned short));
+        arena->generation = 1;
     }
-
-    // Not visited, add it
-    VisitedSetEntry* new_entry = (VisitedSetEntry*)malloc(sizeof(VisitedSetEntry));
-    if (!new_entry) return false; // Allocation error, treat as not visited
-
-    new_entry->key = key;
-    new_entry->next = vs->table[index];
-    vs->table[index] = new_entry;
-    vs->count++;
-
-    return false; // Was not previously visited
 }
 
-// Destroy the visited set hash table (call this after each episode update)
-static void destroy_visited_set(VisitedSet* vs) {
-     if (!vs) return;
-    for (int i = 0; i < vs->size; ++i) {
-        VisitedSetEntry* entry = vs->table[i];
-        while (entry != NULL) {
-            VisitedSetEntry* temp = entry;
-            entry = entry->next;
-            free(temp);
-        }
-    }
-    free(vs->table);
-    free(vs);
+// Mark (state, action) as visited in the current pass (returns true if it already was)
+static bool check_and_add_visited(EpisodeArena* arena, StateTuple state, int action) {
+    int idx = state_tuple_index(state);
+    if (idx < 0) return false; // Outside the table, the Q-table lookup reports it
+    unsigned short* stamp = &arena->visit_stamps[idx * 2 + action];
+    if (*stamp == arena->generation) return true;
+    *stamp = arena->generation;
+    return false;
 }
 
+
 // --- Episode History Functions ---
 
-// Initialize episode history
-static void init_episode_history(EpisodeHistory* history, int initial_capacity) {
-    history->steps = (EpisodeStep*)malloc(initial_capacity * sizeof(EpisodeStep));
-    history->count = 0;
-    history->capacity = history->steps ? initial_capacity : 0;
+// Start an empty history backed by the arena's steps (valid until the arena's next episode)
+static EpisodeHistory episode_arena_history(EpisodeArena* arena) {
+    EpisodeHistory history;
+    history.steps = arena->steps;
+    history.count = 0;
+    history.capacity = MAX_EPISODE_STEPS;
+    return history;
 }
 
-// Add a step to the history, resizing if necessary
+// Add a step to the history (episodes never exceed MAX_EPISODE_STEPS, the arena's capacity)
 static void add_episode_step(EpisodeHistory* history, StateTuple state, int action, double reward) {
     if (history->count >= history->capacity) {
-        int new_capacity = history->capacity > 0 ? history->capacity * 2 : 10; // Double capacity
-        EpisodeStep* new_steps = (EpisodeStep*)realloc(history->steps, new_capacity * sizeof(EpisodeStep));
-        if (!new_steps) {
-            fprintf(stderr, "Error: Failed to reallocate episode history\n");
-            // Keep old data, but can't add more
-            return;
-        }
-        history->steps = new_steps;
-        history->capacity = new_capacity;
+        fprintf(stderr, "Error: Episode history is full (%d steps)\n", history->capacity);
+        return;
     }
     history->steps[history->count].state = state;
     history->steps[history->count].action = action;
@@ -1181,14 +1572,146 @@ static void add_episode_step(EpisodeHistory* history, StateTuple state, int acti
     history->count++;
 }
 
-// Free memory used by episode history
-static void free_episode_history(EpisodeHistory* history) {
-    if (history && history->steps) {
-        free(history->steps);
-        history->steps = NULL;
-        history->count = 0;
-        history->capacity = 0;
+// --- Concurrent Q-Table Functions ---
+
+// Full 32-bit hash of a StateTuple: low CQ_SHARD_BITS select the shard, the rest the probe start
+static unsigned int mix_state_tuple(StateTuple s) {
+    unsigned int h = (unsigned int)s.position;
+    h = (h * 0x01000193u) ^ (unsigned int)s.money_bin;
+    h = (h * 0x01000193u) ^ (unsigned int)(s.current_prop_owner + 1);
+    h = (h * 0x01000193u) ^ (unsigned int)s.in_jail;
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// Create an empty concurrent Q-table
+static ConcurrentQTable* create_concurrent_q_table(void) {
+    ConcurrentQTable* cq = (ConcurrentQTable*)malloc(sizeof(ConcurrentQTable));
+    if (!cq) return NULL;
+    for (int i = 0; i < CQ_NUM_SHARDS; ++i) {
+        CQShard* shard = &cq->shards[i];
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->capacity = CQ_SHARD_INITIAL_CAPACITY;
+        shard->count = 0;
+        shard->slots = (CQSlot*)calloc(shard->capacity, sizeof(CQSlot));
+        if (!shard->slots) {
+            for (int j = 0; j <= i; ++j) {
+                free(cq->shards[j].slots);
+                pthread_mutex_destroy(&cq->shards[j].lock);
+            }
+            free(cq);
+            return NULL;
+        }
+    }
+    return cq;
+}
+
+// Destroy a concurrent Q-table
+static void destroy_concurrent_q_table(ConcurrentQTable* cq) {
+    if (!cq) return;
+    for (int i = 0; i < CQ_NUM_SHARDS; ++i) {
+        free(cq->shards[i].slots);
+        pthread_mutex_destroy(&cq->shards[i].lock);
+    }
+    free(cq);
+}
+
+// Double a shard's slot array and rehash its entries (caller holds the shard lock)
+static bool cq_shard_grow(CQShard* shard) {
+    int new_capacity = shard->capacity * 2;
+    CQSlot* new_slots = (CQSlot*)calloc(new_capacity, sizeof(CQSlot));
+    if (!new_slots) return false;
+    unsigned int mask = (unsigned int)new_capacity - 1;
+    for (int i = 0; i < shard->capacity; ++i) {
+        if (!shard->slots[i].used) continue;
+        unsigned int j = (mix_state_tuple(shard->slots[i].key) >> CQ_SHARD_BITS) & mask;
+        while (new_slots[j].used) j = (j + 1) & mask;
+        new_slots[j] = shard->slots[i];
+    }
+    free(shard->slots);
+    shard->slots = new_slots;
+    shard->capacity = new_capacity;
+    return true;
+}
+
+// Add one first-visit return G for (state, action); safe to call from any number of threads
+static bool cq_accumulate(ConcurrentQTable* cq, StateTuple key, int action, double G) {
+    unsigned int hash = mix_state_tuple(key);
+    CQShard* shard = &cq->shards[hash & (CQ_NUM_SHARDS - 1)];
+    bool ok = true;
+
+    pthread_mutex_lock(&shard->lock);
+    if ((shard->count + 1) * 10 > shard->capacity * 7 && !cq_shard_grow(shard)) {
+        ok = false;
+    } else {
+        // Linear probe: stop at the matching key or the first free slot
+        unsigned int mask = (unsigned int)shard->capacity - 1;
+        unsigned int i = (hash >> CQ_SHARD_BITS) & mask;
+        while (shard->slots[i].used && !compare_state_tuples(shard->slots[i].key, key)) {
+            i = (i + 1) & mask;
+        }
+        CQSlot* slot = &shard->slots[i];
+        if (!slot->used) {
+            slot->used = true;
+            slot->key = key;
+            memset(slot->values, 0, sizeof(slot->values));
+            shard->count++;
+        }
+        slot->values[action].sum_returns += G;
+        slot->values[action].sum_sq_returns += G * G;
+        slot->values[action].count++;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return ok;
+}
+
+// First-visit Monte Carlo pass over one episode, accumulating into the concurrent table
+static void update_mc_concurrent(ConcurrentQTable* cq, EpisodeHistory* history, EpisodeArena* arena) {
+    double G = 0.0;
+    begin_visit_pass(arena);
+
+    // Iterate backwards through the episode (same visit rule as update_mc)
+    for (int i = history->count - 1; i >= 0; --i) {
+        G += history->steps[i].reward;
+        StateTuple state_tuple = history->steps[i].state;
+        int action = history->steps[i].action;
+        if (!check_and_add_visited(arena, state_tuple, action)) {
+            if (!cq_accumulate(cq, state_tuple, action, G)) {
+                fprintf(stderr, "Warning: Failed to grow concurrent Q-table shard during update. Skipping step.\n");
+            }
+        }
+    }
+}
+
+// Fold the accumulated sums and counts into a Q-table and empty the shards (no concurrent writers allowed)
+static bool cq_drain_into(ConcurrentQTable* cq, QTable* dst) {
+    bool ok = true;
+    for (int i = 0; i < CQ_NUM_SHARDS; ++i) {
+        CQShard* shard = &cq->shards[i];
+        for (int j = 0; j < shard->capacity; ++j) {
+            CQSlot* slot = &shard->slots[j];
+            if (!slot->used) continue;
+            QTableEntry* target = find_or_create_q_entry(dst, slot->key);
+            if (!target) {
+                ok = false;
+            } else {
+                for (int action = 0; action < 2; ++action) {
+                    if (slot->values[action].count == 0) continue;
+                    target->values[action].sum_returns += slot->values[action].sum_returns;
+                    target->values[action].sum_sq_returns += slot->values[action].sum_sq_returns;
+                    target->values[action].count += slot->values[action].count;
+                    target->values[action].q_value = target->values[action].sum_returns / target->values[action].count;
+                }
+            }
+            slot->used = false;
+        }
+        shard->count = 0;
     }
+    return ok;
 }
 
 // --- Agent Implementation ---
@@ -1200,7 +1723,7 @@ MonteCarloAgent* create_monte_carlo_agent(int num_players, double epsilon) {
 
     agent->epsilon = epsilon;
     agent->num_players = num_players;
-    agent->q_table = create_q_hash_table(Q_TABLE_INITIAL_SIZE);
+    agent->q_table = create_q_table();
     if (!agent->q_table) {
         free(agent);
         return NULL;
@@ -1211,7 +1734,7 @@ MonteCarloAgent* create_monte_carlo_agent(int num_players, double epsilon) {
 // Destroy the Monte Carlo agent
 void destroy_monte_carlo_agent(MonteCarloAgent* agent) {
     if (agent) {
-        destroy_q_hash_table(agent->q_table);
+        destroy_q_table(agent->q_table);
         free(agent);
     }
 }
@@ -1261,15 +1784,14 @@ int select_action_mc(MonteCarloAgent* agent, StateTuple state_tuple, MonopolyEnv
 
     // --- If buyable, use Epsilon-Greedy ---
     // Explore with probability epsilon
-    if (((double)rand() / RAND_MAX) < agent->epsilon) {
+    if (philox_stream_uniform(&env->rng) < agent->epsilon) {
         // Since buy is possible, randomly choose between 0 and 1
-        return rand() % 2;
+        return env_rand(env) % 2;
     } else {
-        // Exploit: Choose action with highest Q-value
-        QTableEntry* entry = find_or_create_q_entry(agent->q_table, state_tuple);
+        // Exploit: Choose action with highest Q-value (read-only lookup, deciding never grows the table)
+        const QTableEntry* entry = find_q_entry(agent->q_table, state_tuple);
         if (!entry) {
-             fprintf(stderr, "Warning: Failed to find/create Q-table entry in select_action. Defaulting to random.\n");
-             return rand() % 2; // Fallback if allocation failed
+             return env_rand(env) % 2; // Unseen state: both Q-values are 0, so this is a tie
         }
 
         double q_val_0 = entry->values[0].q_value;
@@ -1277,7 +1799,7 @@ int select_action_mc(MonteCarloAgent* agent, StateTuple state_tuple, MonopolyEnv
 
         // Choose the action with the higher Q-value, break ties randomly
         if (fabs(q_val_0 - q_val_1) < 1e-9) { // Floats are equal (or both 0 initially)
-            return rand() % 2; // Break tie randomly
+            return env_rand(env) % 2; // Break tie randomly
         } else if (q_val_1 > q_val_0) {
             return 1; // Buy has higher value
         } else {
@@ -1287,23 +1809,15 @@ int select_action_mc(MonteCarloAgent* agent, StateTuple state_tuple, MonopolyEnv
 }
 
 // Generate one episode using the agent's policy
-EpisodeHistory generate_episode_mc(MonteCarloAgent* agent, MonopolyEnv* env, int episode_id, LogEntry** out_logs, int* out_log_count) {
-    EpisodeHistory history;
-    init_episode_history(&history, 100); // Initial capacity 100 steps
+EpisodeHistory generate_episode_mc(MonteCarloAgent* agent, MonopolyEnv* env, EpisodeArena* arena, int episode_id, LogEntry** out_logs, int* out_log_count) {
+    EpisodeHistory history = episode_arena_history(arena);
 
     // --- Manage Detailed Logs ---
     #define MAX_LOG_ENTRIES 1000
     static LogEntry log_buffer[MAX_LOG_ENTRIES]; // Static buffer for simplicity
     int log_count = 0;
 
-    int obs_size = get_observation_size(agent->num_players);
-    int* obs = (int*)malloc(obs_size * sizeof(int));
-    if (!obs) {
-        fprintf(stderr, "Error: Failed to allocate observation buffer in generate_episode\n");
-        history.count = -1; // Indicate error
-        return history;
-    }
-
+    int* obs = arena->obs;
     reset_monopoly_env(env, obs);
     bool done = false;
     int step_count = 0;
@@ -1312,6 +1826,9 @@ EpisodeHistory generate_episode_mc(MonteCarloAgent* agent, MonopolyEnv* env, int
         int current_player = env->current_player; // Who's turn is it?
         StateTuple state_tuple = _get_state_tuple_c(obs, agent->num_players, env->board_size);
 
+        // Every draw of this step (action choice, dice, cards) comes from counter (episode_id, step_count)
+        philox_stream_seek(&env->rng, episode_id, step_count);
+
         // Agent selects action based on its policy
         int action = select_action_mc(agent, state_tuple, env);
 
@@ -1334,26 +1851,20 @@ EpisodeHistory generate_episode_mc(MonteCarloAgent* agent, MonopolyEnv* env, int
         step_count++;
     }
 
-    free(obs);
-
     // Pass log data back (if requested)
     if (out_logs && out_log_count) {
         *out_logs = log_buffer; // Point to the static buffer
         *out_log_count = log_count;
     }
 
-    return history; // Remember to call free_episode_history on this later
+    return history; // Steps live in the arena until its next episode
 }
 
 // Update Q-values using First-Visit Monte Carlo based on an episode history
-void update_mc(MonteCarloAgent* agent, EpisodeHistory* history) {
+void update_mc(MonteCarloAgent* agent, EpisodeHistory* history, EpisodeArena* arena) {
     double G = 0.0; // Cumulative reward (Return)
-    // Create a temporary set to track visited (state, action) pairs for this episode *only*
-    VisitedSet* visited_state_actions = create_visited_set(VISITED_SET_INITIAL_SIZE);
-    if (!visited_state_actions) {
-         fprintf(stderr, "Error: Failed to create visited set for update. Skipping update.\n");
-         return;
-    }
+    // Track visited (state, action) pairs for this episode *only*
+    begin_visit_pass(arena);
 
     // Iterate backwards through the episode
     for (int i = history->count - 1; i >= 0; --i) {
@@ -1363,19 +1874,18 @@ void update_mc(MonteCarloAgent* agent, EpisodeHistory* history) {
 
         G += reward; // Update return G
 
-        VisitedKey current_key = {state_tuple, action};
-
         // First-visit Monte Carlo check: only update the first time this (s,a) was visited *in this backward pass*
-        if (!check_and_add_visited(visited_state_actions, current_key)) {
+        if (!check_and_add_visited(arena, state_tuple, action)) {
             // This is the first visit for this (s,a) pair in this episode traverse
             QTableEntry* entry = find_or_create_q_entry(agent->q_table, state_tuple);
             if (!entry) {
-                fprintf(stderr, "Warning: Failed to find/create Q-table entry during update. Skipping step.\n");
-                continue; // Skip if allocation failed
+                fprintf(stderr, "Warning: State outside the Q-table during update. Skipping step.\n");
+                continue; // Skip an unrepresentable state
             }
 
-            // Update the sum of returns and count for the specific action
+            // Update the sums of returns and count for the specific action
             entry->values[action].sum_returns += G;
+            entry->values[action].sum_sq_returns += G * G;
             entry->values[action].count++;
 
             // Update Q-value as the average of observed returns
@@ -1384,40 +1894,261 @@ void update_mc(MonteCarloAgent* agent, EpisodeHistory* history) {
             // Policy improvement is implicit via epsilon-greedy action selection in the next episode
         }
     }
+}
+
+// Flatten the learned Q-values into one greedy action code per dense state index.
+// Mirrors the exploit branch of select_action_mc so the kernel follows the same policy.
+static void build_greedy_action_table(const MonteCarloAgent* agent, unsigned char* greedy_actions) {
+    memset(greedy_actions, GREEDY_TIE, Q_NUM_STATES); // Unvisited states have equal (zero) Q-values
+
+    // The host and device tables share state_tuple_index, so this is a straight pass over the entries
+    const QTableEntry* entries = agent->q_table->entries;
+    for (int idx = 0; idx < Q_NUM_STATES; ++idx) {
+        if (!entries[idx].used) continue;
+
+        double q_val_0 = entries[idx].values[0].q_value;
+        double q_val_1 = entries[idx].values[1].q_value;
+        if (fabs(q_val_0 - q_val_1) < 1e-9) {
+            greedy_actions[idx] = GREEDY_TIE;
+        } else {
+            greedy_actions[idx] = (q_val_1 > q_val_0) ? GREEDY_BUY : GREEDY_PASS;
+        }
+    }
+}
+
+// --- Q-Table Checkpoints ---
+
+// Episode ids a checkpointing process trains: its slice of a multi-rank run, or {1, 0, 0} for a single
+// process, whose episode count may grow on resume
+typedef struct {
+    int ranks;                    // Processes the run's episode ids are split over
+    long long base;               // First episode id of this process's slice
+    long long episodes;           // Episode ids in the slice
+} CheckpointSlice;
+
+// Fixed header at offset 0 of a checkpoint file. The dense table follows at CHECKPOINT_HEADER_BYTES as
+// Q_NUM_STATES QTableEntry records, byte for byte, so a warm start maps it instead of parsing it.
+typedef struct {
+    char magic[8];                // CHECKPOINT_MAGIC
+    int version;                  // CHECKPOINT_VERSION
+    int entry_bytes;              // sizeof(QTableEntry) of the writer
+    int num_states;               // Q_NUM_STATES of the writer
+    int num_players;
+    int used_count;               // QTable.count
+    int split_ranks;              // CheckpointSlice of the writer
+    unsigned long long seed;      // Key of every episode's Philox stream
+    long long episodes_done;      // Episodes of the slice already trained; training resumes at slice_base + this
+    long long slice_base;
+    long long slice_episodes;
+} CheckpointHeader;
+
+// Write the table and training progress to `path` via a temporary file renamed over it, so a crash
+// mid-write leaves the previous checkpoint intact
+static bool save_checkpoint(const char* path, const QTable* qt, int num_players, unsigned long long seed, long long episodes_done,
+                            CheckpointSlice slice) {
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        fprintf(stderr, "Error: Could not open checkpoint file '%s' for writing: %s\n", tmp_path, strerror(errno));
+        return false;
+    }
 
-    // Clean up the temporary visited set for this episode
-    destroy_visited_set(visited_state_actions);
+    static char header_block[CHECKPOINT_HEADER_BYTES]; // Zero padding up to the entries
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.entry_bytes = (int)sizeof(QTableEntry);
+    header.num_states = Q_NUM_STATES;
+    header.num_players = num_players;
+    header.used_count = qt->count;
+    header.split_ranks = slice.ranks;
+    header.seed = seed;
+    header.episodes_done = episodes_done;
+    header.slice_base = slice.base;
+    header.slice_episodes = slice.episodes;
+    memcpy(header_block, &header, sizeof(header));
+
+    bool ok = fwrite(header_block, 1, sizeof(header_block), fp) == sizeof(header_block) &&
+              fwrite(qt->entries, sizeof(QTableEntry), Q_NUM_STATES, fp) == Q_NUM_STATES &&
+              fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    if (fclose(fp) != 0) ok = false;
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Error: Failed to write checkpoint '%s': %s\n", path, strerror(errno));
+        remove(tmp_path);
+        return false;
+    }
+    return true;
 }
 
-// --- CUDA Kernel Functions ---
+// Replace the table with a checkpoint's and return its seed, progress and slice (slice may be NULL). The entries
+// are mapped copy-on-write, so the load costs no parse or copy and training never writes back to the file.
+static bool load_checkpoint(const char* path, QTable* qt, int num_players, unsigned long long* seed, long long* episodes_done,
+                            CheckpointSlice* slice) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not open checkpoint '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    size_t entries_bytes = (size_t)Q_NUM_STATES * sizeof(QTableEntry);
+    struct stat st;
+    CheckpointHeader header;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != CHECKPOINT_HEADER_BYTES + entries_bytes ||
+        pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 || header.version != CHECKPOINT_VERSION ||
+        header.entry_bytes != (int)sizeof(QTableEntry) || header.num_states != Q_NUM_STATES) {
+        fprintf(stderr, "Error: '%s' is not a checkpoint of this build.\n", path);
+        close(fd);
+        return false;
+    }
+    if (header.num_players != num_players) {
+        fprintf(stderr, "Error: Checkpoint '%s' was trained with %d players, not %d.\n", path, header.num_players, num_players);
+        close(fd);
+        return false;
+    }
+
+    QTableEntry* entries = (QTableEntry*)mmap(NULL, entries_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, CHECKPOINT_HEADER_BYTES);
+    if (entries == MAP_FAILED) {
+        // Pages larger than the header: read the entries into the existing table instead
+        entries = NULL;
+        if (pread(fd, qt->entries, entries_bytes, CHECKPOINT_HEADER_BYTES) != (ssize_t)entries_bytes) {
+            fprintf(stderr, "Error: Failed to read checkpoint '%s': %s\n", path, strerror(errno));
+            close(fd);
+            return false;
+        }
+    }
+    close(fd);
+
+    if (entries) {
+        release_q_table_entries(qt);
+        qt->entries = entries;
+        qt->mapped_bytes = entries_bytes;
+    }
+    qt->count = header.used_count;
+    *seed = header.seed;
+    *episodes_done = header.episodes_done;
+    if (slice) {
+        slice->ranks = header.split_ranks;
+        slice->base = header.slice_base;
+        slice->episodes = header.slice_episodes;
+    }
+    return true;
+}
+
+// Checkpointing settings of a training run (path NULL = no checkpoints)
+typedef struct {
+    const char* path;
+    int every;                    // Episodes between periodic checkpoints
+    unsigned long long seed;
+    CheckpointSlice slice;
+} CheckpointConfig;
+
+// Checkpoint after `done` episodes when a period boundary lies in (prev_done, done], or when forced
+static void checkpoint_progress(const CheckpointConfig* cfg, const MonteCarloAgent* agent, long long prev_done, long long done, bool force) {
+    if (!cfg->path) return;
+    if (!force && done / cfg->every == prev_done / cfg->every) return;
+    if (save_checkpoint(cfg->path, agent->q_table, agent->num_players, cfg->seed, done, cfg->slice)) {
+        printf("Checkpoint saved to '%s' after %lld episodes.\n", cfg->path, done);
+    }
+}
+
+// --- Frozen Policy Inference ---
+
+// Read-only greedy policy for serving trained agents: the learned action of every dense state, fixed
+// when frozen. Queries only read it, so any number of threads share one policy without locks or allocation.
+typedef struct {
+    unsigned char actions[Q_NUM_STATES]; // 1 = Buy, 0 = Pass (ties and unvisited states serve Pass)
+    int num_players;
+} FrozenPolicy;
+
+// Snapshot a Q-table's greedy actions (NULL on allocation failure)
+FrozenPolicy* freeze_policy(const QTable* qt, int num_players) {
+    FrozenPolicy* policy = (FrozenPolicy*)malloc(sizeof(FrozenPolicy));
+    if (!policy) return NULL;
+    policy->num_players = num_players;
+    for (int idx = 0; idx < Q_NUM_STATES; ++idx) {
+        // Same comparison as the exploit branch of select_action_mc, minus its random tie-break
+        const QTableEntry* entry = &qt->entries[idx];
+        policy->actions[idx] = entry->used && entry->values[1].q_value - entry->values[0].q_value >= 1e-9;
+    }
+    return policy;
+}
 
-// CUDA device function to get a random number
-__device__ int cuda_rand(curandState* state) {
-    return curand(state) % RAND_MAX;
+// Load a policy straight from a --checkpoint file
+FrozenPolicy* load_frozen_policy(const char* checkpoint_path, int num_players) {
+    QTable* qt = create_q_table();
+    if (!qt) return NULL;
+    unsigned long long seed;
+    long long episodes_done;
+    FrozenPolicy* policy = NULL;
+    if (load_checkpoint(checkpoint_path, qt, num_players, &seed, &episodes_done, NULL)) {
+        policy = freeze_policy(qt, num_players);
+    }
+    destroy_q_table(qt);
+    return policy;
+}
+
+void destroy_frozen_policy(FrozenPolicy* policy) {
+    free(policy);
+}
+
+// Greedy action for one state (0 = Pass, 1 = Buy); only meaningful when buying is possible
+int frozen_policy_action(const FrozenPolicy* policy, StateTuple state) {
+    int idx = state_tuple_index(state);
+    return idx < 0 ? 0 : policy->actions[idx];
 }
 
-// CUDA device function to get a random float between 0 and 1
-__device__ float cuda_rand_float(curandState* state) {
-    return curand_uniform(state);
+// Batched queries: actions[i] is the greedy action for states[i]
+void frozen_policy_actions(const FrozenPolicy* policy, const StateTuple* states, int* actions, int count) {
+    for (int i = 0; i < count; ++i) {
+        actions[i] = frozen_policy_action(policy, states[i]);
+    }
 }
 
-// CUDA device function to check if a position requires paying a fee
-__device__ int cuda_get_fee_for_position(int position) {
-    switch (position) {
-        case 4: return 200; // Income tax
-        case 38: return 100; // Luxury tax
-        default: return 0;
+// Batched queries from raw observations in the get_observation layout, one every obs_stride ints
+void frozen_policy_actions_from_obs(const FrozenPolicy* policy, const int* obs, int obs_stride, int board_size,
+                                    int* actions, int count) {
+    for (int i = 0; i < count; ++i) {
+        StateTuple state = _get_state_tuple_c(obs + (size_t)i * obs_stride, policy->num_players, board_size);
+        actions[i] = frozen_policy_action(policy, state);
     }
 }
 
-// CUDA device function to check if a position is Chance
-__device__ bool cuda_is_chance_position(int position) {
-    return position == 7 || position == 22 || position == 36;
+// --- CUDA Kernel Functions ---
+
+// Card effects of both decks, indexed [CardDeckKind][card] and set by upload_constant_tables. A draw is
+// one 4-byte constant load, the same cost for any deck size up to MAX_DECK_SIZE.
+__constant__ CardEffect c_card_effects[NUM_CARD_DECKS][MAX_DECK_SIZE];
+__constant__ int c_deck_sizes[NUM_CARD_DECKS];
+
+// Board tables, also set by upload_constant_tables. Lanes index these by their own square, which the
+// constant cache would serialize, so each block stages them in shared memory once.
+__constant__ int c_property_prices[BOARD_SIZE];
+__constant__ int c_property_rents[BOARD_SIZE];
+__constant__ int c_property_house_costs[BOARD_SIZE];
+__constant__ DiceTransition c_dice_transitions[BOARD_SIZE * DICE_OUTCOMES]; // MonopolyEnv.transitions, flattened
+
+// The run's configs, set by upload_sweep_configs. Every lane reads its episode's entry once per game.
+__constant__ SweepConfig c_sweep_configs[MAX_SWEEP_CONFIGS];
+
+// CUDA device function to get a random number in [0, 2^31) (same mapping as the host env_rand)
+__device__ int cuda_rand(PhiloxStream* rng) {
+    return (int)(philox_stream_next(rng) >> 1);
+}
+
+// CUDA device function to roll both dice with one draw (same mapping as the host env_roll_dice)
+__device__ int cuda_roll_dice(PhiloxStream* rng) {
+    return (int)__umulhi(philox_stream_next(rng), DICE_OUTCOMES);
 }
 
-// CUDA device function to check if a position is Community Chest
-__device__ bool cuda_is_chest_position(int position) {
-    return position == 2 || position == 17 || position == 33;
+// CUDA device function to find the owner of a square from the bit-packed SoA ownership masks.
+// owned_masks points at this lane's column; returns -1 if the bank owns the square.
+__device__ int cuda_square_owner(const unsigned long long* owned_masks, int stride, int num_players, int square) {
+    for (int i = 0; i < num_players; i++) {
+        if ((owned_masks[i * stride] >> square) & 1ull) return i;
+    }
+    return -1;
 }
 
 // CUDA device function to extract state tuple from observation
@@ -1445,397 +2176,484 @@ __device__ StateTuple cuda_get_state_tuple(const int* obs, int num_players, int
     return current_state_tuple;
 }
 
-// CUDA kernel to initialize random states
-__global__ void init_rand_states(curandState* states, unsigned long seed) {
-    int idx = threadIdx.x + blockIdx.x * blockDim.x;
-    curand_init(seed, idx, 0, &states[idx]);
-}
-
-// CUDA device string handling functions
-__device__ void d_strcpy(char* dest, const char* src, int max_len) {
-    int i;
-    for (i = 0; i < max_len - 1 && src[i] != '\0'; i++) {
-        dest[i] = src[i];
+// Kernel: persistent lanes simulate episodes, writing packed StepRecords.
+// Each lane claims the next episode index of the batch from work_counter when its game ends, so a
+// lane never idles behind a long game while episodes are left; the launch only has to cover the
+// lanes that fit on the device at once. Episode ids (and so the Philox streams) depend only on the
+// claimed index, so results do not depend on which lane played which episode.
+// EMIT_EVENTS = false is the training-only specialization: it records just the fields the MC
+// update reads (state, action, reward) and skips event codes, card ids and the owned-property
+// count, so the step loop carries no logging work at all.
+// block_counters (one KernelCounters per block) is NULL unless --metrics asked for the hot-path counters;
+// the warp votes that detect divergence only run when it is set.
+// PLAYERS > 0 is a specialization for that many players under the standard rules: the player count,
+// board size and jail rules become compile-time constants (the matching arguments are ignored), so
+// the per-player loops unroll and the step loop folds them. PLAYERS = 0 is the generic kernel that
+// reads them all from its arguments. select_simulate_kernel picks one for a run.
+// Epsilon, starting money and the GO reward come from the episode's entry of c_sweep_configs, and
+// greedy_actions holds one Q_NUM_STATES policy table per config, so one launch can train a whole
+// grid of configs at once.
+template <bool EMIT_EVENTS, int PLAYERS>
+__global__ void simulate_episodes_kernel(
+    unsigned long long seed,
+    int num_players,
+    int board_size,
+    int jail_position,
+    int go_to_jail_position,
+    int jail_turns,
+    int num_configs,
+    const unsigned char* __restrict__ greedy_actions,
+    CUDABatchState batch_state,
+    CUDAEpisodeData* episode_data,
+    int episode_offset,
+    int num_episodes,
+    unsigned int* work_counter,
+    unsigned long long* step_counter,
+    KernelCounters* block_counters
+) {
+    if (PLAYERS > 0) {
+        num_players = PLAYERS;
+        board_size = BOARD_SIZE;
+        jail_position = STANDARD_JAIL_POSITION;
+        go_to_jail_position = STANDARD_GO_TO_JAIL_POSITION;
+        jail_turns = STANDARD_JAIL_TURNS;
     }
-    dest[i] = '\0';
-}
 
-__device__ void d_strcat(char* dest, const char* src, int max_len) {
-    int dest_len = 0;
-    while (dest_len < max_len && dest[dest_len] != '\0') {
-        dest_len++;
-    }
-
-    int i;
-    for (i = 0; i < max_len - dest_len - 1 && src[i] != '\0'; i++) {
-        dest[dest_len + i] = src[i];
-    }
-    dest[dest_len + i] = '\0';
-}
-
-__device__ int d_strlen(const char* str, int max_len) {
-    int len = 0;
-    while (len < max_len && str[len] != '\0') {
-        len++;
-    }
-    return len;
-}
-
-__device__ void d_sprintf_int(char* dest, int value, int max_len) {
-    if (max_len <= 1) {
-        if (max_len == 1) dest[0] = '\0';
-        return;
-    }
-
-    // Handle negative numbers
-    bool is_negative = value < 0;
-    if (is_negative) {
-        value = -value;
-    }
-
-    // Convert number to string (reversed)
-    char temp[12]; // Enough for 32-bit int
-    int idx = 0;
-    do {
-        temp[idx++] = '0' + (value % 10);
-        value /= 10;
-    } while (value > 0 && idx < 11);
-
-    // Add negative sign if needed
-    if (is_negative && idx < 11) {
-        temp[idx++] = '-';
-    }
-
-    // Reverse the string into destination
-    int dest_idx = 0;
-    while (idx > 0 && dest_idx < max_len - 1) {
-        dest[dest_idx++] = temp[--idx];
-    }
-    dest[dest_idx] = '\0';
-}
-
-__device__ const char* d_chance_card_names[NUM_CHANCE_CARDS] = {
-    "Advance to Go",
-    "Go to Jail",
-    "Bank pays you dividend",
-    "Pay poor tax"
-};
-__device__ const char* d_chance_card_descs[NUM_CHANCE_CARDS] = {
-    "Move to GO and collect $200.",
-    "Go directly to Jail.",
-    "Collect $50 from the bank.",
-    "Pay $15 poor tax."
-};
-
-__device__ const char* d_chest_card_names[NUM_CHEST_CARDS] = {
-    "Doctor's fee",
-    "Income tax refund",
-    "Go to Jail",
-    "Advance to Go"
-};
-__device__ const char* d_chest_card_descs[NUM_CHEST_CARDS] = {
-    "Pay $50 doctor's fee.",
-    "Collect $20 income tax refund.",
-    "Go directly to Jail.",
-    "Move to GO and collect $200."
-};
-
-// Modify the kernel to use device string functions
-__global__ void simulate_episodes_kernel(
-    curandState* rand_states,
-    int num_players,
-    int start_money,
-    int go_reward,
-    int board_size,
-    int jail_position,
-    int go_to_jail_position,
-    int jail_turns,
-    int* property_prices,
-    int* property_rents,
-    int* property_house_costs,
-    double epsilon,
-    CUDAEpisodeData* episode_data,
-    int episode_offset
-) {
-    // Declare shared memory arrays for property data
-    __shared__ int s_property_prices[BOARD_SIZE];
-    __shared__ int s_property_rents[BOARD_SIZE];
-    __shared__ int s_property_house_costs[BOARD_SIZE];
+    // Declare shared memory arrays for property data and the dice transitions
+    __shared__ int s_property_prices[BOARD_SIZE];
+    __shared__ int s_property_rents[BOARD_SIZE];
+    __shared__ int s_property_house_costs[BOARD_SIZE];
+    __shared__ DiceTransition s_transitions[BOARD_SIZE * DICE_OUTCOMES];
 
     // Cooperatively load property data into shared memory
     int tid = threadIdx.x;
     for(int i = tid; i < BOARD_SIZE; i += blockDim.x) {
-        s_property_prices[i] = property_prices[i];
-        s_property_rents[i] = property_rents[i];
-        s_property_house_costs[i] = property_house_costs[i];
+        s_property_prices[i] = c_property_prices[i];
+        s_property_rents[i] = c_property_rents[i];
+        s_property_house_costs[i] = c_property_house_costs[i];
+    }
+    for (int i = tid; i < BOARD_SIZE * DICE_OUTCOMES; i += blockDim.x) {
+        s_transitions[i] = c_dice_transitions[i];
     }
 
     __syncthreads();
 
     // Rest of the kernel setup
     tid = threadIdx.x + blockIdx.x * blockDim.x;
-    curandState local_state = rand_states[tid];
-
-    // Initialize environment state
-    CUDAEnvState env_state;
-    memset(&env_state, 0, sizeof(CUDAEnvState));
-    env_state.rand_state = local_state;
-
-    // Initialize player state
-    for (int i = 0; i < num_players; i++) {
-        env_state.positions[i] = 0;
-        env_state.money[i] = start_money;
-        env_state.in_jail[i] = false;
-        env_state.jail_counters[i] = 0;
-    }
-
-    // Initialize property state
-    for (int i = 0; i < board_size; i++) {
-        env_state.property_owners[i] = -1;
-        env_state.property_houses[i] = 0;
-    }
-
-    env_state.current_player = 0;
-    env_state.steps_taken = 0;
-    env_state.done = false;
-
-    // Initialize episode data
-    CUDAEpisodeData* episode = &episode_data[tid];
-    episode->count = 0;
-    episode->log_count = 0;
-    episode->episode_id = tid + episode_offset;
 
-    // Clear log buffer
-    memset(episode->logs, 0, sizeof(LogEntry) * MAX_EPISODE_STEPS);
-
-    // Simulate episode
-    int step_count = 0;
-    char temp[MAX_DESC_LEN]; // Declare temp buffer at the start of the kernel
-
-    while (!env_state.done && step_count < MAX_EPISODE_STEPS) {
-        // Get current player
-        int p = env_state.current_player;
-        int prev_money = env_state.money[p];
-        int prev_position = env_state.positions[p];
-
-        // Roll dice
-        int dice1 = (cuda_rand(&env_state.rand_state) % 6) + 1;
-        int dice2 = (cuda_rand(&env_state.rand_state) % 6) + 1;
-        int dice_total = dice1 + dice2;
-
-        // Move player
-        int new_position = (prev_position + dice_total) % board_size;
-        int landed_position = new_position;
-
-        // Check for passing GO
-        if (new_position < prev_position && !env_state.in_jail[p]) {
-            env_state.money[p] += go_reward;
+    // Stateless per-lane stream: nothing to load or store, the counter is (episode, step, block)
+    PhiloxStream rng;
+    philox_stream_init(&rng, seed);
+
+    // This lane's column of the SoA batch state: element for player p is at [p * stride]
+    const int stride = batch_state.stride;
+    int* positions = batch_state.positions + tid;
+    int* money = batch_state.money + tid;
+    unsigned char* in_jail = batch_state.in_jail + tid;
+    unsigned char* jail_counters = batch_state.jail_counters + tid;
+    unsigned long long* owned_masks = batch_state.owned_masks + tid;
+    unsigned char* houses = batch_state.houses + tid; // element for square i is at [i * stride]
+
+    // Claim episodes until the batch is drained
+    unsigned long long lane_steps = 0; // Added to step_counter once, when the lane retires
+    unsigned int lane_card_draws = 0, lane_jail_turns = 0, lane_bankruptcies = 0, lane_divergent = 0;
+    const bool count_divergence = block_counters != NULL;
+    const unsigned int lane_bit = 1u << (threadIdx.x & 31);
+    for (;;) {
+        int ep = (int)atomicAdd(work_counter, 1u);
+        if (ep >= num_episodes) break;
+
+        // This episode's hyperparameters and policy
+        int episode_id = ep + episode_offset;
+        const int config_id = episode_id % num_configs;
+        const SweepConfig config = c_sweep_configs[config_id];
+        const double epsilon = config.epsilon;
+        const int start_money = config.start_money;
+        const int go_reward = config.go_reward;
+        const unsigned char* policy = greedy_actions + (size_t)config_id * Q_NUM_STATES;
+
+        // Initialize player state (all squares start with the bank, so houses needs no reset)
+        for (int i = 0; i < num_players; i++) {
+            positions[i * stride] = 0;
+            money[i * stride] = start_money;
+            in_jail[i * stride] = 0;
+            jail_counters[i * stride] = 0;
+            owned_masks[i * stride] = 0ull;
         }
 
-        // Update position
-        env_state.positions[p] = new_position;
-
-        // Handle property landing
-        int prop_owner = env_state.property_owners[new_position];
-        int prop_price = s_property_prices[new_position];
-        int prop_rent = s_property_rents[new_position];
-
-        // Initialize log entry
-        LogEntry* log = &episode->logs[episode->log_count];
-        memset(log, 0, sizeof(LogEntry));
-
-        log->episode_id = episode->episode_id;
-        log->step = step_count;
-        log->player = p;
-        log->position_before = prev_position;
-        log->dice_roll = dice_total;
-        log->landed_on_position = landed_position;
-        log->position_after = new_position;
-        log->money_before = prev_money;
-        log->in_jail = env_state.in_jail[p];
-
-        // Decide action and handle property
-        int action = 0;
-        double reward = 0.0;
-
-        if (prop_price > 0 && prop_owner == -1 && env_state.money[p] >= prop_price) {
-            // Epsilon-greedy action selection
-            if (cuda_rand_float(&env_state.rand_state) < epsilon) {
-                action = cuda_rand(&env_state.rand_state) % 2;
-            } else {
-                action = 1; // Default to buy for demonstration
+        int current_player = 0;
+        bool done = false;
+
+        // Observation the policy sees, as in generate_episode_mc: after reset it is player 0's start state,
+        // afterwards the post-step state of the player who just moved
+        StateTuple state = {0, money_to_bin(start_money), -1, 0};
+
+        // Initialize episode data
+        CUDAEpisodeData* episode = &episode_data[ep];
+        episode->count = 0;
+        episode->episode_id = episode_id;
+
+        // Simulate episode. Each step follows generate_episode_mc + step_monopoly_env exactly, including the
+        // order of random draws (action, jail roll, roll, card), so a seed gives the same game on both paths.
+        int step_count = 0;
+
+        while (!done && step_count < MAX_EPISODE_STEPS) {
+            // Get current player (money and position stay in registers for the step)
+            int p = current_player;
+            int prev_money = money[p * stride];
+            int prev_position = positions[p * stride];
+            int cash = prev_money;
+            int pos = prev_position;
+            bool was_in_jail = in_jail[p * stride] != 0;
+            philox_stream_seek(&rng, episode_id, step_count);
+
+            // Epsilon-greedy action, drawn only where select_action_mc would draw: the mover stands on an
+            // unowned square it can afford and is not in jail
+            int state_idx = state_tuple_index(state);
+            int action = 0;
+            int here_price = s_property_prices[prev_position];
+            if (!was_in_jail && here_price > 0 && prev_money >= here_price &&
+                cuda_square_owner(owned_masks, stride, num_players, prev_position) == -1) {
+                if (philox_stream_uniform(&rng) < epsilon) {
+                    action = cuda_rand(&rng) % 2;
+                } else {
+                    // Exploit: O(1) lookup into the greedy table uploaded before this batch
+                    unsigned char greedy = (state_idx >= 0) ? policy[state_idx] : GREEDY_TIE;
+                    action = (greedy == GREEDY_TIE) ? cuda_rand(&rng) % 2 : greedy;
+                }
             }
 
-            // Execute action
-            if (action == 1) {
-                env_state.money[p] -= prop_price;
-                env_state.property_owners[new_position] = p;
-                d_sprintf_int(temp, new_position, MAX_DESC_LEN);
-                d_strcpy(log->action_desc, "Bought property at position ", MAX_DESC_LEN);
-                d_strcat(log->action_desc, temp, MAX_DESC_LEN);
-                d_strcat(log->action_desc, " for $", MAX_DESC_LEN);
-                d_sprintf_int(temp, prop_price, MAX_DESC_LEN);
-                d_strcat(log->action_desc, temp, MAX_DESC_LEN);
-            } else {
-                d_sprintf_int(temp, new_position, MAX_DESC_LEN);
-                d_strcpy(log->action_desc, "Passed on buying property at position ", MAX_DESC_LEN);
-                d_strcat(log->action_desc, temp, MAX_DESC_LEN);
+            // Packed record for this step (text is rebuilt on the host by decode_step_record)
+            unsigned int events = was_in_jail ? STEP_EVT_IN_JAIL : 0;
+            int fee_paid = 0;
+            int card_idx = -1;
+            int payee = -1;
+            int landed_houses = 0;
+            int dice_total = 0;
+            int landed_position = prev_position;
+            double reward = 0.0; // Same terms as step_monopoly_env: GO, fees, rent, jail fee, bankruptcy
+
+            // Jail: doubles or the turn limit release the player (the limit costs the fee), else the turn ends
+            bool moves = true;
+            if (count_divergence) {
+                // Counted once per split warp, by its lowest active lane
+                unsigned int active = __activemask();
+                unsigned int jailed = __ballot_sync(active, was_in_jail);
+                if (jailed != 0 && jailed != active && (active & (0u - active)) == lane_bit) lane_divergent++;
+            }
+            if (was_in_jail) {
+                lane_jail_turns++;
+                int jail_count = jail_counters[p * stride] + 1;
+                bool doubles = (s_transitions[prev_position * DICE_OUTCOMES + cuda_roll_dice(&rng)].flags & DICE_DOUBLES) != 0;
+                if (doubles || jail_count >= jail_turns) {
+                    if (!doubles) {
+                        cash -= JAIL_FEE;
+                        fee_paid += JAIL_FEE;
+                        reward -= JAIL_FEE;
+                        if (EMIT_EVENTS) events |= STEP_EVT_JAIL_FEE;
+                    }
+                    in_jail[p * stride] = 0;
+                    jail_count = 0;
+                } else {
+                    moves = false;
+                    if (EMIT_EVENTS) events |= STEP_EVT_JAIL_STAY;
+                }
+                jail_counters[p * stride] = (unsigned char)jail_count;
             }
-        } else if (prop_owner != -1 && prop_owner != p) {
-            // Pay rent
-            int rent_due = prop_rent;
-            env_state.money[p] -= rent_due;
-            d_strcpy(log->action_desc, "Paid $", MAX_DESC_LEN);
-            d_sprintf_int(temp, rent_due, MAX_DESC_LEN);
-            d_strcat(log->action_desc, temp, MAX_DESC_LEN);
-            d_strcat(log->action_desc, " rent at position ", MAX_DESC_LEN);
-            d_sprintf_int(temp, new_position, MAX_DESC_LEN);
-            d_strcat(log->action_desc, temp, MAX_DESC_LEN);
-            d_strcat(log->action_desc, " to player ", MAX_DESC_LEN);
-            d_sprintf_int(temp, prop_owner, MAX_DESC_LEN);
-            d_strcat(log->action_desc, temp, MAX_DESC_LEN);
-            log->fee_paid = rent_due;
-        }
 
-        // Calculate reward as change in money
-        reward = (double)(env_state.money[p] - prev_money);
+            if (moves) {
+                // Roll dice and move: one draw, one table entry
+                DiceTransition move = s_transitions[prev_position * DICE_OUTCOMES + cuda_roll_dice(&rng)];
+                dice_total = move.dice_total;
+                landed_position = move.landing;
+                pos = landed_position;
+
+                // Check for passing GO (the table never credits a move that starts on the jail square)
+                if (move.flags & DICE_PASSES_GO) {
+                    cash += go_reward;
+                    reward += go_reward;
+                    if (EMIT_EVENTS) events |= STEP_EVT_PASSED_GO;
+                }
 
-        // Check for bankruptcy
-        if (env_state.money[p] < 0) {
-            env_state.done = true;
-            reward -= 1000.0; // Bankruptcy penalty
-            d_strcat(log->action_desc, " (BANKRUPT)", MAX_DESC_LEN);
-        }
+                // Handle Chance and Community Chest (card money is not part of the reward, as on the host)
+                int deck = card_deck_of(move.square);
+                if (deck >= 0) {
+                    card_idx = cuda_rand(&rng) % c_deck_sizes[deck];
+                    lane_card_draws++;
+                    if (EMIT_EVENTS) events |= (deck == CARD_DECK_CHANCE) ? STEP_EVT_CHANCE : STEP_EVT_CHEST;
+
+                    bool jailed = false;
+                    pos = apply_card_effect(c_card_effects[deck][card_idx], pos, &cash, &jailed,
+                                            board_size, jail_position, go_reward);
+                    if (jailed) {
+                        in_jail[p * stride] = 1;
+                        jail_counters[p * stride] = 0;
+                    }
+                }
 
-        // Complete log entry
-        log->money_after = env_state.money[p];
-        log->reward = reward;
-        log->done = env_state.done;
-        log->agent_action = action;
-
-        // Count owned properties
-        log->num_owned_properties = 0;
-        for (int i = 0; i < board_size; i++) {
-            if (env_state.property_owners[i] == p) {
-                log->num_owned_properties++;
-            }
-        }
+                // Square action on the final position
+                int fee = get_fee_for_position(pos);
+                int prop_price = s_property_prices[pos];
+                if (count_divergence) {
+                    // Lanes of a warp taking different square actions (jail / tax / property / none): compared
+                    // against the lowest active lane's kind with a shuffle and a ballot, since __match_any_sync
+                    // would need sm_70
+                    int kind = (pos == go_to_jail_position) ? 0 : (fee > 0) ? 1 : (prop_price > 0) ? 2 : 3;
+                    unsigned int active = __activemask();
+                    int leader_kind = __shfl_sync(active, kind, __ffs((int)active) - 1);
+                    if (__ballot_sync(active, kind == leader_kind) != active && (active & (0u - active)) == lane_bit) lane_divergent++;
+                }
+                if (pos == go_to_jail_position) {
+                    pos = jail_position;
+                    in_jail[p * stride] = 1;
+                    jail_counters[p * stride] = 0;
+                    if (EMIT_EVENTS) events |= STEP_EVT_SENT_JAIL;
+                } else if (fee > 0) {
+                    cash -= fee;
+                    fee_paid += fee;
+                    reward -= fee;
+                    if (EMIT_EVENTS) events |= STEP_EVT_TAX;
+                } else if (prop_price > 0) {
+                    int prop_owner = cuda_square_owner(owned_masks, stride, num_players, pos);
+                    if (prop_owner == -1) {
+                        if (cash >= prop_price) {
+                            if (action == 1) {
+                                cash -= prop_price;
+                                owned_masks[p * stride] |= 1ull << pos;
+                                houses[pos * stride] = 0;
+                                if (EMIT_EVENTS) events |= STEP_EVT_BOUGHT;
+                            } else {
+                                if (EMIT_EVENTS) events |= STEP_EVT_DECLINED;
+                            }
+                        }
+                    } else if (prop_owner != p) {
+                        // Pay rent (what the player can), scaled by the owner's houses
+                        landed_houses = houses[pos * stride];
+                        int rent_due = rent_for_houses(s_property_rents[pos], landed_houses);
+                        int payment = (cash < rent_due) ? cash : rent_due;
+                        cash -= payment;
+                        money[prop_owner * stride] += payment;
+                        fee_paid += payment;
+                        reward -= payment;
+                        payee = prop_owner;
+                        if (EMIT_EVENTS) events |= STEP_EVT_PAID_RENT;
+                    } else {
+                        // Own property: "buy" adds one house when affordable
+                        int house_cost = s_property_house_costs[pos];
+                        landed_houses = houses[pos * stride];
+                        if (action == 1 && house_cost > 0 && cash >= house_cost && landed_houses < MAX_HOUSES) {
+                            houses[pos * stride] = (unsigned char)++landed_houses;
+                            cash -= house_cost;
+                            if (EMIT_EVENTS) events |= STEP_EVT_HOUSE;
+                        }
+                    }
+                }
 
-        // Handle Chance and Community Chest
-        if (cuda_is_chance_position(new_position)) {
-            int card_idx = cuda_rand(&env_state.rand_state) % NUM_CHANCE_CARDS;
-            d_strcpy(log->card_drawn, d_chance_card_names[card_idx], MAX_NAME_LEN);
-            d_strcpy(log->card_specific_desc, d_chance_card_descs[card_idx], MAX_DESC_LEN);
-
-            // Apply card effect
-            if (card_idx == 0) { // Advance to Go
-                env_state.positions[p] = 0;
-                env_state.money[p] += go_reward;
-            } else if (card_idx == 1) { // Go to Jail
-                env_state.positions[p] = jail_position;
-                env_state.in_jail[p] = true;
-                env_state.jail_counters[p] = 0;
-            } else if (card_idx == 2) { // Bank dividend
-                env_state.money[p] += 50;
-            } else if (card_idx == 3) { // Pay poor tax
-                env_state.money[p] -= 15;
+                // Check for bankruptcy after selling houses, then properties
+                if (cash < 0) {
+                    unsigned long long owned = owned_masks[p * stride];
+                    cash = liquidate_assets(cash, &owned, houses, stride, s_property_prices, s_property_house_costs);
+                    if (EMIT_EVENTS && owned != owned_masks[p * stride]) events |= STEP_EVT_SOLD;
+                    if (cash < 0) {
+                        done = true;
+                        lane_bankruptcies++;
+                        reward -= BANKRUPTCY_PENALTY;
+                        owned = 0ull; // Forfeit everything to the bank
+                        if (EMIT_EVENTS) events |= STEP_EVT_BANKRUPT;
+                    }
+                    owned_masks[p * stride] = owned;
+                }
             }
-        } else if (cuda_is_chest_position(new_position)) {
-            int card_idx = cuda_rand(&env_state.rand_state) % NUM_CHEST_CARDS;
-            d_strcpy(log->card_drawn, d_chest_card_names[card_idx], MAX_NAME_LEN);
-            d_strcpy(log->card_specific_desc, d_chest_card_descs[card_idx], MAX_DESC_LEN);
-
-            // Apply card effect
-            if (card_idx == 0) { // Doctor's fee
-                env_state.money[p] -= 50;
-            } else if (card_idx == 1) { // Income tax refund
-                env_state.money[p] += 20;
-            } else if (card_idx == 2) { // Go to Jail
-                env_state.positions[p] = jail_position;
-                env_state.in_jail[p] = true;
-                env_state.jail_counters[p] = 0;
-            } else if (card_idx == 3) { // Advance to Go
-                env_state.positions[p] = 0;
-                env_state.money[p] += go_reward;
+
+            positions[p * stride] = pos;
+            money[p * stride] = cash;
+
+            // Observation for the next decision (forfeited squares went back to the bank)
+            StateTuple next_state = {pos, money_to_bin(cash), cuda_square_owner(owned_masks, stride, num_players, pos),
+                                     (int)in_jail[p * stride]};
+
+            // Record step: the fields read by step_record_state() and the MC update are always written
+            StepRecord* rec = &episode->records[episode->count];
+            rec->state = state_idx;
+            rec->action = (unsigned char)action;
+            rec->reward = (float)reward;
+            if (EMIT_EVENTS) {
+                if (done) events |= STEP_EVT_DONE;
+                rec->events = (unsigned short)events;
+                rec->fee_paid = (unsigned short)(fee_paid < 0 ? 0 : fee_paid > 0xFFFF ? 0xFFFF : fee_paid);
+                rec->card = (signed char)card_idx;
+                rec->dice = (unsigned char)dice_total;
+                rec->player = (unsigned char)p;
+                rec->position_before = (unsigned char)prev_position;
+                rec->money_before = prev_money;
+                rec->landed_on = (unsigned char)landed_position;
+                rec->position_after = (unsigned char)pos;
+                rec->num_owned = (unsigned char)__popcll(owned_masks[p * stride]);
+                rec->payee = (signed char)payee;
+                rec->houses = (unsigned char)landed_houses;
+                rec->money_delta = cash - prev_money;
             }
-        } else {
-            log->card_drawn[0] = '\0';
-            log->card_specific_desc[0] = '\0';
+            episode->count++;
+            state = next_state;
+
+            // Next player
+            current_player = (current_player + 1) % num_players;
+            step_count++;
         }
+        lane_steps += step_count;
+    }
+    atomicAdd(step_counter, lane_steps);
+
+    // Reduce the lanes' counters into this block's KernelCounters
+    if (block_counters) {
+        __shared__ KernelCounters s_counters;
+        if (threadIdx.x == 0) memset(&s_counters, 0, sizeof(s_counters));
+        __syncthreads();
+        atomicAdd(&s_counters.steps, lane_steps);
+        atomicAdd(&s_counters.card_draws, lane_card_draws);
+        atomicAdd(&s_counters.jail_turns, lane_jail_turns);
+        atomicAdd(&s_counters.bankruptcies, lane_bankruptcies);
+        atomicAdd(&s_counters.divergent_branches, lane_divergent);
+        __syncthreads();
+        if (threadIdx.x == 0) block_counters[blockIdx.x] = s_counters;
+    }
+}
 
-        // Increment log count
-        episode->log_count++;
+// Every simulate_episodes_kernel instantiation has this signature
+typedef void (*SimulateKernel)(unsigned long long, int, int, int, int, int, int, const unsigned char*,
+                               CUDABatchState, CUDAEpisodeData*, int, int, unsigned int*, unsigned long long*,
+                               KernelCounters*);
 
-        // Record step in episode history
-        if (episode->count < MAX_EPISODE_STEPS) {
-            StateTuple state = {prev_position, prev_money/100, prop_owner, env_state.in_jail[p]};
-            episode->steps[episode->count].state = state;
-            episode->steps[episode->count].action = action;
-            episode->steps[episode->count].reward = reward;
-            episode->count++;
-        }
+// True when env plays by the rules the specialized kernels compile in (the GO reward is per config)
+static bool uses_standard_rules(const MonopolyEnv* env) {
+    return env->board_size == BOARD_SIZE && env->jail_position == STANDARD_JAIL_POSITION &&
+           env->go_to_jail_position == STANDARD_GO_TO_JAIL_POSITION && env->jail_turns == STANDARD_JAIL_TURNS;
+}
 
-        // Next player
-        env_state.current_player = (env_state.current_player + 1) % num_players;
-        env_state.steps_taken++;
-        step_count++;
-    }
+// PLAYERS of the kernel env runs on: its player count if a specialization covers it, 0 for the generic
+// kernel. -DMONOPOLY_GENERIC_KERNEL builds only the generic kernel.
+static int specialized_players(const MonopolyEnv* env) {
+#ifndef MONOPOLY_GENERIC_KERNEL
+    if (uses_standard_rules(env) && (env->num_players == 2 || env->num_players == 4)) return env->num_players;
+#endif
+    return 0;
+}
 
-    // Save updated random state
-    rand_states[tid] = env_state.rand_state;
+static SimulateKernel select_simulate_kernel(const MonopolyEnv* env, bool emit_events) {
+    switch (specialized_players(env)) {
+#ifndef MONOPOLY_GENERIC_KERNEL
+        case 2: return emit_events ? simulate_episodes_kernel<true, 2> : simulate_episodes_kernel<false, 2>;
+        case 4: return emit_events ? simulate_episodes_kernel<true, 4> : simulate_episodes_kernel<false, 4>;
+#endif
+        default: return emit_events ? simulate_episodes_kernel<true, 0> : simulate_episodes_kernel<false, 0>;
+    }
 }
 
-// Function to escape CSV strings
-static char* escape_csv_string(const char* input) {
-    if (!input) return NULL;
+// atomicAdd on doubles is native from sm_60; older devices (nvcc's default arch among them) get the
+// compare-and-swap loop from the CUDA programming guide
+__device__ static inline void atomic_add_double(double* address, double val) {
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ < 600
+    unsigned long long* bits = (unsigned long long*)address;
+    unsigned long long old = *bits, assumed;
+    do {
+        assumed = old;
+        old = atomicCAS(bits, assumed, __double_as_longlong(val + __longlong_as_double(assumed)));
+    } while (assumed != old);
+#else
+    atomicAdd(address, val);
+#endif
+}
 
-    int quotes_to_escape = 0;
-    for (const char* p = input; *p; ++p) {
-        if (*p == '"') {
-            quotes_to_escape++;
-        }
+// First-visit Monte Carlo update on the device: one block per episode, thread i owns step i.
+// Returns G come from a block-wide suffix scan of the rewards. A step is counted only if it is the last
+// occurrence of its (state, action) pair, which is the occurrence update_mc meets first walking backwards.
+// Results are accumulated into the Q_DELTA_SLOTS slice of the episode's config in q_sum/q_sum_sq/q_count,
+// indexed by state_tuple_index(state) * 2 + action; the slice's last entry sums the episodes' returns and counts them.
+__global__ void mc_update_kernel(const CUDAEpisodeData* __restrict__ episodes, int num_configs,
+                                 double* q_sum, double* q_sum_sq, unsigned int* q_count) {
+    __shared__ double s_scan[2][MC_UPDATE_THREADS];
+    __shared__ int s_keys[MC_UPDATE_HASH_SLOTS];
+    __shared__ int s_last[MC_UPDATE_HASH_SLOTS];
+
+    const CUDAEpisodeData* episode = &episodes[blockIdx.x];
+    int count = episode->count;
+    int i = threadIdx.x;
+    size_t slice = (size_t)(episode->episode_id % num_configs) * Q_DELTA_SLOTS;
+    q_sum += slice;
+    q_sum_sq += slice;
+    q_count += slice;
+
+    for (int k = i; k < MC_UPDATE_HASH_SLOTS; k += blockDim.x) {
+        s_keys[k] = -1;
+        s_last[k] = -1;
     }
 
-    // Allocate space: original length + quotes to escape + 2 for surrounding quotes + 1 for null terminator
-    size_t new_len = strlen(input) + quotes_to_escape + 2 + 1;
-    char* output = (char*)malloc(new_len);
-    if (!output) return NULL;
+    // Load rewards back to front so an inclusive prefix scan yields G_i = r_i + ... + r_(count-1)
+    s_scan[0][i] = (i < count) ? (double)episode->records[count - 1 - i].reward : 0.0;
+    __syncthreads();
 
-    char* q = output;
-    *q++ = '"'; // Start with a quote
+    int src = 0;
+    for (int offset = 1; offset < MC_UPDATE_THREADS; offset <<= 1) {
+        double v = s_scan[src][i];
+        if (i >= offset) v += s_scan[src][i - offset];
+        s_scan[src ^ 1][i] = v;
+        src ^= 1;
+        __syncthreads();
+    }
+    if (i == 0) {
+        double episode_return = count > 0 ? s_scan[src][count - 1] : 0.0;
+        atomic_add_double(&q_sum[Q_NUM_STATES * 2], episode_return);
+        atomic_add_double(&q_sum_sq[Q_NUM_STATES * 2], episode_return * episode_return);
+        atomicAdd(&q_count[Q_NUM_STATES * 2], 1u);
+    }
 
-    for (const char* p = input; *p; ++p) {
-        if (*p == '"') {
-            *q++ = '"'; // Escape internal quote by doubling it
+    // Register each (state, action) key and keep the highest step index that carries it
+    int key = -1;
+    unsigned int slot = 0;
+    double G = 0.0;
+    if (i < count) {
+        const StepRecord* rec = &episode->records[i];
+        int state_idx = rec->state;
+        G = s_scan[src][count - 1 - i];
+        if (state_idx >= 0) {
+            key = state_idx * 2 + rec->action;
+            slot = ((unsigned int)key * 2654435761u) & (MC_UPDATE_HASH_SLOTS - 1);
+            for (;;) {
+                int prev = atomicCAS(&s_keys[slot], -1, key);
+                if (prev == -1 || prev == key) break;
+                slot = (slot + 1) & (MC_UPDATE_HASH_SLOTS - 1);
+            }
+            atomicMax(&s_last[slot], i);
         }
-        *q++ = *p; // Copy original character
     }
+    __syncthreads();
 
-    *q++ = '"'; // End with a quote
-    *q = '\0';  // Null terminate
+    if (key >= 0 && s_last[slot] == i) {
+        atomic_add_double(&q_sum[key], G);
+        atomic_add_double(&q_sum_sq[key], G * G);
+        atomicAdd(&q_count[key], 1u);
+    }
+}
 
-    return output;
+// Write a string field as a quoted CSV value, doubling embedded quotes
+static void write_csv_quoted(FILE* fp, const char* s) {
+    putc('"', fp);
+    for (; *s; ++s) {
+        if (*s == '"') putc('"', fp); // Escape internal quote by doubling it
+        putc(*s, fp);
+    }
+    putc('"', fp);
 }
 
-// Writes a single LogEntry to the CSV file
+// Writes a single LogEntry to the CSV file (buffered; the sink flushes when its buffer fills)
 static void write_log_to_csv(FILE* fp, const LogEntry* log) {
     if (!fp || !log) {
         fprintf(stderr, "Error: Invalid file pointer or log entry\n");
         return;
     }
 
-    // Escape potentially problematic string fields
-    char* escaped_action_desc = escape_csv_string(log->action_desc);
-    char* escaped_card_name = escape_csv_string(log->card_drawn);
-    char* escaped_card_spec_desc = escape_csv_string(log->card_specific_desc);
-
-    // Handle potential allocation failures during escaping
-    if (!escaped_action_desc) escaped_action_desc = strdup("\"\"");
-    if (!escaped_card_name) escaped_card_name = strdup("\"\"");
-    if (!escaped_card_spec_desc) escaped_card_spec_desc = strdup("\"\"");
-
     // Write the log entry with error checking
-    int write_result = fprintf(fp, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%.4f,%d,%d,%d,%d,%d,%s,%s,%s\n",
+    int write_result = fprintf(fp, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%.4f,%d,%d,%d,%d,%d,",
             log->episode_id,
             log->step,
             log->player,
@@ -1850,50 +2668,589 @@ static void write_log_to_csv(FILE* fp, const LogEntry* log) {
             (int)log->in_jail,
             log->fee_paid,
             log->agent_action,
-            log->num_owned_properties,
-            escaped_card_name ? escaped_card_name : "\"\"",
-            escaped_card_spec_desc ? escaped_card_spec_desc : "\"\"",
-            escaped_action_desc ? escaped_action_desc : "\"\""
+            log->num_owned_properties
     );
 
     if (write_result < 0) {
         fprintf(stderr, "Error writing to CSV file: %s\n", strerror(errno));
     }
 
-    // Force flush after each write
-    fflush(fp);
+    // Quote the free-text fields in place (no temporary escaped copies)
+    write_csv_quoted(fp, log->card_drawn);
+    putc(',', fp);
+    write_csv_quoted(fp, log->card_specific_desc);
+    putc(',', fp);
+    write_csv_quoted(fp, log->action_desc);
+    putc('\n', fp);
+}
+
+// Rebuild a full LogEntry (including text) from a packed step record.
+// Only called when something actually consumes the text, e.g. the CSV writer.
+static void decode_step_record(const StepRecord* rec, int episode_id, int step,
+                               const MonopolyEnv* env, LogEntry* out) {
+    memset(out, 0, sizeof(LogEntry));
+    out->episode_id = episode_id;
+    out->step = step;
+    out->player = rec->player;
+    out->position_before = rec->position_before;
+    out->dice_roll = rec->dice;
+    out->landed_on_position = rec->landed_on;
+    out->position_after = rec->position_after;
+    out->money_before = rec->money_before;
+    out->money_after = rec->money_before + rec->money_delta;
+    out->reward = rec->reward;
+    out->done = (rec->events & STEP_EVT_DONE) != 0;
+    out->in_jail = (rec->events & STEP_EVT_IN_JAIL) != 0;
+    out->fee_paid = rec->fee_paid;
+    out->agent_action = rec->action;
+    out->num_owned_properties = rec->num_owned;
+
+    if (rec->events & STEP_EVT_JAIL_STAY) {
+        snprintf(out->action_desc, sizeof(out->action_desc), "Failed to roll doubles in jail");
+    } else if (rec->events & STEP_EVT_BOUGHT) {
+        snprintf(out->action_desc, sizeof(out->action_desc), "Bought property at position %d for $%d",
+                 rec->landed_on, env->properties[rec->landed_on].price);
+    } else if (rec->events & STEP_EVT_DECLINED) {
+        snprintf(out->action_desc, sizeof(out->action_desc), "Passed on buying property at position %d",
+                 rec->landed_on);
+    } else if (rec->events & STEP_EVT_PAID_RENT) {
+        snprintf(out->action_desc, sizeof(out->action_desc), "Paid $%d rent at position %d with %d houses to player %d",
+                 rec->fee_paid, rec->landed_on, rec->houses, rec->payee);
+    } else if (rec->events & STEP_EVT_HOUSE) {
+        snprintf(out->action_desc, sizeof(out->action_desc), "Bought a house at position %d for $%d (now %d)",
+                 rec->landed_on, env->properties[rec->landed_on].house_cost, rec->houses);
+    } else if (rec->events & STEP_EVT_TAX) {
+        snprintf(out->action_desc, sizeof(out->action_desc), "Paid fee of $%d at position %d",
+                 get_fee_for_position(rec->landed_on), rec->landed_on);
+    } else if (rec->events & STEP_EVT_SENT_JAIL) {
+        snprintf(out->action_desc, sizeof(out->action_desc), "Landed on Go To Jail");
+    }
+    if (rec->events & STEP_EVT_JAIL_FEE) {
+        strncat(out->action_desc, " (paid jail fee)", sizeof(out->action_desc) - strlen(out->action_desc) - 1);
+    }
+    if (rec->events & STEP_EVT_SOLD) {
+        strncat(out->action_desc, " (sold assets)", sizeof(out->action_desc) - strlen(out->action_desc) - 1);
+    }
+    if (rec->events & STEP_EVT_BANKRUPT) {
+        strncat(out->action_desc, " (BANKRUPT)", sizeof(out->action_desc) - strlen(out->action_desc) - 1);
+    }
 
-    // Free the allocated escaped strings
-    free(escaped_action_desc);
-    free(escaped_card_name);
-    free(escaped_card_spec_desc);
+    // Card text comes from env's decks, which hold the same cards the kernel's tables were uploaded from
+    int deck = (rec->events & STEP_EVT_CHANCE) ? CARD_DECK_CHANCE : (rec->events & STEP_EVT_CHEST) ? CARD_DECK_CHEST : -1;
+    if (deck >= 0 && rec->card >= 0 && rec->card < env->deck_sizes[deck]) {
+        strncpy(out->card_drawn, env->decks[deck][rec->card].name, sizeof(out->card_drawn) - 1);
+        strncpy(out->card_specific_desc, env->decks[deck][rec->card].desc, sizeof(out->card_specific_desc) - 1);
+    }
 }
 
-// Function to update Q-table from parallel episodes
-void update_q_table_from_cuda_episodes(MonteCarloAgent* agent, CUDAEpisodeData* episodes, int num_episodes) {
-    for (int ep = 0; ep < num_episodes; ep++) {
-        CUDAEpisodeData* episode = &episodes[ep];
+// --- Training Log Sink ---
+
+#define LOG_CSV_HEADER "episode_id,step,player,position_before,dice_roll,landed_on_position,position_after,money_before,money_after,reward,done,in_jail,fee_paid,agent_action,num_owned_properties,card_drawn,card_specific_desc,action_desc\n"
+#define LOG_SINK_BUFFER_BYTES (8 << 20) // stdio buffer of the log file, flushed only when full or on close
+#define LOG_BIN_MAGIC "MPLOGGPU"
+#define LOG_BIN_VERSION 2
 
-        // Create a temporary episode history
-        EpisodeHistory history;
-        init_episode_history(&history, episode->count);
+// off: no log (event-free kernel); csv: the original row format; bin: raw StepRecords, convert with --convert-log
+typedef enum { LOG_MODE_OFF, LOG_MODE_CSV, LOG_MODE_BIN } LogMode;
+
+// Header at the start of a binary log. It is followed by one block per episode:
+// int episode_id, int step_count, then step_count StepRecords exactly as the kernel wrote them.
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int record_size; // sizeof(StepRecord) of the writer
+} LogBinHeader;
 
-        // Copy steps from CUDA episode data
+// Where (and whether) step logs go
+typedef struct {
+    LogMode mode;
+    int sample_every; // Keep episodes whose id is a multiple of this (1 = every episode)
+    FILE* fp;
+    char* buffer;     // setvbuf buffer owned by the sink
+} LogSink;
+
+// Does the sink record this episode?
+static bool log_sink_wants(const LogSink* sink, int episode_id) {
+    return sink->mode != LOG_MODE_OFF && episode_id % sink->sample_every == 0;
+}
+
+// Open the log file and write its header (no-op for LOG_MODE_OFF)
+static bool log_sink_open(LogSink* sink, const char* filename) {
+    if (sink->mode == LOG_MODE_OFF) return true;
+    sink->fp = fopen(filename, sink->mode == LOG_MODE_BIN ? "wb" : "w");
+    if (!sink->fp) return false;
+    sink->buffer = (char*)malloc(LOG_SINK_BUFFER_BYTES);
+    if (sink->buffer) setvbuf(sink->fp, sink->buffer, _IOFBF, LOG_SINK_BUFFER_BYTES);
+
+    if (sink->mode == LOG_MODE_BIN) {
+        LogBinHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, LOG_BIN_MAGIC, sizeof(header.magic));
+        header.version = LOG_BIN_VERSION;
+        header.record_size = sizeof(StepRecord);
+        fwrite(&header, sizeof(header), 1, sink->fp);
+    } else {
+        fputs(LOG_CSV_HEADER, sink->fp);
+    }
+    return true;
+}
+
+// Close the log file; returns the fclose result (0 when there was nothing to close)
+static int log_sink_close(LogSink* sink) {
+    int result = 0;
+    if (sink->fp) result = fclose(sink->fp);
+    free(sink->buffer);
+    sink->fp = NULL;
+    sink->buffer = NULL;
+    return result;
+}
+
+// Append one episode in the sink's format (CSV rows are decoded on the host, binary is the raw records)
+static void log_sink_write_episode(LogSink* sink, const CUDAEpisodeData* episode, const MonopolyEnv* env) {
+    if (sink->mode == LOG_MODE_CSV) {
+        for (int j = 0; j < episode->count; j++) {
+            LogEntry log_entry;
+            decode_step_record(&episode->records[j], episode->episode_id, j, env, &log_entry);
+            write_log_to_csv(sink->fp, &log_entry);
+        }
+    } else if (sink->mode == LOG_MODE_BIN) {
+        fwrite(&episode->episode_id, sizeof(int), 1, sink->fp);
+        fwrite(&episode->count, sizeof(int), 1, sink->fp);
+        fwrite(episode->records, sizeof(StepRecord), episode->count, sink->fp);
+    }
+}
+
+// Offline converter: binary log -> the CSV schema write_log_to_csv produces
+static int convert_binary_log(const char* in_path, const char* out_path, const MonopolyEnv* env) {
+    FILE* in = fopen(in_path, "rb");
+    if (!in) {
+        fprintf(stderr, "Error: Could not open binary log '%s': %s\n", in_path, strerror(errno));
+        return 1;
+    }
+    LogBinHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, LOG_BIN_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != LOG_BIN_VERSION || header.record_size != sizeof(StepRecord)) {
+        fprintf(stderr, "Error: '%s' is not a CUDA-engine binary log (version %d).\n", in_path, LOG_BIN_VERSION);
+        fclose(in);
+        return 1;
+    }
+
+    LogSink out_sink = {LOG_MODE_CSV, 1, NULL, NULL};
+    if (!log_sink_open(&out_sink, out_path)) {
+        fprintf(stderr, "Error: Could not open CSV file '%s' for writing: %s\n", out_path, strerror(errno));
+        fclose(in);
+        return 1;
+    }
+
+    int status = 0;
+    long long rows = 0;
+    int episode_header[2];
+    while (fread(episode_header, sizeof(int), 2, in) == 2) {
+        if (episode_header[1] < 0 || episode_header[1] > MAX_EPISODE_STEPS) {
+            fprintf(stderr, "Error: Corrupt step count %d in episode %d of '%s'.\n", episode_header[1], episode_header[0], in_path);
+            status = 1;
+            break;
+        }
+        for (int j = 0; j < episode_header[1]; j++) {
+            StepRecord rec;
+            if (fread(&rec, sizeof(rec), 1, in) != 1) {
+                fprintf(stderr, "Error: Truncated binary log '%s' in episode %d.\n", in_path, episode_header[0]);
+                status = 1;
+                break;
+            }
+            LogEntry log_entry;
+            decode_step_record(&rec, episode_header[0], j, env, &log_entry);
+            write_log_to_csv(out_sink.fp, &log_entry);
+            rows++;
+        }
+        if (status != 0) break;
+    }
+
+    fclose(in);
+    if (log_sink_close(&out_sink) != 0) status = 1;
+    printf("Converted %lld log rows from '%s' to '%s'.\n", rows, in_path, out_path);
+    return status;
+}
+
+// Host update state kept for the whole run: the shared return accumulator and one episode arena
+// per update thread, so the per-batch host update allocates nothing
+typedef struct {
+    ConcurrentQTable* returns;
+    EpisodeArena* arenas[MAX_HOST_UPDATE_THREADS];
+    int num_threads;
+} HostUpdatePool;
+
+// Free the accumulator and every arena
+static void destroy_host_update_pool(HostUpdatePool* pool) {
+    if (!pool) return;
+    destroy_concurrent_q_table(pool->returns);
+    for (int t = 0; t < pool->num_threads; ++t) destroy_episode_arena(pool->arenas[t]);
+    free(pool);
+}
+
+// Create the accumulator and num_threads arenas (NULL if any allocation fails)
+static HostUpdatePool* create_host_update_pool(int num_threads, int num_players) {
+    HostUpdatePool* pool = (HostUpdatePool*)calloc(1, sizeof(HostUpdatePool));
+    if (!pool) return NULL;
+    pool->num_threads = num_threads;
+    bool ok = (pool->returns = create_concurrent_q_table()) != NULL;
+    for (int t = 0; ok && t < num_threads; ++t) {
+        ok = (pool->arenas[t] = create_episode_arena(num_players)) != NULL;
+    }
+    if (!ok) {
+        destroy_host_update_pool(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+// A contiguous slice of the batch for one host update thread
+typedef struct {
+    ConcurrentQTable* returns;
+    EpisodeArena* arena;
+    const CUDAEpisodeData* episodes;
+    int begin;
+    int end;
+} HostUpdateTask;
+
+// Thread entry: first-visit MC over episodes [begin, end) into the shared concurrent table
+static void* host_update_worker(void* arg) {
+    HostUpdateTask* task = (HostUpdateTask*)arg;
+    for (int ep = task->begin; ep < task->end; ep++) {
+        const CUDAEpisodeData* episode = &task->episodes[ep];
+
+        // Episode history backed by this thread's arena
+        EpisodeHistory history = episode_arena_history(task->arena);
+
+        // Rebuild (state, action, reward) steps from the packed records
         for (int i = 0; i < episode->count; i++) {
-            add_episode_step(&history, episode->steps[i].state, episode->steps[i].action, episode->steps[i].reward);
+            const StepRecord* rec = &episode->records[i];
+            add_episode_step(&history, step_record_state(rec), rec->action, rec->reward);
+        }
+
+        update_mc_concurrent(task->returns, &history, task->arena);
+    }
+    return NULL;
+}
+
+// Function to update Q-table from parallel episodes
+// The batch is split across the pool's threads, which accumulate into pool->returns; that is then drained into the agent.
+void update_q_table_from_cuda_episodes(MonteCarloAgent* agent, CUDAEpisodeData* episodes, int num_episodes,
+                                       HostUpdatePool* pool) {
+    HostUpdateTask tasks[MAX_HOST_UPDATE_THREADS];
+    pthread_t threads[MAX_HOST_UPDATE_THREADS];
+    bool launched[MAX_HOST_UPDATE_THREADS];
+
+    int num_threads = pool->num_threads;
+    if (num_threads > num_episodes) num_threads = num_episodes > 0 ? num_episodes : 1;
+    int begin = 0;
+    for (int t = 0; t < num_threads; ++t) {
+        int n = num_episodes / num_threads + (t < num_episodes % num_threads ? 1 : 0);
+        tasks[t].returns = pool->returns;
+        tasks[t].arena = pool->arenas[t];
+        tasks[t].episodes = episodes;
+        tasks[t].begin = begin;
+        tasks[t].end = begin + n;
+        begin += n;
+
+        // Slice 0 runs on the calling thread; a failed thread start falls back to the same
+        launched[t] = t > 0 && pthread_create(&threads[t], NULL, host_update_worker, &tasks[t]) == 0;
+    }
+    host_update_worker(&tasks[0]);
+    for (int t = 1; t < num_threads; ++t) {
+        if (launched[t]) {
+            pthread_join(threads[t], NULL);
+        } else {
+            host_update_worker(&tasks[t]);
         }
+    }
+
+    if (!cq_drain_into(pool->returns, agent->q_table)) {
+        fprintf(stderr, "Warning: Failed to merge some Q-table updates into the agent.\n");
+    }
+}
+
+// Fold the per-(state, action) sums and counts produced by mc_update_kernel into the agent's Q-table
+static void merge_device_q_deltas(MonteCarloAgent* agent, const double* q_sum, const double* q_sum_sq,
+                                  const unsigned int* q_count) {
+    for (int idx = 0; idx < Q_NUM_STATES * 2; ++idx) {
+        if (q_count[idx] == 0) continue;
+        QTableEntry* entry = find_or_create_q_entry(agent->q_table, state_tuple_from_index(idx / 2));
+        QValueData* value = &entry->values[idx % 2];
+        value->sum_returns += q_sum[idx];
+        value->sum_sq_returns += q_sum_sq[idx];
+        value->count += (int)q_count[idx];
+        value->q_value = value->sum_returns / value->count;
+    }
+}
+
+// Fold a batch's device deltas, one Q_DELTA_SLOTS slice per config, into each config's agent and totals
+static void merge_sweep_deltas(MonteCarloAgent** agents, SweepResult* results, int num_configs,
+                               const double* q_sum, const double* q_sum_sq, const unsigned int* q_count) {
+    for (int c = 0; c < num_configs; ++c) {
+        size_t slice = (size_t)c * Q_DELTA_SLOTS;
+        merge_device_q_deltas(agents[c], q_sum + slice, q_sum_sq + slice, q_count + slice);
+        results[c].return_sum += q_sum[slice + Q_NUM_STATES * 2];
+        results[c].return_sum_sq += q_sum_sq[slice + Q_NUM_STATES * 2];
+        results[c].episodes += q_count[slice + Q_NUM_STATES * 2];
+    }
+}
+
+// Add one batch's device deltas (`slots` entries) to the deltas pending for the next multi-node sync
+static void accumulate_q_deltas(double* pending_sum, double* pending_sum_sq, unsigned int* pending_count,
+                                const double* q_sum, const double* q_sum_sq, const unsigned int* q_count, size_t slots) {
+    for (size_t idx = 0; idx < slots; ++idx) {
+        if (q_count[idx] == 0) continue;
+        pending_sum[idx] += q_sum[idx];
+        pending_sum_sq[idx] += q_sum_sq[idx];
+        pending_count[idx] += q_count[idx];
+    }
+}
+
+// Multi-node sync: sum the pending deltas of every rank and merge the totals into the local agents, so
+// all ranks launch their next batches under the policies learned from everyone's episodes.
+// Every rank must call this the same number of times. Without MONOPOLY_USE_MPI there is one rank.
+static void allreduce_q_deltas(MonteCarloAgent** agents, SweepResult* results, int num_configs,
+                               double* pending_sum, double* pending_sum_sq, unsigned int* pending_count) {
+    size_t slots = (size_t)num_configs * Q_DELTA_SLOTS;
+#ifdef MONOPOLY_USE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, pending_sum, (int)slots, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, pending_sum_sq, (int)slots, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, pending_count, (int)slots, MPI_UNSIGNED, MPI_SUM, MPI_COMM_WORLD);
+#endif
+    merge_sweep_deltas(agents, results, num_configs, pending_sum, pending_sum_sq, pending_count);
+    memset(pending_sum, 0, slots * sizeof(double));
+    memset(pending_sum_sq, 0, slots * sizeof(double));
+    memset(pending_count, 0, slots * sizeof(unsigned int));
+}
+
+// Allocate the SoA batch state for `lanes` threads as one contiguous device allocation
+static cudaError_t alloc_batch_state(CUDABatchState* bs, int lanes) {
+    size_t slots = (size_t)MAX_PLAYERS * lanes;
+    void* base = NULL;
+    cudaError_t status = cudaMalloc(&base, (size_t)lanes * CUDA_BATCH_STATE_BYTES_PER_LANE);
+    if (status != cudaSuccess) return status;
+
+    // Carve the arrays out widest-first so every array stays naturally aligned
+    char* cursor = (char*)base;
+    bs->stride = lanes;
+    bs->owned_masks = (unsigned long long*)cursor; cursor += slots * sizeof(unsigned long long);
+    bs->positions = (int*)cursor;                  cursor += slots * sizeof(int);
+    bs->money = (int*)cursor;                      cursor += slots * sizeof(int);
+    bs->in_jail = (unsigned char*)cursor;          cursor += slots * sizeof(unsigned char);
+    bs->jail_counters = (unsigned char*)cursor;    cursor += slots * sizeof(unsigned char);
+    bs->houses = (unsigned char*)cursor;
+    return cudaSuccess;
+}
+
+// Free the SoA batch state (owned_masks is the base of the allocation)
+static void free_batch_state(CUDABatchState* bs) {
+    cudaFree(bs->owned_masks);
+    memset(bs, 0, sizeof(CUDABatchState));
+}
+
+// Buffers for one in-flight batch of the training pipeline
+typedef struct {
+    int device;                       // GPU this slot's stream and buffers live on
+    int threads_per_block;            // Launch shape planned for that device
+    int lane_blocks;
+    cudaStream_t stream;
+    CUDABatchState d_batch_state;
+    CUDAEpisodeData* d_episode_data;
+    CUDAEpisodeData* h_episode_data;  // Pinned; NULL when neither the log nor the host update reads episodes
+    unsigned char* d_greedy_actions;  // One Q_NUM_STATES policy table per config
+    unsigned char* h_greedy_actions;  // Pinned staging copy of the policies this batch was launched with
+    double* d_q_sum;                  // mc_update_kernel accumulators, one Q_DELTA_SLOTS slice per config
+    double* d_q_sum_sq;
+    unsigned int* d_q_count;
+    double* h_q_sum;                  // Pinned
+    double* h_q_sum_sq;               // Pinned
+    unsigned int* h_q_count;          // Pinned
+    unsigned int* d_work_counter;     // Next unclaimed episode of the batch (persistent lanes)
+    unsigned long long* d_step_counter; // Steps the batch's episodes took
+    unsigned long long* h_step_counter; // Pinned
+    KernelCounters* d_block_counters; // Per-block hot-path counters (lane_blocks); NULL unless --metrics
+    KernelCounters* h_block_counters; // Pinned
+    cudaEvent_t ev_start;             // Batch timeline: policy upload, simulation kernel, device update, copies back
+    cudaEvent_t ev_uploaded;
+    cudaEvent_t ev_simulated;
+    cudaEvent_t ev_updated;
+    cudaEvent_t ev_done;
+    int batch_offset;
+    int batch_size;
+    int batch_blocks;                 // Blocks the current batch was launched with
+} BatchSlot;
+
+// Device bytes one BatchSlot holds for `lanes` persistent lanes, batches of up to `max_episodes` and
+// `num_configs` policies (the per-block metrics counters are bounded by one per lane)
+static size_t batch_slot_device_bytes(int lanes, int max_episodes, int num_configs) {
+    return (size_t)lanes * CUDA_BATCH_STATE_BYTES_PER_LANE + (size_t)max_episodes * sizeof(CUDAEpisodeData)
+         + (size_t)num_configs * (Q_NUM_STATES + (size_t)Q_DELTA_SLOTS * (2 * sizeof(double) + sizeof(unsigned int)))
+         + sizeof(unsigned int) + sizeof(unsigned long long) + (size_t)lanes * sizeof(KernelCounters);
+}
+
+// Copy env's board, dice transition and card effect tables to the constant memory of the current device
+static cudaError_t upload_constant_tables(const MonopolyEnv* env) {
+    int prices[BOARD_SIZE], rents[BOARD_SIZE], house_costs[BOARD_SIZE];
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        prices[i] = env->properties[i].price;
+        rents[i] = env->properties[i].rent;
+        house_costs[i] = env->properties[i].house_cost;
+    }
+    CardEffect effects[NUM_CARD_DECKS][MAX_DECK_SIZE];
+    memset(effects, 0, sizeof(effects));
+    for (int d = 0; d < NUM_CARD_DECKS; d++) {
+        for (int i = 0; i < env->deck_sizes[d]; i++) effects[d][i] = env->decks[d][i].effect;
+    }
+    cudaError_t status;
+    if ((status = cudaMemcpyToSymbol(c_property_prices, prices, sizeof(prices))) != cudaSuccess) return status;
+    if ((status = cudaMemcpyToSymbol(c_property_rents, rents, sizeof(rents))) != cudaSuccess) return status;
+    if ((status = cudaMemcpyToSymbol(c_property_house_costs, house_costs, sizeof(house_costs))) != cudaSuccess) return status;
+    if ((status = cudaMemcpyToSymbol(c_card_effects, effects, sizeof(effects))) != cudaSuccess) return status;
+    if ((status = cudaMemcpyToSymbol(c_dice_transitions, env->transitions, sizeof(env->transitions))) != cudaSuccess) return status;
+    return cudaMemcpyToSymbol(c_deck_sizes, env->deck_sizes, sizeof(env->deck_sizes));
+}
+
+// Copy the run's configs to the constant memory of the current device
+static cudaError_t upload_sweep_configs(const SweepConfig* configs, int num_configs) {
+    return cudaMemcpyToSymbol(c_sweep_configs, configs, (size_t)num_configs * sizeof(SweepConfig));
+}
 
-        // Update Q-table using the episode
-        update_mc(agent, &history);
+// Allocate a slot on `device` (stream, device buffers, pinned host buffers) for `num_configs` policies and
+// upload env's constant tables and the configs
+static cudaError_t create_batch_slot(BatchSlot* slot, int device, int threads_per_block, int lane_blocks,
+                                     int max_episodes, bool need_host_episodes, bool metrics, const MonopolyEnv* env,
+                                     const SweepConfig* configs, int num_configs) {
+    int lanes = lane_blocks * threads_per_block;
+    size_t q_delta_slots = (size_t)num_configs * Q_DELTA_SLOTS;
+    size_t policy_bytes = (size_t)num_configs * Q_NUM_STATES;
+    cudaError_t status;
+    memset(slot, 0, sizeof(*slot));
+    slot->device = device;
+    slot->threads_per_block = threads_per_block;
+    slot->lane_blocks = lane_blocks;
+
+    if ((status = cudaSetDevice(device)) != cudaSuccess) return status;
+    if ((status = upload_constant_tables(env)) != cudaSuccess) return status;
+    if ((status = upload_sweep_configs(configs, num_configs)) != cudaSuccess) return status;
+    if ((status = cudaStreamCreate(&slot->stream)) != cudaSuccess) return status;
+    if ((status = alloc_batch_state(&slot->d_batch_state, lanes)) != cudaSuccess) return status;
+    if ((status = cudaMalloc((void**)&slot->d_episode_data, max_episodes * sizeof(CUDAEpisodeData))) != cudaSuccess) return status;
+    if ((status = cudaMalloc((void**)&slot->d_work_counter, sizeof(unsigned int))) != cudaSuccess) return status;
+    if ((status = cudaMalloc((void**)&slot->d_step_counter, sizeof(unsigned long long))) != cudaSuccess) return status;
+    if ((status = cudaMallocHost((void**)&slot->h_step_counter, sizeof(unsigned long long))) != cudaSuccess) return status;
+    if (metrics) {
+        if ((status = cudaMalloc((void**)&slot->d_block_counters, lane_blocks * sizeof(KernelCounters))) != cudaSuccess) return status;
+        if ((status = cudaMallocHost((void**)&slot->h_block_counters, lane_blocks * sizeof(KernelCounters))) != cudaSuccess) return status;
+    }
+    cudaEvent_t* events[] = {&slot->ev_start, &slot->ev_uploaded, &slot->ev_simulated, &slot->ev_updated, &slot->ev_done};
+    for (int e = 0; e < 5; e++) {
+        if ((status = cudaEventCreate(events[e])) != cudaSuccess) return status;
+    }
+    if ((status = cudaMalloc((void**)&slot->d_greedy_actions, policy_bytes)) != cudaSuccess) return status;
+    if ((status = cudaMallocHost((void**)&slot->h_greedy_actions, policy_bytes)) != cudaSuccess) return status;
+    if ((status = cudaMalloc((void**)&slot->d_q_sum, q_delta_slots * sizeof(double))) != cudaSuccess) return status;
+    if ((status = cudaMalloc((void**)&slot->d_q_sum_sq, q_delta_slots * sizeof(double))) != cudaSuccess) return status;
+    if ((status = cudaMalloc((void**)&slot->d_q_count, q_delta_slots * sizeof(unsigned int))) != cudaSuccess) return status;
+    if ((status = cudaMallocHost((void**)&slot->h_q_sum, q_delta_slots * sizeof(double))) != cudaSuccess) return status;
+    if ((status = cudaMallocHost((void**)&slot->h_q_sum_sq, q_delta_slots * sizeof(double))) != cudaSuccess) return status;
+    if ((status = cudaMallocHost((void**)&slot->h_q_count, q_delta_slots * sizeof(unsigned int))) != cudaSuccess) return status;
+    if (need_host_episodes &&
+        (status = cudaMallocHost((void**)&slot->h_episode_data, max_episodes * sizeof(CUDAEpisodeData))) != cudaSuccess) return status;
+
+    cudaMemsetAsync(slot->d_q_sum, 0, q_delta_slots * sizeof(double), slot->stream);
+    cudaMemsetAsync(slot->d_q_sum_sq, 0, q_delta_slots * sizeof(double), slot->stream);
+    cudaMemsetAsync(slot->d_q_count, 0, q_delta_slots * sizeof(unsigned int), slot->stream);
+    return cudaGetLastError();
+}
 
-        // Free the temporary history
-        free_episode_history(&history);
+// Release everything create_batch_slot allocated (safe on a partially created slot)
+static void destroy_batch_slot(BatchSlot* slot) {
+    cudaSetDevice(slot->device);
+    if (slot->stream) cudaStreamSynchronize(slot->stream);
+    cudaFreeHost(slot->h_episode_data);
+    cudaFreeHost(slot->h_q_count);
+    cudaFreeHost(slot->h_q_sum_sq);
+    cudaFreeHost(slot->h_q_sum);
+    cudaFree(slot->d_q_count);
+    cudaFree(slot->d_q_sum_sq);
+    cudaFree(slot->d_q_sum);
+    cudaFreeHost(slot->h_greedy_actions);
+    cudaFree(slot->d_greedy_actions);
+    cudaEvent_t events[] = {slot->ev_start, slot->ev_uploaded, slot->ev_simulated, slot->ev_updated, slot->ev_done};
+    for (int e = 0; e < 5; e++) {
+        if (events[e]) cudaEventDestroy(events[e]);
     }
+    cudaFreeHost(slot->h_block_counters);
+    cudaFree(slot->d_block_counters);
+    cudaFreeHost(slot->h_step_counter);
+    cudaFree(slot->d_step_counter);
+    cudaFree(slot->d_work_counter);
+    cudaFree(slot->d_episode_data);
+    free_batch_state(&slot->d_batch_state);
+    if (slot->stream) cudaStreamDestroy(slot->stream);
+    memset(slot, 0, sizeof(*slot));
 }
 
-void report_occupancy() {
+// Launch shape and batch size derived from the device
+typedef struct {
+    int threads_per_block;
+    int lane_blocks;        // Blocks launched per batch
+    int episodes_per_batch; // 0 if not even one lane's worth fits in memory
+} LaunchPlan;
+
+// Threads per block come from the occupancy calculator and, with persistent lanes, the grid is the
+// number of blocks resident at once. The batch defaults to EPISODES_PER_LANE episodes per lane (or
+// requested_batch) and is clamped so that num_slots batches fit in the free device memory and, when
+// episodes are copied back, in pinned host memory. Nothing here is a compile-time limit.
+static LaunchPlan plan_launch(int device, int num_episodes, int num_slots, bool persistent, SimulateKernel kernel,
+                              bool need_host_episodes, int requested_batch, int num_configs) {
+    LaunchPlan plan = {THREADS_PER_BLOCK, 1, 0};
     cudaDeviceProp prop;
-    cudaGetDeviceProperties(&prop, 0); // Use device 0
+    cudaSetDevice(device);
+    cudaGetDeviceProperties(&prop, device);
+
+    int min_grid_size = 0, block_size = 0;
+    cudaOccupancyMaxPotentialBlockSize(&min_grid_size, &block_size, kernel, 0, 0);
+    if (block_size > 0) plan.threads_per_block = block_size;
+    long long resident_lanes = (long long)(min_grid_size > 0 ? min_grid_size : prop.multiProcessorCount) * plan.threads_per_block;
+
+    // Episodes that fit: each slot gets an equal share of the budget after its fixed buffers
+    size_t free_mem = 0, total_mem = 0;
+    cudaMemGetInfo(&free_mem, &total_mem);
+    size_t device_share = free_mem / 100 * DEVICE_MEMORY_BUDGET_PERCENT / num_slots;
+    size_t fixed_bytes = batch_slot_device_bytes((int)resident_lanes, 0, num_configs);
+    long long fit = device_share > fixed_bytes ? (long long)((device_share - fixed_bytes) / sizeof(CUDAEpisodeData)) : 0;
+    if (need_host_episodes) {
+        size_t host_mem = (size_t)sysconf(_SC_PHYS_PAGES) * (size_t)sysconf(_SC_PAGE_SIZE);
+        long long host_fit = (long long)(host_mem / 100 * HOST_MEMORY_BUDGET_PERCENT / num_slots / sizeof(CUDAEpisodeData));
+        if (host_fit < fit) fit = host_fit;
+    }
+
+    long long episodes = requested_batch > 0 ? requested_batch : resident_lanes * EPISODES_PER_LANE;
+    if (episodes > fit) {
+        if (requested_batch > 0) {
+            fprintf(stderr, "Warning: Batch of %d episodes does not fit in memory. Using %lld.\n", requested_batch, fit);
+        }
+        episodes = fit;
+    }
+    if (episodes > num_episodes) episodes = num_episodes;
+    if (episodes <= 0) return plan;
+    plan.episodes_per_batch = (int)episodes;
+
+    // One lane per episode without persistent lanes, otherwise no more lanes than are resident
+    long long lanes = persistent && resident_lanes < episodes ? resident_lanes : episodes;
+    long long blocks = (lanes + plan.threads_per_block - 1) / plan.threads_per_block;
+    if (prop.maxGridSize[0] > 0 && blocks > prop.maxGridSize[0]) blocks = prop.maxGridSize[0];
+    plan.lane_blocks = (int)blocks;
+    return plan;
+}
+
+void report_occupancy(int device, SimulateKernel kernel) {
+    cudaDeviceProp prop;
+    cudaSetDevice(device);
+    cudaGetDeviceProperties(&prop, device);
+    printf("Device %d: %s\n", device, prop.name);
 
     int minGridSize, blockSize;
     size_t dynamicSMemPerBlock = 0;
@@ -1901,7 +3258,7 @@ void report_occupancy() {
     cudaOccupancyMaxPotentialBlockSize(
         &minGridSize,
         &blockSize,
-        simulate_episodes_kernel,
+        kernel, // The run's training kernel (the hot path)
         dynamicSMemPerBlock,
         0
     );
@@ -1909,7 +3266,7 @@ void report_occupancy() {
     float occupancy;
     cudaOccupancyMaxActiveBlocksPerMultiprocessor(
         &minGridSize,
-        simulate_episodes_kernel,
+        kernel,
         blockSize,
         dynamicSMemPerBlock
     );
@@ -1918,10 +3275,269 @@ void report_occupancy() {
     int maxWarpsPerSM = prop.maxThreadsPerMultiProcessor / prop.warpSize;
     occupancy = (float)minGridSize * numWarpsPerBlock / maxWarpsPerSM;
 
+    // Per-thread resource usage: local memory here means register spills
+    cudaFuncAttributes attr;
+    cudaFuncGetAttributes(&attr, kernel);
+
+    printf("Registers per thread: %d\n", attr.numRegs);
+    printf("Local memory per thread: %zu bytes\n", attr.localSizeBytes);
     printf("Recommended Block Size: %d\n", blockSize);
     printf("Max Active Blocks per SM: %d\n", minGridSize);
     printf("Occupancy: %.2f%%\n", occupancy * 100.0f);
 }
+// --- Run Statistics ---
+
+// Monotonic wall-clock time in milliseconds
+static double wall_clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1.0e6;
+}
+
+// Work done by a training run and where its time went. GPU phases come from each batch's events and
+// add up over batches, so with several slots or GPUs in flight they can exceed the wall time.
+typedef struct {
+    long long episodes;
+    long long steps;
+    double simulate_ms; // simulate_episodes_kernel
+    double copy_ms;     // Policy upload and the copies back
+    double update_ms;   // mc_update_kernel plus the host-side merge, host update or all-reduce
+    double log_ms;      // Formatting and writing the step log
+} RunStats;
+
+// Add a finished batch's GPU timeline (events recorded on its stream) to the run's statistics
+static void add_batch_timing(RunStats* stats, const BatchSlot* slot) {
+    float upload_ms = 0.0f, simulate_ms = 0.0f, update_ms = 0.0f, copy_ms = 0.0f;
+    cudaEventElapsedTime(&upload_ms, slot->ev_start, slot->ev_uploaded);
+    cudaEventElapsedTime(&simulate_ms, slot->ev_uploaded, slot->ev_simulated);
+    cudaEventElapsedTime(&update_ms, slot->ev_simulated, slot->ev_updated);
+    cudaEventElapsedTime(&copy_ms, slot->ev_updated, slot->ev_done);
+    stats->episodes += slot->batch_size;
+    stats->steps += (long long)*slot->h_step_counter;
+    stats->simulate_ms += simulate_ms;
+    stats->update_ms += update_ms;
+    stats->copy_ms += upload_ms + copy_ms;
+}
+
+// Fold one batch's statistics into the run's
+static void add_run_stats(RunStats* total, const RunStats* batch) {
+    total->episodes += batch->episodes;
+    total->steps += batch->steps;
+    total->simulate_ms += batch->simulate_ms;
+    total->copy_ms += batch->copy_ms;
+    total->update_ms += batch->update_ms;
+    total->log_ms += batch->log_ms;
+}
+
+// --metrics output: a per-batch line on stdout and, with --metrics=FILE, one CSV row per batch
+typedef struct {
+    bool enabled;
+    FILE* file; // NULL when only the stdout report was asked for
+} MetricsReport;
+
+// Open the optional dump; a file that cannot be opened only loses the dump, not the run
+static void metrics_report_open(MetricsReport* report, const char* path) {
+    if (!report->enabled || !path) return;
+    report->file = fopen(path, "w");
+    if (!report->file) {
+        fprintf(stderr, "Warning: Could not open metrics file '%s': %s. Reporting to stdout only.\n", path, strerror(errno));
+        return;
+    }
+    fprintf(report->file, "batch,gpu,episodes,kernel_ms,copy_ms,update_ms,log_ms,steps,card_draws,jail_turns,"
+                          "bankruptcies,divergent,block_steps_min,block_steps_max\n");
+}
+
+static void metrics_report_close(MetricsReport* report) {
+    if (report->file && fclose(report->file) != 0) {
+        fprintf(stderr, "Warning: Error closing metrics file: %s\n", strerror(errno));
+    }
+    report->file = NULL;
+}
+
+// Report a finished batch: its phase timings plus the kernel's per-block counters summed over the blocks
+// it launched (the min/max block step counts show how evenly the persistent lanes shared the work)
+static void report_batch_metrics(MetricsReport* report, int batch, const BatchSlot* slot, const RunStats* batch_stats) {
+    if (!report->enabled) return;
+    KernelCounters sum;
+    memset(&sum, 0, sizeof(sum));
+    unsigned long long block_min = 0, block_max = 0;
+    for (int b = 0; b < slot->batch_blocks; b++) {
+        const KernelCounters* c = &slot->h_block_counters[b];
+        sum.steps += c->steps;
+        sum.card_draws += c->card_draws;
+        sum.jail_turns += c->jail_turns;
+        sum.bankruptcies += c->bankruptcies;
+        sum.divergent_branches += c->divergent_branches;
+        if (b == 0 || c->steps < block_min) block_min = c->steps;
+        if (b == 0 || c->steps > block_max) block_max = c->steps;
+    }
+    printf("  Metrics: kernel %.2f ms, copy %.2f ms, update %.2f ms, log %.2f ms | %llu steps, %u card draws, "
+           "%u jail turns, %u bankruptcies, %u divergent branches | block steps %llu-%llu\n",
+           batch_stats->simulate_ms, batch_stats->copy_ms, batch_stats->update_ms, batch_stats->log_ms,
+           sum.steps, sum.card_draws, sum.jail_turns, sum.bankruptcies, sum.divergent_branches, block_min, block_max);
+    if (report->file) {
+        fprintf(report->file, "%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%llu,%u,%u,%u,%u,%llu,%llu\n",
+                batch, slot->device, slot->batch_size, batch_stats->simulate_ms, batch_stats->copy_ms,
+                batch_stats->update_ms, batch_stats->log_ms, sum.steps, sum.card_draws, sum.jail_turns,
+                sum.bankruptcies, sum.divergent_branches, block_min, block_max);
+    }
+}
+
+// Peak resident set size of the process in kilobytes (Linux reports ru_maxrss in KB)
+static long peak_host_memory_kb(void) {
+    struct rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+}
+
+// Device memory in use on the busiest of the given GPUs, in kilobytes (all buffers are allocated up front)
+static long peak_device_memory_kb(const int* devices, int num_devices) {
+    long peak_kb = 0;
+    for (int g = 0; g < num_devices; g++) {
+        size_t free_bytes = 0, total_bytes = 0;
+        cudaSetDevice(devices[g]);
+        if (cudaMemGetInfo(&free_bytes, &total_bytes) != cudaSuccess) continue;
+        long used_kb = (long)((total_bytes - free_bytes) / 1024);
+        if (used_kb > peak_kb) peak_kb = used_kb;
+    }
+    return peak_kb;
+}
+
+// Print measured throughput and the phase breakdown; --benchmark adds one key=value line for tracking runs
+static void print_run_stats(int num_gpus, unsigned long long seed, const RunStats* stats, double elapsed_ms,
+                            long peak_device_kb, bool benchmark) {
+    double seconds = elapsed_ms / 1000.0;
+    long peak_host_kb = peak_host_memory_kb();
+    printf("\n--- Performance Metrics ---\n");
+    printf("GPU Training Time: %.2f milliseconds (%d GPU%s)\n", elapsed_ms, num_gpus, num_gpus == 1 ? "" : "s");
+    printf("Training throughput: %.2f episodes/second, %.0f steps/second\n", stats->episodes / seconds, stats->steps / seconds);
+    printf("Mean episode length: %.1f steps\n", stats->episodes > 0 ? (double)stats->steps / stats->episodes : 0.0);
+    printf("Time in kernel / copy / update / logging: %.2f / %.2f / %.2f / %.2f ms\n",
+           stats->simulate_ms, stats->copy_ms, stats->update_ms, stats->log_ms);
+    printf("Peak host memory: %.1f MB, peak device memory: %.1f MB\n", peak_host_kb / 1024.0, peak_device_kb / 1024.0);
+    printf("------------------------\n");
+    if (benchmark) {
+        printf("BENCHMARK engine=cuda gpus=%d seed=%llu episodes=%lld steps=%lld wall_ms=%.2f episodes_per_s=%.2f "
+               "steps_per_s=%.0f simulate_ms=%.2f copy_ms=%.2f update_ms=%.2f log_ms=%.2f peak_host_kb=%ld peak_device_kb=%ld\n",
+               num_gpus, seed, stats->episodes, stats->steps, elapsed_ms, stats->episodes / seconds, stats->steps / seconds,
+               stats->simulate_ms, stats->copy_ms, stats->update_ms, stats->log_ms, peak_host_kb, peak_device_kb);
+    }
+}
+
+// --- Hyperparameter Sweep ---
+
+// Parse --sweep=EPSILON:START_MONEY:GO_REWARD[,...] into configs. Returns the number of configs, or 0
+// after printing why the list is invalid.
+static int parse_sweep_configs(const char* spec, SweepConfig* configs) {
+    int num_configs = 0;
+    const char* cursor = spec;
+    for (;;) {
+        size_t length = strcspn(cursor, ",");
+        if (num_configs == MAX_SWEEP_CONFIGS) {
+            fprintf(stderr, "Error: --sweep lists more than %d configs.\n", MAX_SWEEP_CONFIGS);
+            return 0;
+        }
+        SweepConfig* config = &configs[num_configs];
+        char* end;
+        const char* field = cursor;
+        config->epsilon = strtod(field, &end);
+        bool ok = end != field && *end == ':' && config->epsilon >= 0.0 && config->epsilon <= 1.0;
+        long start_money = 0, go_reward = -1;
+        if (ok) {
+            field = end + 1;
+            start_money = strtol(field, &end, 10);
+            ok = end != field && *end == ':' && start_money > 0 && start_money <= INT_MAX;
+        }
+        if (ok) {
+            field = end + 1;
+            go_reward = strtol(field, &end, 10);
+            ok = end != field && end == cursor + length && go_reward >= 0 && go_reward <= INT_MAX;
+        }
+        if (!ok) {
+            fprintf(stderr, "Error: Invalid --sweep config '%.*s' (expected EPSILON:START_MONEY:GO_REWARD).\n",
+                    (int)length, cursor);
+            return 0;
+        }
+        config->start_money = (int)start_money;
+        config->go_reward = (int)go_reward;
+        num_configs++;
+        if (cursor[length] == '\0') return num_configs;
+        cursor += length + 1;
+    }
+}
+
+// Release the agents of every config (entries may be NULL)
+static void destroy_sweep_agents(MonteCarloAgent** agents, int num_configs) {
+    for (int c = 0; c < num_configs; c++) destroy_monte_carlo_agent(agents[c]);
+}
+
+// Per-config results of a sweep: how the config's episodes went and what its learned policy does; one
+// key=value line per config follows the readable one for scripts collecting a grid. The mean return's
+// standard error and the states whose buy/pass gap is significant say whether the grid point is settled.
+static void report_sweep_results(const SweepConfig* configs, MonteCarloAgent** agents, const SweepResult* results,
+                                 int num_configs) {
+    printf("\n--- Sweep Results ---\n");
+    for (int c = 0; c < num_configs; c++) {
+        int buy_states = 0, pass_states = 0;
+        const QTableEntry* entries = agents[c]->q_table->entries;
+        for (int idx = 0; idx < Q_NUM_STATES; ++idx) {
+            if (!entries[idx].used) continue;
+            double q_val_0 = entries[idx].values[0].q_value;
+            double q_val_1 = entries[idx].values[1].q_value;
+            if (fabs(q_val_0 - q_val_1) < 1e-9) continue;
+            if (q_val_1 > q_val_0) buy_states++; else pass_states++;
+        }
+        QValueData returns = {results[c].return_sum, results[c].return_sum_sq, (int)results[c].episodes, 0.0};
+        double mean_return = results[c].episodes > 0 ? results[c].return_sum / results[c].episodes : 0.0;
+        double return_se = q_value_std_error(&returns);
+        int compared = 0, separated = 0;
+        q_table_convergence(agents[c]->q_table, &compared, &separated);
+        printf("Config %d (epsilon %.3f, start money %d, GO reward %d): %lld episodes, mean return %.2f +/- %.2f, "
+               "Q-Table size %d, buy preferred in %d states, pass in %d, %d of %d separated at 95%%\n",
+               c + 1, configs[c].epsilon, configs[c].start_money, configs[c].go_reward, results[c].episodes,
+               mean_return, return_se, agents[c]->q_table->count, buy_states, pass_states, separated, compared);
+        printf("SWEEP config=%d epsilon=%g start_money=%d go_reward=%d episodes=%lld mean_return=%.4f return_se=%.4f "
+               "q_states=%d buy_states=%d pass_states=%d separated_states=%d compared_states=%d\n",
+               c + 1, configs[c].epsilon, configs[c].start_money, configs[c].go_reward, results[c].episodes,
+               mean_return, return_se, agents[c]->q_table->count, buy_states, pass_states, separated, compared);
+    }
+    printf("------------------------\n");
+}
+
+// Error exit from main: with MPI the other ranks would block forever in their next collective, so take
+// them down too
+static int exit_failure(void) {
+#ifdef MONOPOLY_USE_MPI
+    MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
+    return 1;
+}
+
+// --help text
+static void print_usage(const char* prog) {
+    printf("Usage: %s [num_episodes] [log_filename] [options]\n"
+           "       %s --convert-log=train.bin [csv_filename] [--deck=FILE]\n"
+           "Options:\n"
+           "  --seed=N                 Reproducible run (default: the current time)\n"
+           "  --log=off|csv|bin        Step log format (default csv); --log-every=N keeps every Nth episode\n"
+           "  --update=gpu|host        Q update on the device (default) or in host threads (--update-threads=N)\n"
+           "  --pipeline=N|off         Batches in flight per GPU, 1..%d (default %d; off = 1)\n"
+           "  --max-policy-lag=N       Launch at most N batches ahead of the last finished one (default: no cap)\n"
+           "  --batch=N                Episodes per batch (default: sized from device memory)\n"
+           "  --gpus=N|all             Shard batches over N visible GPUs (default 1)\n"
+           "  --persistent=on|off      Resident lanes pulling episodes (default on) or one lane per episode\n"
+           "  --sync-every=N           Batches between multi-node Q-statistic all-reduces (default 1)\n"
+           "  --checkpoint=FILE        Save progress every --checkpoint-every=N episodes (default %d); --resume=FILE\n"
+           "  --sweep=EPS:MONEY:GO,... Train several configurations side by side\n"
+           "  --deck=FILE              Replace the default Chance / Community Chest cards\n"
+           "  --metrics[=FILE]         Per-batch counters and timings\n"
+           "  --benchmark              Fixed-seed, unlogged workload with a machine-readable summary\n"
+           "Policy lag: batches are launched while earlier ones still run, and a batch plays the policy of the\n"
+           "batches finished before its launch. It can therefore miss up to pipeline x GPUs - 1 batches (%d with\n"
+           "the defaults on one GPU), plus sync-every - 1 batches per rank across nodes. --max-policy-lag=0 or\n"
+           "--pipeline=off on one GPU launches every batch with the latest policy, at the cost of the overlap.\n",
+           prog, prog, MAX_PIPELINE_SLOTS, DEFAULT_PIPELINE_SLOTS, CHECKPOINT_DEFAULT_EVERY, DEFAULT_PIPELINE_SLOTS - 1);
+}
+
 // --- Main Function ---
 int main(int argc, char *argv[]) {
     // --- Parameters ---
@@ -1931,225 +3547,639 @@ int main(int argc, char *argv[]) {
     int num_episodes = 20000; // Default number of episodes
     double epsilon = 0.1;
     const char* csv_filename = "monopoly_training_log_20000.csv";
+    LogSink log_sink = {LOG_MODE_CSV, 1, NULL, NULL}; // --log=off also switches to the event-free kernel
+    const char* convert_from = NULL; // --convert-log=FILE: convert a binary log to CSV and exit
+    unsigned long long seed = (unsigned long long)time(NULL); // --seed=N makes a run reproducible
     cudaEvent_t start, stop;
     float gpu_milliseconds = 0.0f;
+    int update_threads = 0; // Host threads for the Q update, 0 = one per online core
+    bool device_update = true; // --update=gpu runs mc_update_kernel, --update=host the threaded host pass
+    int num_slots = DEFAULT_PIPELINE_SLOTS; // --pipeline=N batches in flight, --pipeline=off runs them one at a time
+    int max_policy_lag = -1; // --max-policy-lag=N caps how many unfinished batches a launch may miss, -1 = num_slots * num_gpus - 1
+    bool persistent = true; // --persistent=off launches one lane per episode instead of resident lanes pulling work
+    int batch_episodes = 0; // --batch=N episodes per batch, 0 = sized from device memory
+    int num_gpus = 1; // --gpus=N shards batches over N visible GPUs, --gpus=all over every one
+    int sync_every = 1; // --sync-every=N batches between multi-node Q-statistic all-reduces
+    CheckpointConfig checkpoint = {NULL, CHECKPOINT_DEFAULT_EVERY, 0, {1, 0, 0}}; // --checkpoint=FILE saves progress periodically
+    const char* resume_path = NULL; // --resume=FILE continues a checkpointed run up to num_episodes
+    bool benchmark = false; // --benchmark: fixed-seed, unlogged workload with a machine-readable summary
+    bool seed_given = false, log_mode_given = false;
+    MetricsReport metrics = {false, NULL}; // --metrics prints per-batch counters and timings, --metrics=FILE also dumps CSV
+    const char* metrics_path = NULL;
+    const char* deck_path = NULL; // --deck=FILE replaces the default Chance / Community Chest cards
+    const char* sweep_spec = NULL; // --sweep=EPS:MONEY:GO,... trains every listed config in the same launches
+    SweepConfig sweep_configs[MAX_SWEEP_CONFIGS];
+    int num_configs = 1;
+    int mpi_rank = 0, mpi_size = 1;
+#ifdef MONOPOLY_USE_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
+#endif
     // --- Command Line Arguments (Optional) ---
-    if (argc > 1) {
-        num_episodes = atoi(argv[1]);
-        if (num_episodes <= 0) {
-            fprintf(stderr, "Warning: Invalid number of episodes specified. Using default %d.\n", 20000);
-            num_episodes = 20000;
+    // Positional: [num_episodes] [log_filename]; options start with "--"
+    // Converter: --convert-log=train.bin [csv_filename]
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--", 2) == 0) {
+            if (strcmp(argv[i], "--log=off") == 0) {
+                log_sink.mode = LOG_MODE_OFF;
+                log_mode_given = true;
+            } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+                seed = strtoull(argv[i] + 7, NULL, 10);
+                seed_given = true;
+            } else if (strcmp(argv[i], "--log=csv") == 0) {
+                log_sink.mode = LOG_MODE_CSV;
+                log_mode_given = true;
+            } else if (strcmp(argv[i], "--log=bin") == 0) {
+                log_sink.mode = LOG_MODE_BIN;
+                log_mode_given = true;
+            } else if (strncmp(argv[i], "--log-every=", 12) == 0) {
+                log_sink.sample_every = atoi(argv[i] + 12);
+                if (log_sink.sample_every <= 0) {
+                    fprintf(stderr, "Warning: Invalid log sampling interval '%s'. Logging every episode.\n", argv[i] + 12);
+                    log_sink.sample_every = 1;
+                }
+            } else if (strncmp(argv[i], "--convert-log=", 14) == 0) {
+                convert_from = argv[i] + 14;
+            } else if (strcmp(argv[i], "--update=gpu") == 0) {
+                device_update = true;
+            } else if (strcmp(argv[i], "--update=host") == 0) {
+                device_update = false;
+            } else if (strcmp(argv[i], "--pipeline=off") == 0) {
+                num_slots = 1;
+            } else if (strncmp(argv[i], "--pipeline=", 11) == 0) {
+                num_slots = atoi(argv[i] + 11);
+                if (num_slots < 1 || num_slots > MAX_PIPELINE_SLOTS) {
+                    fprintf(stderr, "Warning: Invalid pipeline depth '%s'. Using %d.\n", argv[i] + 11, DEFAULT_PIPELINE_SLOTS);
+                    num_slots = DEFAULT_PIPELINE_SLOTS;
+                }
+            } else if (strncmp(argv[i], "--max-policy-lag=", 17) == 0) {
+                max_policy_lag = atoi(argv[i] + 17);
+                if (max_policy_lag < 0) {
+                    fprintf(stderr, "Warning: Invalid policy lag '%s'. Not capping it.\n", argv[i] + 17);
+                    max_policy_lag = -1;
+                }
+            } else if (strcmp(argv[i], "--help") == 0) {
+                if (mpi_rank == 0) print_usage(argv[0]);
+#ifdef MONOPOLY_USE_MPI
+                MPI_Finalize();
+#endif
+                return 0;
+            } else if (strncmp(argv[i], "--batch=", 8) == 0) {
+                batch_episodes = atoi(argv[i] + 8);
+                if (batch_episodes < 0) {
+                    fprintf(stderr, "Warning: Invalid batch size '%s'. Sizing from device memory.\n", argv[i] + 8);
+                    batch_episodes = 0;
+                }
+            } else if (strcmp(argv[i], "--gpus=all") == 0) {
+                num_gpus = 0;
+            } else if (strncmp(argv[i], "--gpus=", 7) == 0) {
+                num_gpus = atoi(argv[i] + 7);
+                if (num_gpus < 1 || num_gpus > MAX_GPUS) {
+                    fprintf(stderr, "Warning: Invalid GPU count '%s'. Using 1.\n", argv[i] + 7);
+                    num_gpus = 1;
+                }
+            } else if (strncmp(argv[i], "--sync-every=", 13) == 0) {
+                sync_every = atoi(argv[i] + 13);
+                if (sync_every < 1) {
+                    fprintf(stderr, "Warning: Invalid sync interval '%s'. Syncing every batch.\n", argv[i] + 13);
+                    sync_every = 1;
+                }
+            } else if (strncmp(argv[i], "--checkpoint=", 13) == 0) {
+                checkpoint.path = argv[i] + 13;
+            } else if (strncmp(argv[i], "--checkpoint-every=", 19) == 0) {
+                checkpoint.every = atoi(argv[i] + 19);
+                if (checkpoint.every <= 0) {
+                    fprintf(stderr, "Warning: Invalid checkpoint interval '%s'. Using %d.\n", argv[i] + 19, CHECKPOINT_DEFAULT_EVERY);
+                    checkpoint.every = CHECKPOINT_DEFAULT_EVERY;
+                }
+            } else if (strncmp(argv[i], "--resume=", 9) == 0) {
+                resume_path = argv[i] + 9;
+            } else if (strcmp(argv[i], "--benchmark") == 0) {
+                benchmark = true;
+            } else if (strcmp(argv[i], "--metrics") == 0) {
+                metrics.enabled = true;
+            } else if (strncmp(argv[i], "--metrics=", 10) == 0) {
+                metrics.enabled = true;
+                metrics_path = argv[i] + 10;
+            } else if (strncmp(argv[i], "--deck=", 7) == 0) {
+                deck_path = argv[i] + 7;
+            } else if (strncmp(argv[i], "--sweep=", 8) == 0) {
+                sweep_spec = argv[i] + 8;
+            } else if (strcmp(argv[i], "--persistent=on") == 0) {
+                persistent = true;
+            } else if (strcmp(argv[i], "--persistent=off") == 0) {
+                persistent = false;
+            } else if (strncmp(argv[i], "--update-threads=", 17) == 0) {
+                update_threads = atoi(argv[i] + 17);
+                if (update_threads < 0 || update_threads > MAX_HOST_UPDATE_THREADS) {
+                    fprintf(stderr, "Warning: Invalid thread count '%s'. Using one per core.\n", argv[i] + 17);
+                    update_threads = 0;
+                }
+            } else {
+                fprintf(stderr, "Warning: Unknown option '%s' ignored.\n", argv[i]);
+            }
+            continue;
+        }
+        if (positional == 0 && convert_from) {
+            csv_filename = argv[i]; // Converter output
+            positional = 1; // No episode count in converter mode
+        } else if (positional == 0) {
+            num_episodes = atoi(argv[i]);
+            if (num_episodes <= 0) {
+                fprintf(stderr, "Warning: Invalid number of episodes specified. Using default %d.\n", 20000);
+                num_episodes = 20000;
+            }
+        } else if (positional == 1) {
+            csv_filename = argv[i];
         }
+        positional++;
+    }
+
+    if (update_threads == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        update_threads = cores < 1 ? 1 : (cores > MAX_HOST_UPDATE_THREADS ? MAX_HOST_UPDATE_THREADS : (int)cores);
     }
-    if (argc > 2) {
-        csv_filename = argv[2];
+    if (benchmark) {
+        if (!seed_given) seed = BENCHMARK_SEED;
+        if (!log_mode_given) log_sink.mode = LOG_MODE_OFF;
     }
 
-    // --- Initialization ---
-    srand(time(NULL)); // Seed random number generator
+    // --- Sweep ---
+    // A plain run is a sweep of its one config. With --sweep the episode count is per config and the
+    // configs take turns over the episode ids, so every batch trains all of them at full occupancy.
+    sweep_configs[0].epsilon = epsilon;
+    sweep_configs[0].start_money = start_money;
+    sweep_configs[0].go_reward = go_reward;
+    if (sweep_spec) {
+        num_configs = parse_sweep_configs(sweep_spec, sweep_configs);
+        if (num_configs == 0) return exit_failure();
+        if ((long long)num_episodes * num_configs > INT_MAX) {
+            fprintf(stderr, "Error: %d episodes for each of %d configs do not fit in one run.\n", num_episodes, num_configs);
+            return exit_failure();
+        }
+        num_episodes *= num_configs;
+        if (!device_update) {
+            fprintf(stderr, "Warning: --update=host trains a single config. Using --update=gpu.\n");
+            device_update = true;
+        }
+        if (checkpoint.path || resume_path) {
+            fprintf(stderr, "Warning: Checkpoints hold a single config. Ignoring --checkpoint and --resume.\n");
+            checkpoint.path = NULL;
+            resume_path = NULL;
+        }
+    }
 
-    MonopolyEnv* env = create_monopoly_env(num_players, start_money, go_reward);
-    MonteCarloAgent* agent = create_monte_carlo_agent(num_players, epsilon);
+    // --- Initialization ---
+    // The env carries the rules every config shares; its start money and GO reward are config 1's
+    MonopolyEnv* env = create_monopoly_env(num_players, sweep_configs[0].start_money, sweep_configs[0].go_reward);
+    MonteCarloAgent* agents[MAX_SWEEP_CONFIGS] = {NULL}; // One agent per config
+    bool agents_created = true;
+    for (int c = 0; c < num_configs; c++) {
+        agents[c] = create_monte_carlo_agent(num_players, sweep_configs[c].epsilon);
+        if (!agents[c]) agents_created = false;
+    }
+    MonteCarloAgent* agent = agents[0]; // Without --sweep, the run's agent
+    HostUpdatePool* host_update = create_host_update_pool(update_threads, num_players); // Threaded host update
 
-    if (!env || !agent) {
+    if (!env || !agents_created || !host_update) {
         fprintf(stderr, "Error: Failed to initialize environment or agent.\n");
+        destroy_host_update_pool(host_update);
         destroy_monopoly_env(env);
-        destroy_monte_carlo_agent(agent);
-        return 1;
+        destroy_sweep_agents(agents, num_configs);
+        return exit_failure();
     }
 
-    // --- Open CSV File ---
-    FILE* csv_file = fopen(csv_filename, "w");
-    if (!csv_file) {
-        fprintf(stderr, "Error: Could not open CSV file '%s' for writing: %s\n", csv_filename, strerror(errno));
+    if (deck_path && !load_card_decks(env, deck_path)) {
+        destroy_host_update_pool(host_update);
         destroy_monopoly_env(env);
-        destroy_monte_carlo_agent(agent);
-        return 1;
+        destroy_sweep_agents(agents, num_configs);
+        return exit_failure();
     }
-    printf("Opened '%s' for logging.\n", csv_filename);
-
-    // --- Write CSV Header ---
-    fprintf(csv_file, "episode_id,step,player,position_before,dice_roll,landed_on_position,position_after,money_before,money_after,reward,done,in_jail,fee_paid,agent_action,num_owned_properties,card_drawn,card_specific_desc,action_desc\n");
-    fflush(csv_file);
-
-    printf("Starting Parallel Monte Carlo Training for %d episodes...\n", num_episodes);
 
-    // --- CUDA Setup ---
-    cudaError_t cuda_status;
-
-
-
-    // Determine number of threads and blocks
-    int threads_per_block = THREADS_PER_BLOCK;
-    int num_blocks = (num_episodes + threads_per_block - 1) / threads_per_block;
-    if (num_blocks > MAX_BLOCKS) num_blocks = MAX_BLOCKS;
-
-    int episodes_per_batch = threads_per_block * num_blocks;
-    int num_batches = (num_episodes + episodes_per_batch - 1) / episodes_per_batch;
-
-    printf("CUDA Configuration: %d blocks, %d threads per block\n", num_blocks, threads_per_block);
-    printf("Processing in %d batches of up to %d episodes each\n", num_batches, episodes_per_batch);
-
-    // Allocate device memory for random states
-    curandState* d_rand_states;
-    cuda_status = cudaMalloc((void**)&d_rand_states, threads_per_block * num_blocks * sizeof(curandState));
-    if (cuda_status != cudaSuccess) {
-        fprintf(stderr, "CUDA Error: Failed to allocate device memory for random states: %s\n",
-                cudaGetErrorString(cuda_status));
-        fclose(csv_file);
+    // A binary log only stores card indices, so convert it with the --deck it was trained with
+    if (convert_from) {
+        int status = convert_binary_log(convert_from, csv_filename, env);
+        destroy_host_update_pool(host_update);
         destroy_monopoly_env(env);
-        destroy_monte_carlo_agent(agent);
-        return 1;
+        destroy_sweep_agents(agents, num_configs);
+        if (status != 0) return exit_failure();
+#ifdef MONOPOLY_USE_MPI
+        MPI_Finalize();
+#endif
+        return 0;
     }
 
-    // Initialize random states
-    init_rand_states<<<num_blocks, threads_per_block>>>(d_rand_states, time(NULL));
-
-    // Allocate device memory for property data
-    int* d_property_prices;
-    int* d_property_rents;
-    int* d_property_house_costs;
-
-    cuda_status = cudaMalloc((void**)&d_property_prices, BOARD_SIZE * sizeof(int));
-    if (cuda_status != cudaSuccess) {
-        fprintf(stderr, "CUDA Error: Failed to allocate device memory for property prices: %s\n",
-                cudaGetErrorString(cuda_status));
-        cudaFree(d_rand_states);
-        fclose(csv_file);
-        destroy_monopoly_env(env);
-        destroy_monte_carlo_agent(agent);
-        return 1;
+    // --- Resume ---
+    // The checkpoint supplies the Q-table, the seed and how far into the episode ids the run got. With
+    // several ranks every rank checkpoints its own slice to FILE.rankN, and its progress counts episodes
+    // of that slice, so it only resumes under the same split (validated below, once the split is known).
+    char rank_checkpoint_filename[1024], rank_resume_filename[1024];
+    if (mpi_size > 1 && checkpoint.path) {
+        snprintf(rank_checkpoint_filename, sizeof(rank_checkpoint_filename), "%s.rank%d", checkpoint.path, mpi_rank);
+        checkpoint.path = rank_checkpoint_filename;
+    }
+    if (mpi_size > 1 && resume_path) {
+        snprintf(rank_resume_filename, sizeof(rank_resume_filename), "%s.rank%d", resume_path, mpi_rank);
+        resume_path = rank_resume_filename;
+    }
+    long long resume_done = 0;
+    CheckpointSlice resume_slice = {1, 0, 0};
+    if (resume_path) {
+        if (!load_checkpoint(resume_path, agent->q_table, num_players, &seed, &resume_done, &resume_slice)) {
+            destroy_host_update_pool(host_update);
+            destroy_monopoly_env(env);
+            destroy_sweep_agents(agents, num_configs);
+            return exit_failure();
+        }
+        printf("Resumed from '%s' after %lld episodes (seed %llu, Q-Table size %d).\n",
+               resume_path, resume_done, seed, agent->q_table->count);
     }
 
-    cuda_status = cudaMalloc((void**)&d_property_rents, BOARD_SIZE * sizeof(int));
-    if (cuda_status != cudaSuccess) {
-        fprintf(stderr, "CUDA Error: Failed to allocate device memory for property rents: %s\n",
-                cudaGetErrorString(cuda_status));
-        cudaFree(d_property_prices);
-        cudaFree(d_rand_states);
-        fclose(csv_file);
+    // --- Multi-Node Split ---
+    // Each rank trains its own slice of the episode ids with the same seed and writes its own log
+    int episode_base = 0;
+    char rank_log_filename[1024], rank_metrics_filename[1024];
+    if (mpi_size > 1) {
+#ifdef MONOPOLY_USE_MPI
+        MPI_Bcast(&seed, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+#endif
+        episode_base = (int)((long long)num_episodes * mpi_rank / mpi_size);
+        num_episodes = (int)((long long)num_episodes * (mpi_rank + 1) / mpi_size) - episode_base;
+        snprintf(rank_log_filename, sizeof(rank_log_filename), "%s.rank%d", csv_filename, mpi_rank);
+        csv_filename = rank_log_filename;
+        if (metrics_path) {
+            snprintf(rank_metrics_filename, sizeof(rank_metrics_filename), "%s.rank%d", metrics_path, mpi_rank);
+            metrics_path = rank_metrics_filename;
+        }
+        if (!device_update) {
+            fprintf(stderr, "Warning: --update=host is not synced across ranks. Using --update=gpu.\n");
+            device_update = true;
+        }
+        printf("Rank %d/%d: episodes %d-%d\n", mpi_rank, mpi_size, episode_base + 1, episode_base + num_episodes);
+        checkpoint.slice.ranks = mpi_size;
+        checkpoint.slice.base = episode_base;
+        checkpoint.slice.episodes = num_episodes;
+    }
+    if (resume_path && (resume_slice.ranks != checkpoint.slice.ranks ||
+                        (mpi_size > 1 && (resume_slice.base != episode_base || resume_slice.episodes != num_episodes)))) {
+        fprintf(stderr, "Error: Checkpoint '%s' was saved by a %d-rank run (episodes %lld-%lld here), not this "
+                "rank's %d-%d of %d. Resume with the episode and rank counts it was trained with.\n",
+                resume_path, resume_slice.ranks, resume_slice.base + 1, resume_slice.base + resume_slice.episodes,
+                episode_base + 1, episode_base + num_episodes, mpi_size);
+        destroy_host_update_pool(host_update);
         destroy_monopoly_env(env);
-        destroy_monte_carlo_agent(agent);
-        return 1;
+        destroy_sweep_agents(agents, num_configs);
+        return exit_failure();
     }
-
-    cuda_status = cudaMalloc((void**)&d_property_house_costs, BOARD_SIZE * sizeof(int));
-    if (cuda_status != cudaSuccess) {
-        fprintf(stderr, "CUDA Error: Failed to allocate device memory for property house costs: %s\n",
-                cudaGetErrorString(cuda_status));
-        cudaFree(d_property_rents);
-        cudaFree(d_property_prices);
-        cudaFree(d_rand_states);
-        fclose(csv_file);
+    // A resumed run only plays the rest of its (slice of the) episode ids. Whether anything is left is
+    // decided over all ranks: one that is done still joins the syncs of the others.
+    if (resume_done > num_episodes) resume_done = num_episodes;
+    episode_base += (int)resume_done;
+    num_episodes -= (int)resume_done;
+    int episodes_left = num_episodes;
+#ifdef MONOPOLY_USE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, &episodes_left, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+    if (episodes_left == 0) {
+        printf("Checkpoint already covers every episode; nothing left to train.\n");
+        destroy_host_update_pool(host_update);
         destroy_monopoly_env(env);
-        destroy_monte_carlo_agent(agent);
-        return 1;
+        destroy_sweep_agents(agents, num_configs);
+#ifdef MONOPOLY_USE_MPI
+        MPI_Finalize();
+#endif
+        return 0;
+    }
+    checkpoint.seed = seed;
+
+    // --- Open Log File ---
+    if (log_sink.mode != LOG_MODE_OFF) {
+        if (!log_sink_open(&log_sink, csv_filename)) {
+            fprintf(stderr, "Error: Could not open log file '%s' for writing: %s\n", csv_filename, strerror(errno));
+            destroy_host_update_pool(host_update);
+            destroy_monopoly_env(env);
+            destroy_sweep_agents(agents, num_configs);
+            return exit_failure();
+        }
+        printf("Opened '%s' for %s logging", csv_filename, log_sink.mode == LOG_MODE_BIN ? "binary" : "CSV");
+        if (log_sink.sample_every > 1) printf(" (every %d episodes)", log_sink.sample_every);
+        printf(".\n");
+    } else {
+        printf("Logging disabled; training with the event-free kernel.\n");
     }
 
-    // Copy property data to device
-    int h_property_prices[BOARD_SIZE] = {0};
-    int h_property_rents[BOARD_SIZE] = {0};
-    int h_property_house_costs[BOARD_SIZE] = {0};
+    seed_monopoly_env(env, seed);
+    printf("Starting Parallel Monte Carlo Training for %d episodes (seed %llu)...\n", num_episodes, seed);
+    if (sweep_spec) printf("Sweeping %d configs, every batch trains all of them\n", num_configs);
 
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        h_property_prices[i] = env->properties[i].price;
-        h_property_rents[i] = env->properties[i].rent;
-        h_property_house_costs[i] = env->properties[i].house_cost;
-    }
+    // --- CUDA Setup ---
+    cudaError_t cuda_status;
 
-    cudaMemcpy(d_property_prices, h_property_prices, BOARD_SIZE * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_property_rents, h_property_rents, BOARD_SIZE * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_property_house_costs, h_property_house_costs, BOARD_SIZE * sizeof(int), cudaMemcpyHostToDevice);
 
-    // Allocate host and device memory for episode data
-    CUDAEpisodeData* h_episode_data = (CUDAEpisodeData*)malloc(episodes_per_batch * sizeof(CUDAEpisodeData));
-    CUDAEpisodeData* d_episode_data;
 
-    cuda_status = cudaMalloc((void**)&d_episode_data, episodes_per_batch * sizeof(CUDAEpisodeData));
-    if (cuda_status != cudaSuccess) {
-        fprintf(stderr, "CUDA Error: Failed to allocate device memory for episode data: %s\n",
-                cudaGetErrorString(cuda_status));
-        cudaFree(d_property_house_costs);
-        cudaFree(d_property_rents);
-        cudaFree(d_property_prices);
-        cudaFree(d_rand_states);
-        free(h_episode_data);
-        fclose(csv_file);
+    // Pick the GPUs: --gpus=N consecutive visible devices (--gpus=all: every device, split between the
+    // ranks sharing a node). MPI ranks on one node start at different devices.
+    int device_count = 0;
+    cuda_status = cudaGetDeviceCount(&device_count);
+    if (cuda_status != cudaSuccess || device_count <= 0) {
+        fprintf(stderr, "CUDA Error: Failed to find a CUDA device: %s\n", cudaGetErrorString(cuda_status));
+        log_sink_close(&log_sink);
+        destroy_host_update_pool(host_update);
         destroy_monopoly_env(env);
-        destroy_monte_carlo_agent(agent);
-        return 1;
+        destroy_sweep_agents(agents, num_configs);
+        return exit_failure();
+    }
+    int local_rank = 0, local_size = 1;
+#ifdef MONOPOLY_USE_MPI
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, mpi_rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &local_rank);
+    MPI_Comm_size(node_comm, &local_size);
+    MPI_Comm_free(&node_comm);
+#endif
+    if (num_gpus == 0) num_gpus = (device_count / local_size > 0) ? device_count / local_size : 1;
+    if (num_gpus > device_count) num_gpus = device_count;
+    int devices[MAX_GPUS];
+    for (int g = 0; g < num_gpus; g++) devices[g] = (local_rank * num_gpus + g) % device_count;
+
+    // Determine launch shape per device (persistent lanes pull the batch's episodes); batches have the
+    // size the smallest device can hold
+    bool log_enabled = log_sink.mode != LOG_MODE_OFF;
+    bool need_host_episodes = log_enabled || !device_update;
+    SimulateKernel sim_kernel = select_simulate_kernel(env, log_enabled); // Event codes only when they will be logged
+    SimulateKernel train_kernel = select_simulate_kernel(env, false);    // Reported by the kernel analysis
+    LaunchPlan plans[MAX_GPUS];
+    int plan_episodes = num_episodes > 0 ? num_episodes : 1; // A rank with nothing left plans no batches
+    int episodes_per_batch = plan_episodes;
+    for (int g = 0; g < num_gpus; g++) {
+        plans[g] = plan_launch(devices[g], plan_episodes, num_slots, persistent, sim_kernel, need_host_episodes, batch_episodes,
+                               num_configs);
+        if (plans[g].episodes_per_batch < episodes_per_batch) episodes_per_batch = plans[g].episodes_per_batch;
+    }
+    if (episodes_per_batch <= 0) {
+        fprintf(stderr, "Error: Not enough device memory for a batch of episodes.\n");
+        log_sink_close(&log_sink);
+        destroy_host_update_pool(host_update);
+        destroy_monopoly_env(env);
+        destroy_sweep_agents(agents, num_configs);
+        return exit_failure();
+    }
+
+    // Batches stream through the reused slots of every GPU, so any number of episodes can be trained.
+    // Slot s lives on GPU s % num_gpus and batch b uses slot b % total_slots, dealing batches round-robin.
+    int num_batches = (num_episodes + episodes_per_batch - 1) / episodes_per_batch;
+    int total_slots = num_slots * num_gpus;
+    if (total_slots > num_batches) total_slots = num_batches;
+
+    // Policy lag: a batch is launched with the policy of every batch finished before it, so it misses
+    // the ones still in flight, at most total_slots - 1 (num_slots * num_gpus - 1; across nodes the
+    // policy also waits for the next all-reduce, up to sync_every - 1 more batches per rank).
+    // --max-policy-lag=N caps the batches in flight at N + 1, trading overlap for fresher policies.
+    int max_in_flight = total_slots;
+    if (max_policy_lag >= 0 && max_policy_lag + 1 < max_in_flight) max_in_flight = max_policy_lag + 1;
+
+    for (int g = 0; g < num_gpus; g++) {
+        printf("CUDA Configuration: GPU %d, %d blocks, %d threads per block (%s)\n", devices[g], plans[g].lane_blocks,
+               plans[g].threads_per_block, persistent ? "persistent lanes" : "one lane per episode");
+    }
+    if (specialized_players(env) > 0) {
+        printf("Simulation kernel: specialized for %d players and the standard rules\n", specialized_players(env));
+    } else {
+        printf("Simulation kernel: generic\n");
+    }
+    printf("Processing in %d batches of up to %d episodes each (%d in flight on %d GPU%s, policy lag up to %d batch%s)\n",
+           num_batches, episodes_per_batch, max_in_flight, num_gpus, num_gpus > 1 ? "s" : "",
+           max_in_flight - 1, max_in_flight == 2 ? "" : "es");
+
+    // Allocate one set of stream, device and pinned host buffers per in-flight batch
+    BatchSlot slots[MAX_GPUS * MAX_PIPELINE_SLOTS];
+    memset(slots, 0, sizeof(slots));
+    size_t slot_device_bytes = 0;
+    for (int s = 0; s < total_slots; s++) {
+        int g = s % num_gpus;
+        int lane_blocks = (episodes_per_batch + plans[g].threads_per_block - 1) / plans[g].threads_per_block;
+        if (lane_blocks > plans[g].lane_blocks) lane_blocks = plans[g].lane_blocks;
+        cuda_status = create_batch_slot(&slots[s], devices[g], plans[g].threads_per_block, lane_blocks,
+                                        episodes_per_batch, need_host_episodes, metrics.enabled, env, sweep_configs, num_configs);
+        if (cuda_status != cudaSuccess) {
+            fprintf(stderr, "CUDA Error: Failed to allocate buffers for pipeline slot %d on GPU %d: %s\n",
+                    s, devices[g], cudaGetErrorString(cuda_status));
+            for (int k = 0; k <= s; k++) destroy_batch_slot(&slots[k]);
+            log_sink_close(&log_sink);
+            destroy_host_update_pool(host_update);
+            destroy_monopoly_env(env);
+            destroy_sweep_agents(agents, num_configs);
+            return exit_failure();
+        }
+        slot_device_bytes += batch_slot_device_bytes(lane_blocks * plans[g].threads_per_block, episodes_per_batch, num_configs)
+                           + 3 * BOARD_SIZE * sizeof(int);
+    }
+    long peak_device_kb = peak_device_memory_kb(devices, num_gpus);
+
+    // Multi-node: deltas wait here between all-reduces; every rank joins as many syncs as the rank
+    // with the most batches needs
+    size_t q_delta_slots = (size_t)num_configs * Q_DELTA_SLOTS;
+    SweepResult sweep_results[MAX_SWEEP_CONFIGS];
+    memset(sweep_results, 0, sizeof(sweep_results));
+    double* pending_q_sum = NULL;
+    double* pending_q_sum_sq = NULL;
+    unsigned int* pending_q_count = NULL;
+    int sync_rounds = 0, sync_rounds_done = 0;
+    if (mpi_size > 1) {
+        int max_batches = num_batches;
+#ifdef MONOPOLY_USE_MPI
+        MPI_Allreduce(&num_batches, &max_batches, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+        sync_rounds = (max_batches + sync_every - 1) / sync_every;
+        pending_q_sum = (double*)calloc(q_delta_slots, sizeof(double));
+        pending_q_sum_sq = (double*)calloc(q_delta_slots, sizeof(double));
+        pending_q_count = (unsigned int*)calloc(q_delta_slots, sizeof(unsigned int));
+        if (!pending_q_sum || !pending_q_sum_sq || !pending_q_count) {
+            fprintf(stderr, "Error: Failed to allocate Q-statistic sync buffers.\n");
+            free(pending_q_sum);
+            free(pending_q_sum_sq);
+            free(pending_q_count);
+            for (int k = 0; k < total_slots; k++) destroy_batch_slot(&slots[k]);
+            log_sink_close(&log_sink);
+            destroy_host_update_pool(host_update);
+            destroy_monopoly_env(env);
+            destroy_sweep_agents(agents, num_configs);
+            return exit_failure();
+        }
     }
 
     // --- Training Loop ---
+    // Up to max_in_flight batches are in flight: while the host learns from and logs the oldest batch,
+    // the GPUs already simulate the next ones. Each batch is launched with the policy learned from
+    // every batch that finished before it (so it lags by up to max_in_flight - 1 batches, see above).
+    // The host agent is where the GPUs' per-batch sum/count deltas meet.
+    cudaSetDevice(devices[0]);
     cudaEventCreate(&start);
     cudaEventCreate(&stop);
     cudaEventRecord(start);
-    for (int batch = 0; batch < num_batches; batch++) {
-        int batch_offset = batch * episodes_per_batch;
-        int batch_size = (batch == num_batches - 1 && num_episodes % episodes_per_batch != 0)
-                        ? num_episodes % episodes_per_batch
-                        : episodes_per_batch;
-
-        // Calculate actual blocks needed for this batch
-        int batch_blocks = (batch_size + threads_per_block - 1) / threads_per_block;
-
-        printf("Processing batch %d/%d: Episodes %d-%d\n",
-               batch + 1, num_batches, batch_offset + 1, batch_offset + batch_size);
-
-        // Launch kernel to simulate episodes in parallel
-        simulate_episodes_kernel<<<batch_blocks, threads_per_block>>>(
-            d_rand_states,
-            num_players,
-            start_money,
-            go_reward,
-            BOARD_SIZE,
-            env->jail_position,
-            env->go_to_jail_position,
-            env->jail_turns,
-            d_property_prices,
-            d_property_rents,
-            d_property_house_costs,
-            epsilon,
-            d_episode_data,
-            batch_offset
-        );
-
-        // Check for kernel launch errors
-        cuda_status = cudaGetLastError();
+    int batches_launched = 0;
+    int batches_done = 0;
+    long long episodes_done = resume_done; // Episodes simulated so far (of this rank's slice)
+    long long episodes_merged = resume_done; // Episodes whose statistics the agent holds, i.e. what a checkpoint covers
+    RunStats stats;
+    memset(&stats, 0, sizeof(stats));
+    metrics_report_open(&metrics, metrics_path);
+    while (batches_done < batches_launched || batches_launched < num_batches) {
+        // --- Enqueue batches while a slot is free ---
+        while (batches_launched < num_batches && batches_launched - batches_done < max_in_flight) {
+            BatchSlot* slot = &slots[batches_launched % total_slots];
+            slot->batch_offset = episode_base + batches_launched * episodes_per_batch;
+            slot->batch_size = (batches_launched == num_batches - 1 && num_episodes % episodes_per_batch != 0)
+                            ? num_episodes % episodes_per_batch
+                            : episodes_per_batch;
+
+            // Lanes for this batch (a short last batch needs fewer)
+            int threads_per_block = slot->threads_per_block;
+            int batch_blocks = (slot->batch_size + threads_per_block - 1) / threads_per_block;
+            if (batch_blocks > slot->lane_blocks) batch_blocks = slot->lane_blocks;
+            slot->batch_blocks = batch_blocks;
+            cudaSetDevice(slot->device);
+
+            printf("Processing batch %d/%d: Episodes %d-%d\n",
+                   batches_launched + 1, num_batches, slot->batch_offset + 1, slot->batch_offset + slot->batch_size);
+
+            // Upload each config's current greedy policy so the kernel exploits what has been learned so far
+            for (int c = 0; c < num_configs; c++) {
+                build_greedy_action_table(agents[c], slot->h_greedy_actions + (size_t)c * Q_NUM_STATES);
+            }
+            cudaEventRecord(slot->ev_start, slot->stream);
+            cudaMemcpyAsync(slot->d_greedy_actions, slot->h_greedy_actions, (size_t)num_configs * Q_NUM_STATES,
+                            cudaMemcpyHostToDevice, slot->stream);
+
+            // Launch kernel to simulate episodes in parallel (event codes only when they will be logged)
+            cudaMemsetAsync(slot->d_work_counter, 0, sizeof(unsigned int), slot->stream);
+            cudaMemsetAsync(slot->d_step_counter, 0, sizeof(unsigned long long), slot->stream);
+            cudaEventRecord(slot->ev_uploaded, slot->stream);
+            sim_kernel<<<batch_blocks, threads_per_block, 0, slot->stream>>>(
+                seed, num_players, BOARD_SIZE,
+                env->jail_position, env->go_to_jail_position, env->jail_turns,
+                num_configs, slot->d_greedy_actions, slot->d_batch_state, slot->d_episode_data, slot->batch_offset,
+                slot->batch_size, slot->d_work_counter, slot->d_step_counter, slot->d_block_counters
+            );
+
+            cudaEventRecord(slot->ev_simulated, slot->stream);
+
+            // Compute returns and first-visit sums on the device; only the aggregated deltas come back
+            if (device_update) {
+                mc_update_kernel<<<slot->batch_size, MC_UPDATE_THREADS, 0, slot->stream>>>(
+                    slot->d_episode_data, num_configs, slot->d_q_sum, slot->d_q_sum_sq, slot->d_q_count);
+            }
+            cudaEventRecord(slot->ev_updated, slot->stream);
+            if (device_update) {
+                cudaMemcpyAsync(slot->h_q_sum, slot->d_q_sum, q_delta_slots * sizeof(double), cudaMemcpyDeviceToHost, slot->stream);
+                cudaMemcpyAsync(slot->h_q_sum_sq, slot->d_q_sum_sq, q_delta_slots * sizeof(double), cudaMemcpyDeviceToHost, slot->stream);
+                cudaMemcpyAsync(slot->h_q_count, slot->d_q_count, q_delta_slots * sizeof(unsigned int), cudaMemcpyDeviceToHost, slot->stream);
+                cudaMemsetAsync(slot->d_q_sum, 0, q_delta_slots * sizeof(double), slot->stream);
+                cudaMemsetAsync(slot->d_q_sum_sq, 0, q_delta_slots * sizeof(double), slot->stream);
+                cudaMemsetAsync(slot->d_q_count, 0, q_delta_slots * sizeof(unsigned int), slot->stream);
+            }
+
+            // Copy episode data back to host (only needed for the host update or the log)
+            if (need_host_episodes) {
+                cudaMemcpyAsync(slot->h_episode_data, slot->d_episode_data, slot->batch_size * sizeof(CUDAEpisodeData),
+                                cudaMemcpyDeviceToHost, slot->stream);
+            }
+            cudaMemcpyAsync(slot->h_step_counter, slot->d_step_counter, sizeof(unsigned long long), cudaMemcpyDeviceToHost, slot->stream);
+            if (metrics.enabled) {
+                cudaMemcpyAsync(slot->h_block_counters, slot->d_block_counters, batch_blocks * sizeof(KernelCounters),
+                                cudaMemcpyDeviceToHost, slot->stream);
+            }
+            cudaEventRecord(slot->ev_done, slot->stream);
+
+            // Check for kernel launch errors
+            cuda_status = cudaGetLastError();
+            if (cuda_status != cudaSuccess) break;
+            batches_launched++;
+        }
         if (cuda_status != cudaSuccess) {
             fprintf(stderr, "CUDA Error: Failed to launch kernel: %s\n", cudaGetErrorString(cuda_status));
             break;
         }
 
-        // Wait for kernel to complete
-        cudaDeviceSynchronize();
+        // --- Host phase for the oldest in-flight batch ---
+        BatchSlot* slot = &slots[batches_done % total_slots];
+        cudaSetDevice(slot->device);
+        cuda_status = cudaStreamSynchronize(slot->stream);
+        if (cuda_status != cudaSuccess) {
+            fprintf(stderr, "CUDA Error: Batch %d failed: %s\n", batches_done + 1, cudaGetErrorString(cuda_status));
+            break;
+        }
 
-        // Copy episode data back to host
-        cudaMemcpy(h_episode_data, d_episode_data, batch_size * sizeof(CUDAEpisodeData), cudaMemcpyDeviceToHost);
+        RunStats batch_stats;
+        memset(&batch_stats, 0, sizeof(batch_stats));
+        add_batch_timing(&batch_stats, slot);
 
         // Update Q-table from episode data
-        update_q_table_from_cuda_episodes(agent, h_episode_data, batch_size);
-
-        // Write logs to CSV
-        for (int i = 0; i < batch_size; i++) {
-            CUDAEpisodeData* episode = &h_episode_data[i];
-            if (episode->log_count > 0) {
-                //printf("Writing logs for episode %d (log count: %d)\n", episode->episode_id, episode->log_count);
-                for (int j = 0; j < episode->log_count; j++) {
-                    write_log_to_csv(csv_file, &episode->logs[j]);
+        double update_start = wall_clock_ms();
+        long long merged_before = episodes_merged;
+        episodes_done += slot->batch_size;
+        if (device_update && mpi_size > 1) {
+            accumulate_q_deltas(pending_q_sum, pending_q_sum_sq, pending_q_count, slot->h_q_sum, slot->h_q_sum_sq,
+                                slot->h_q_count, q_delta_slots);
+            if ((batches_done + 1) % sync_every == 0 || batches_done + 1 == num_batches) {
+                allreduce_q_deltas(agents, sweep_results, num_configs, pending_q_sum, pending_q_sum_sq, pending_q_count);
+                sync_rounds_done++;
+                episodes_merged = episodes_done;
+            }
+        } else if (device_update) {
+            merge_sweep_deltas(agents, sweep_results, num_configs, slot->h_q_sum, slot->h_q_sum_sq, slot->h_q_count);
+            episodes_merged = episodes_done;
+        } else {
+            update_q_table_from_cuda_episodes(agent, slot->h_episode_data, slot->batch_size, host_update);
+            episodes_merged = episodes_done;
+        }
+        batch_stats.update_ms += wall_clock_ms() - update_start;
+        checkpoint_progress(&checkpoint, agent, merged_before, episodes_merged, false);
+
+        // Write the sampled episodes to the log
+        if (log_enabled) {
+            double log_start = wall_clock_ms();
+            for (int i = 0; i < slot->batch_size; i++) {
+                if (log_sink_wants(&log_sink, slot->h_episode_data[i].episode_id)) {
+                    log_sink_write_episode(&log_sink, &slot->h_episode_data[i], env);
                 }
             }
+            batch_stats.log_ms += wall_clock_ms() - log_start;
         }
 
-        // Flush CSV file after each batch
-        if (fflush(csv_file) != 0) {
-            fprintf(stderr, "Warning: Error flushing CSV file: %s\n", strerror(errno));
+        batches_done++;
+        if (sweep_spec) {
+            int sweep_states = 0;
+            for (int c = 0; c < num_configs; c++) sweep_states += agents[c]->q_table->count;
+            printf("Batch %d completed. Q-Table sizes: %d over %d configs\n", batches_done, sweep_states, num_configs);
+        } else {
+            printf("Batch %d completed. Q-Table size: %d\n", batches_done, agent->q_table->count);
         }
+        report_batch_metrics(&metrics, batches_done, slot, &batch_stats);
+        add_run_stats(&stats, &batch_stats);
+    }
 
-        printf("Batch %d completed. Q-Table size: %d\n", batch + 1, agent->q_table->count);
+    // Ranks that ran out of batches keep joining the syncs the others still need
+    if (mpi_size > 1) {
+#ifdef MONOPOLY_USE_MPI
+        if (cuda_status != cudaSuccess) MPI_Abort(MPI_COMM_WORLD, 1); // The other ranks would wait forever
+#endif
+        while (sync_rounds_done < sync_rounds) {
+            allreduce_q_deltas(agents, sweep_results, num_configs, pending_q_sum, pending_q_sum_sq, pending_q_count);
+            sync_rounds_done++;
+        }
+        free(pending_q_sum);
+        free(pending_q_sum_sq);
+        free(pending_q_count);
+    }
+    if (cuda_status == cudaSuccess) {
+        checkpoint_progress(&checkpoint, agent, episodes_merged, episodes_done, true); // Includes the other ranks' last syncs
     }
 
     // Stop timer
+    cudaSetDevice(devices[0]);
     cudaEventRecord(stop);
     cudaEventSynchronize(stop);
     cudaEventElapsedTime(&gpu_milliseconds, start, stop);
@@ -2160,27 +4190,35 @@ int main(int argc, char *argv[]) {
 
 
     printf("Training finished.\n");
+    print_run_stats(num_gpus, seed, &stats, gpu_milliseconds, peak_device_kb, benchmark);
+    if (sweep_spec) {
+        report_sweep_results(sweep_configs, agents, sweep_results, num_configs);
+    } else {
+        int compared = 0, separated = 0;
+        q_table_convergence(agent->q_table, &compared, &separated);
+        printf("Q-value convergence: buy and pass differ at 95%% confidence in %d of %d states with both actions tried\n",
+               separated, compared);
+    }
+    metrics_report_close(&metrics);
 
     // --- Clean up CUDA resources ---
-    cudaFree(d_episode_data);
-    cudaFree(d_property_house_costs);
-    cudaFree(d_property_rents);
-    cudaFree(d_property_prices);
-    cudaFree(d_rand_states);
-    free(h_episode_data);
-
-    // --- Close CSV File ---
-    if (fclose(csv_file) != 0) {
-         fprintf(stderr, "Warning: Error closing CSV file '%s': %s\n", csv_filename, strerror(errno));
-    } else {
-        printf("Log saved to '%s'.\n", csv_filename);
+    for (int s = 0; s < total_slots; s++) destroy_batch_slot(&slots[s]);
+
+    // --- Close Log File ---
+    if (log_enabled) {
+        if (log_sink_close(&log_sink) != 0) {
+             fprintf(stderr, "Warning: Error closing log file '%s': %s\n", csv_filename, strerror(errno));
+        } else {
+            printf("Log saved to '%s'.\n", csv_filename);
+        }
     }
 
 
 
     // --- Clean up ---
     printf("\nCleaning up...\n");
-    destroy_monte_carlo_agent(agent);
+    destroy_host_update_pool(host_update);
+    destroy_sweep_agents(agents, num_configs);
     destroy_monopoly_env(env);
 
     printf("Done.\n");
@@ -2188,13 +4226,12 @@ int main(int argc, char *argv[]) {
     size_t total_flops = 0;
     size_t total_bytes = 0;
 
-    // Example: Estimate for each episode
-    // (You should refine these numbers based on your kernel's actual operations)
+    // Per-step costs are rough; the step count is the one the kernels measured, not MAX_EPISODE_STEPS per episode
     int flops_per_step = 7;
-    int bytes_per_step = sizeof(CUDAEnvState) + sizeof(CUDAEpisodeData); // rough estimate
+    int bytes_per_step = CUDA_BATCH_STATE_BYTES_PER_LANE + sizeof(StepRecord); // rough estimate
 
-    total_flops = (size_t)num_episodes * MAX_EPISODE_STEPS * flops_per_step;
-    total_bytes = (size_t)num_episodes * MAX_EPISODE_STEPS * bytes_per_step;
+    total_flops = (size_t)stats.steps * flops_per_step;
+    total_bytes = (size_t)stats.steps * bytes_per_step;
 
     printf("\nEstimated FLOPs: %zu\n", total_flops);
     printf("Estimated Bytes: %zu\n", total_bytes);
@@ -2206,7 +4243,7 @@ int main(int argc, char *argv[]) {
     int minGridSize = 0, blockSize = 0;
     cudaOccupancyMaxPotentialBlockSize(
         &minGridSize, &blockSize,
-        (void*)simulate_episodes_kernel, // kernel pointer
+        train_kernel, // kernel pointer
         0, // dynamic shared memory per block
         0  // block size limit
     );
@@ -2218,12 +4255,13 @@ int main(int argc, char *argv[]) {
 
     // Global memory usage (main allocations)
     size_t global_mem_usage = 0;
-    global_mem_usage += threads_per_block * num_blocks * sizeof(curandState); // d_rand_states
-    global_mem_usage += BOARD_SIZE * sizeof(int) * 3; // d_property_prices, d_property_rents, d_property_house_costs
-    global_mem_usage += episodes_per_batch * sizeof(CUDAEpisodeData); // d_episode_data
+    global_mem_usage += slot_device_bytes; // Per-slot buffers (the board and card tables are in constant memory)
 
     printf("Global memory used by kernel: %zu bytes\n", global_mem_usage);
     printf("----------------------");
-    report_occupancy();
+    for (int g = 0; g < num_gpus; g++) report_occupancy(devices[g], train_kernel);
+#ifdef MONOPOLY_USE_MPI
+    MPI_Finalize();
+#endif
     return 0;
 }
\ No newline at end of file
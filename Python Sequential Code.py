@@ -4,6 +4,7 @@ import pandas as pd
 import matplotlib.pyplot as plt
 import csv
 import os
+import ctypes
 import gym
 from gym import spaces
 import numpy as np
@@ -570,6 +571,73 @@ class MonopolyEnv(gym.Env):
         print(f"          [{' '.join(owners_str[30:40])}]")
 
 
+# --- C Engine Vector Environment ---
+class CMonopolyVecEnv:
+    """Many games of the C engine stepped per call (see monopoly_vec_env_create in "C Sequential Code.c").
+
+    Build the library first:
+        gcc -O2 -shared -fPIC -DMONOPOLY_LIBRARY monopoly.c -o libmonopoly.so -lm -pthread
+    reset() and step() write into caller-provided NumPy buffers (make_buffers() allocates matching ones),
+    so no Python objects or copies are made per step. Observations use the C get_observation layout:
+    positions, money, in_jail, 40 property owners and the player who just moved. A finished game
+    restarts immediately and its row of obs then holds the new game's first observation.
+    """
+
+    def __init__(self, num_envs, num_players=2, start_money=1500, go_reward=200, seed=0, lib_path="./libmonopoly.so"):
+        lib = ctypes.CDLL(lib_path)
+        int_p = ctypes.POINTER(ctypes.c_int)
+        lib.monopoly_vec_env_create.restype = ctypes.c_void_p
+        lib.monopoly_vec_env_create.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_ulonglong]
+        lib.monopoly_vec_env_destroy.argtypes = [ctypes.c_void_p]
+        lib.monopoly_vec_env_obs_size.restype = ctypes.c_int
+        lib.monopoly_vec_env_obs_size.argtypes = [ctypes.c_void_p]
+        lib.monopoly_vec_env_reset.argtypes = [ctypes.c_void_p, int_p]
+        lib.monopoly_vec_env_step.argtypes = [ctypes.c_void_p, int_p, int_p,
+                                              ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_ubyte)]
+        self._lib = lib
+        self._handle = lib.monopoly_vec_env_create(num_envs, num_players, start_money, go_reward, seed)
+        if not self._handle:
+            raise RuntimeError(f"Could not create {num_envs} C environments with {num_players} players")
+        self.num_envs = num_envs
+        self.num_players = num_players
+        self.obs_size = lib.monopoly_vec_env_obs_size(self._handle)
+
+    def make_buffers(self):
+        """Returns (obs, rewards, dones) arrays laid out the way reset() and step() expect."""
+        obs = np.zeros((self.num_envs, self.obs_size), dtype=np.int32)
+        rewards = np.zeros(self.num_envs, dtype=np.float64)
+        dones = np.zeros(self.num_envs, dtype=np.uint8)
+        return obs, rewards, dones
+
+    def _pointer(self, array, dtype, shape, ctype):
+        # The C side writes through the pointer, so the buffer must already have the exact layout
+        if array.dtype != dtype or array.shape != shape or not array.flags['C_CONTIGUOUS']:
+            raise ValueError(f"Expected a C-contiguous {np.dtype(dtype).name} array of shape {shape}, got {array.dtype} {array.shape}")
+        return array.ctypes.data_as(ctypes.POINTER(ctype))
+
+    def reset(self, obs):
+        """Starts a new game in every env and fills obs (num_envs x obs_size int32)."""
+        self._lib.monopoly_vec_env_reset(self._handle, self._pointer(obs, np.int32, (self.num_envs, self.obs_size), ctypes.c_int))
+        return obs
+
+    def step(self, actions, obs, rewards, dones):
+        """Plays one turn per env with actions (num_envs int32, 0 = Pass, 1 = Buy) and fills obs, rewards and dones."""
+        self._lib.monopoly_vec_env_step(self._handle,
+                                        self._pointer(actions, np.int32, (self.num_envs,), ctypes.c_int),
+                                        self._pointer(obs, np.int32, (self.num_envs, self.obs_size), ctypes.c_int),
+                                        self._pointer(rewards, np.float64, (self.num_envs,), ctypes.c_double),
+                                        self._pointer(dones, np.uint8, (self.num_envs,), ctypes.c_ubyte))
+        return obs, rewards, dones
+
+    def close(self):
+        if self._handle:
+            self._lib.monopoly_vec_env_destroy(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        self.close()
+
+
 # --- Agent Class ---
 class MonteCarloAgent:
     def __init__(self, action_space, num_players, epsilon=0.1): # Added num_players parameter